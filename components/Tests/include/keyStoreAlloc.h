@@ -0,0 +1,34 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreAlloc.h
+ *
+ * @brief counts the calls of the allocator, so tests can check that code does
+ *        not allocate
+ *
+ * The calls are counted by keyStoreAllocWrap.c, which the linker puts in
+ * front of malloc(), calloc() and realloc(), including the calls of the SDK
+ * libraries (see keyStoreTrace.cmake). It is only linked with the build
+ * option KEYSTORE_COUNT_ALLOCS, which sets KeyStoreAlloc_Config_ENABLED;
+ * without it, this function does not exist.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * Returns the number of calls of malloc(), calloc() and realloc() so far.
+ */
+size_t
+KeyStoreAlloc_getCount(
+    void);
+
+///@}
@@ -0,0 +1,64 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreBenchmark.h
+ *
+ * @brief helpers to take timings of keystore operations and report them
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint64_t KeyStoreBenchmark_Cycles_t;
+
+// Starts every line of JSON output, see KeyStoreBenchmark_Config_JSON_OUTPUT
+#define KeyStoreBenchmark_JSON_TAG  "KEYSTORE_BENCHMARK"
+
+/**
+ * Initializes the cycle counter, must be called once before any timing is
+ * taken.
+ */
+void
+KeyStoreBenchmark_init(
+    void);
+
+/**
+ * Returns the current value of the cycle counter.
+ */
+KeyStoreBenchmark_Cycles_t
+KeyStoreBenchmark_getCycles(
+    void);
+
+/**
+ * Reports the result of a benchmark run on the log.
+ *
+ * With KeyStoreBenchmark_Config_JSON_OUTPUT set in the system configuration,
+ * the result is printed as a single line consisting of
+ * KeyStoreBenchmark_JSON_TAG and a JSON object with the fields "op",
+ * "backend", "keySize", "count", "cycles" and "cyclesPerOp". The op and
+ * backend names are not escaped and must not contain quotes.
+ *
+ * @param[in]   op          Name of the measured operation
+ * @param[in]   backend     Name of the keystore backend (e.g. "File")
+ * @param[in]   keySize     Size of the key data used in the measurement
+ * @param[in]   count       Number of operations that were measured
+ * @param[in]   cycles      Cycles taken by all operations together
+ */
+void
+KeyStoreBenchmark_report(
+    const char*                 op,
+    const char*                 backend,
+    size_t                      keySize,
+    size_t                      count,
+    KeyStoreBenchmark_Cycles_t  cycles);
+
+///@}
@@ -0,0 +1,120 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreBloom.h
+ *
+ * @brief negative-lookup filter in front of a keystore instance
+ *
+ * A counting Bloom filter is kept in memory for a keystore instance. Lookups
+ * of names that are definitely not in the keystore are answered with
+ * OS_ERROR_NOT_FOUND without calling into the keystore (and thus without
+ * touching the storage of an OS_KeystoreFile). Lookups of names that may be in
+ * the keystore are forwarded as usual.
+ *
+ * The filter only stays exact if all modifications of the keystore go through
+ * the functions of this module.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define KeyStoreBloom_NUM_COUNTERS  1024
+#define KeyStoreBloom_NUM_HASHES    3
+
+typedef struct
+{
+    OS_Keystore_Handle_t    hKeystore;
+    /**
+     * Set as long as the filter is known to contain every key of the
+     * keystore; if not set, every lookup is forwarded.
+     */
+    bool                    complete;
+    /**
+     * Counters saturate at UINT8_MAX and are never decremented afterwards,
+     * so a saturated slot can only cause false positives.
+     */
+    uint8_t                 counters[KeyStoreBloom_NUM_COUNTERS];
+    size_t                  numLookups;
+    size_t                  numFiltered;
+} KeyStoreBloom_t;
+
+/**
+ * Builds the filter for a keystore instance.
+ *
+ * As the keystore has no way to enumerate its keys, the caller passes all
+ * names that may exist in the keystore; each of them is probed once and added
+ * to the filter if present. If no names are passed, the filter is incomplete
+ * and forwards all lookups until the keystore is wiped through
+ * KeyStoreBloom_wipeKeystore().
+ *
+ * @param[out]  self        Filter to initialize
+ * @param[in]   hKeystore   Keystore the filter is put in front of
+ * @param[in]   names       Every name which may exist in the keystore, or NULL
+ * @param[in]   numNames    Number of entries in names
+ *
+ * @return OS_SUCCESS or the error of a failed probe
+ */
+OS_Error_t
+KeyStoreBloom_init(
+    KeyStoreBloom_t*        self,
+    OS_Keystore_Handle_t    hKeystore,
+    const char* const*      names,
+    size_t                  numNames);
+
+/**
+ * Returns false if the key is definitely not in the keystore.
+ */
+bool
+KeyStoreBloom_mayContain(
+    const KeyStoreBloom_t*  self,
+    const char*             name);
+
+/**
+ * Same as OS_Keystore_storeKey(), but keeps the filter updated.
+ */
+OS_Error_t
+KeyStoreBloom_storeKey(
+    KeyStoreBloom_t*        self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize);
+
+/**
+ * Same as OS_Keystore_loadKey(), but answers definite misses from the filter.
+ */
+OS_Error_t
+KeyStoreBloom_loadKey(
+    KeyStoreBloom_t*        self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize);
+
+/**
+ * Same as OS_Keystore_deleteKey(), but answers definite misses from the
+ * filter and keeps it updated.
+ */
+OS_Error_t
+KeyStoreBloom_deleteKey(
+    KeyStoreBloom_t*        self,
+    const char*             name);
+
+/**
+ * Same as OS_Keystore_wipeKeystore(), afterwards the filter is complete.
+ */
+OS_Error_t
+KeyStoreBloom_wipeKeystore(
+    KeyStoreBloom_t*        self);
+
+///@}
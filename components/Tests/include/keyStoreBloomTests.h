@@ -0,0 +1,62 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreBloomTests.h
+ *
+ * @brief collection of tests for the negative-lookup filter of the KeyStore
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+
+/**
+ * @weakgroup KeyStore_Bloom_test_cases
+ * @{
+ *
+ * @brief               Test scenario which checks that the negative-lookup
+ *                      filter answers misses without asking the keystore and
+ *                      never reports a stored key as missing
+ *
+ * @param hKeystore     handle to the keyStore, it can represent a local instance
+ *                      of the key store library, or a handle to the context which
+ *                      is created in a separate camkes component
+ *
+ *
+ * @test \b TestKeyStore_testCase_18    Wipe the keystore through the filter and verify
+ *                                      that lookups of missing keys are answered by the
+ *                                      filter, while invalid names are still rejected
+ *
+ * @test \b TestKeyStore_testCase_19    Store, delete and re-store keys sharing the filter
+ *                                      and verify that no stored key is ever reported
+ *                                      as missing
+ *
+ * @test \b TestKeyStore_testCase_20    Store a key bypassing the filter and verify that
+ *                                      rebuilding the filter at init picks it up
+ *
+ * @}
+ *
+ */
+void keyStoreBloomTests(
+    OS_Keystore_Handle_t hKeystore);
+
+/**
+ * Measures the latency of looking up missing keys with and without the
+ * negative-lookup filter.
+ *
+ * @param[in]   hKeystore   Handle to the keystore
+ * @param[in]   backend     Name of the keystore implementation behind the
+ *                          handle, used for reporting
+ */
+void keyStoreBloomBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    const char*          backend);
+
+///@}
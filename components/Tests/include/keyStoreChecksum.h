@@ -0,0 +1,150 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreChecksum.h
+ *
+ * @brief keystore that stores a CRC32C with every key to detect corrupted
+ *        key data
+ *
+ * Every key is stored with the CRC32C of its data in front of it. The
+ * checksum is verified when the key is loaded, so no key is checked before
+ * it is used. Keys which are not loaded for a long time can be verified with
+ * KeyStoreChecksum_scrub(), which checks a few keys per call so it can run
+ * whenever there is idle time.
+ *
+ * All keys of the keystore must be stored through this module. As the
+ * keystore has no way to enumerate its keys, the names of the keys stored
+ * through this module are kept for scrubbing.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "system_config.h"
+
+#include "OS_Keystore.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Maximum number of keys known for scrubbing
+#define KeyStoreChecksum_MAX_KEYS       32
+
+// Size of the checksum stored in front of the key data
+#define KeyStoreChecksum_CRC_SIZE       sizeof(uint32_t)
+
+// Maximum size of the key data, leaving room for the checksum
+#define KeyStoreChecksum_MAX_KEY_SIZE \
+    (KeyStore_Config_MAX_KEY_SIZE - KeyStoreChecksum_CRC_SIZE)
+
+// Returned for key data that does not match its checksum
+#define KeyStoreChecksum_ERROR_CORRUPT  OS_ERROR_ABORTED
+
+typedef struct
+{
+    bool        valid;
+    char        name[16];
+    bool        corrupt;
+} KeyStoreChecksum_Entry_t;
+
+typedef struct
+{
+    OS_Keystore_Handle_t        hKeystore;
+    KeyStoreChecksum_Entry_t    entries[KeyStoreChecksum_MAX_KEYS];
+    size_t                      scrubCursor;
+    size_t                      numVerified;
+    size_t                      numCorrupt;
+    uint8_t                     record[KeyStore_Config_MAX_KEY_SIZE];
+} KeyStoreChecksum_t;
+
+/**
+ * Initializes the checksums of a keystore.
+ *
+ * @param[out]  self        Checksums to initialize
+ * @param[in]   hKeystore   Keystore to store the keys with checksums in
+ *
+ * @return OS_SUCCESS or OS_ERROR_INVALID_PARAMETER
+ */
+OS_Error_t
+KeyStoreChecksum_init(
+    KeyStoreChecksum_t*     self,
+    OS_Keystore_Handle_t    hKeystore);
+
+/**
+ * Same as OS_Keystore_storeKey(), the checksum of the key data is stored with
+ * it.
+ *
+ * @return OS_ERROR_INVALID_PARAMETER if the key is larger than
+ *         KeyStoreChecksum_MAX_KEY_SIZE, OS_ERROR_INSUFFICIENT_SPACE if
+ *         KeyStoreChecksum_MAX_KEYS keys are stored already, otherwise the
+ *         same as OS_Keystore_storeKey()
+ */
+OS_Error_t
+KeyStoreChecksum_storeKey(
+    KeyStoreChecksum_t*     self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize);
+
+/**
+ * Same as OS_Keystore_loadKey(), the key data is verified against its
+ * checksum.
+ *
+ * @return KeyStoreChecksum_ERROR_CORRUPT if the key data does not match its
+ *         checksum, otherwise the same as OS_Keystore_loadKey()
+ */
+OS_Error_t
+KeyStoreChecksum_loadKey(
+    KeyStoreChecksum_t*     self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize);
+
+/**
+ * Same as OS_Keystore_deleteKey().
+ */
+OS_Error_t
+KeyStoreChecksum_deleteKey(
+    KeyStoreChecksum_t*     self,
+    const char*             name);
+
+/**
+ * Same as OS_Keystore_wipeKeystore().
+ */
+OS_Error_t
+KeyStoreChecksum_wipeKeystore(
+    KeyStoreChecksum_t*     self);
+
+/**
+ * Verifies the next keys against their checksums, continuing where the last
+ * call stopped and starting over after the last key. Keys that cannot be
+ * loaded count as corrupted as well.
+ *
+ * @param[in]   self        Checksums of the keystore
+ * @param[in]   maxKeys     Maximum number of keys to verify
+ * @param[out]  numCorrupt  Number of corrupted keys found by this call
+ *
+ * @return OS_SUCCESS or OS_ERROR_INVALID_PARAMETER
+ */
+OS_Error_t
+KeyStoreChecksum_scrub(
+    KeyStoreChecksum_t*     self,
+    size_t                  maxKeys,
+    size_t*                 numCorrupt);
+
+/**
+ * Returns true if the key failed its verification by a load or a scrub.
+ */
+bool
+KeyStoreChecksum_isCorrupt(
+    KeyStoreChecksum_t*     self,
+    const char*             name);
+
+///@}
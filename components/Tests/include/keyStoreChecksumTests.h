@@ -0,0 +1,108 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreChecksumTests.h
+ *
+ * @brief collection of tests for the checksums of key data, including the
+ *        injection of faults into the storage of a keystore
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+#include "if_OS_Storage.h"
+
+#include <stddef.h>
+
+/**
+ * Corrupts every copy of a pattern in the storage of a keystore.
+ *
+ * @param[in]   pattern     Data to search for
+ * @param[in]   len         Length of the pattern
+ *
+ * @return Number of copies of the pattern that were corrupted
+ */
+typedef size_t (*KeyStoreChecksumTests_Corrupt_t)(
+    const void* pattern,
+    size_t      len);
+
+/**
+ * Flips a bit in every copy of a pattern on a storage, e.g. the RamDisk
+ * behind an OS_KeystoreFile.
+ *
+ * @return Number of copies of the pattern that were corrupted
+ */
+size_t keyStoreCorruptStorage(
+    const if_OS_Storage_t*  storage,
+    const void*             pattern,
+    size_t                  len);
+
+/**
+ * Flips a bit in every copy of a pattern in a buffer, e.g. the buffer of an
+ * OS_KeystoreRamFV.
+ *
+ * @return Number of copies of the pattern that were corrupted
+ */
+size_t keyStoreCorruptBuffer(
+    void*                   buf,
+    size_t                  size,
+    const void*             pattern,
+    size_t                  len);
+
+/**
+ * @weakgroup KeyStore_Checksum_test_cases
+ * @{
+ *
+ * @brief               Test scenario which stores keys with checksums,
+ *                      corrupts the storage of the keystore and verifies that
+ *                      the corruption is detected
+ *
+ * @param hKeystore     handle to the keyStore, it can represent a local instance
+ *                      of the key store library, or a handle to the context which
+ *                      is created in a separate camkes component
+ * @param corrupt       function that corrupts the storage of the keystore
+ *
+ *
+ * @test \b TestKeyStore_testCase_40    Verify the CRC32C against known answers with
+ *                                      and without the CRC instructions, and store,
+ *                                      load and scrub keys with checksums
+ *
+ * @test \b TestKeyStore_testCase_41    Corrupt the data of a key in the storage of
+ *                                      the keystore and verify that loading and
+ *                                      scrubbing detect it while the other keys
+ *                                      stay usable
+ *
+ * @}
+ *
+ */
+void keyStoreChecksumTests(
+    OS_Keystore_Handle_t            hKeystore,
+    KeyStoreChecksumTests_Corrupt_t corrupt);
+
+/**
+ * Measures loading keys with and without verifying their checksums, and
+ * scrubbing the keys of the keystore.
+ *
+ * @param[in]   hKeystore   Handle to the keystore
+ * @param[in]   backend     Name of the keystore implementation behind the
+ *                          handle, used for reporting
+ */
+void keyStoreChecksumBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    const char*          backend);
+
+/**
+ * Measures the CRC32C with a table and with the CRC instructions of the CPU,
+ * if the build uses them.
+ */
+void keyStoreCrc32cBenchmark(
+    void);
+
+///@}
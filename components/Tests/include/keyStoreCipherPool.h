@@ -0,0 +1,190 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreCipherPool.h
+ *
+ * @brief pool of initialized OS_CryptoCipher contexts
+ *
+ * Contexts are kept per (key handle, algorithm) and reused across calls,
+ * instead of running OS_CryptoCipher_init() and OS_CryptoCipher_free() for
+ * every message as aesEncrypt() and aesDecrypt() of the integration tests do.
+ *
+ * ECB contexts carry no state between messages. CBC contexts keep the last
+ * ciphertext block as chaining value; a message with its own IV is processed
+ * on the same context by XORing the difference between the new IV and the
+ * chaining value into the first block, which gives the same result as a
+ * context freshly initialized with that IV. GCM needs a new context for every
+ * message and is not supported.
+ *
+ * KeyStoreCipherPool_processLanes() takes independent buffers with different
+ * keys in one call and groups them by key and algorithm, so each key needs
+ * one context no matter how many buffers use it and in which order they
+ * come. The groups are still processed one after the other through
+ * OS_CryptoCipher_process(); the crypto library offers no interleaved or
+ * vectorized processing of several buffers.
+ *
+ * A context refers to its key, so KeyStoreCipherPool_releaseKey() must be
+ * called before a key handle is freed.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Crypto.h"
+#include "OS_Dataport.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define KeyStoreCipherPool_BLOCK_SIZE   16
+// Maximum number of contexts kept initialized
+#define KeyStoreCipherPool_MAX_CONTEXTS 8
+// Maximum number of lanes per call of KeyStoreCipherPool_processLanes()
+#define KeyStoreCipherPool_MAX_LANES    32
+// Largest amount of data passed to OS_CryptoCipher_process() at once, so it
+// fits into the dataport of the crypto library in RPC mode
+#define KeyStoreCipherPool_MAX_CHUNK \
+    ((OS_DATAPORT_DEFAULT_SIZE / KeyStoreCipherPool_BLOCK_SIZE) \
+     * KeyStoreCipherPool_BLOCK_SIZE)
+
+typedef struct
+{
+    void const* in;     ///< input, a multiple of the block size
+    size_t      len;    ///< size of input and output
+    void*       out;    ///< output, may be the same as the input
+    void const* iv;     ///< IV of a CBC message; NULL continues the chain of
+                        ///< the previous message; ignored for ECB
+} KeyStoreCipherPool_Msg_t;
+
+typedef struct
+{
+    OS_CryptoKey_Handle_t   hKey;
+    OS_CryptoCipher_Alg_t   alg;    ///< one of the ECB and CBC algorithms
+    void const*             iv;     ///< IV for CBC, ignored for ECB
+    void const*             in;     ///< input, a multiple of the block size
+    size_t                  len;    ///< size of input and output
+    void*                   out;    ///< output, may be the same as the input
+    OS_Error_t              err;    ///< result of this lane, set by the call
+} KeyStoreCipherPool_Lane_t;
+
+typedef struct
+{
+    bool                        valid;
+    OS_CryptoKey_Handle_t       hKey;
+    OS_CryptoCipher_Alg_t       alg;
+    OS_CryptoCipher_Handle_t    hCipher;
+    uint8_t                     chain[KeyStoreCipherPool_BLOCK_SIZE];
+    uint32_t                    lastUse;
+} KeyStoreCipherPool_Context_t;
+
+typedef struct
+{
+    OS_Crypto_Handle_t              hCrypto;
+    size_t                          capacity;
+    KeyStoreCipherPool_Context_t    ctx[KeyStoreCipherPool_MAX_CONTEXTS];
+    uint32_t                        clock;
+    size_t                          numInits;
+    size_t                          numReuses;
+    size_t                          numEvictions;
+    uint8_t                         block[KeyStoreCipherPool_BLOCK_SIZE];
+} KeyStoreCipherPool_t;
+
+/**
+ * Initializes an empty pool.
+ *
+ * @param[out]  self        Pool to initialize
+ * @param[in]   hCrypto     Crypto library the contexts are created in
+ * @param[in]   capacity    Number of contexts to keep, at most
+ *                          KeyStoreCipherPool_MAX_CONTEXTS; the least recently
+ *                          used context is freed when more are needed
+ *
+ * @return OS_SUCCESS or OS_ERROR_INVALID_PARAMETER
+ */
+OS_Error_t
+KeyStoreCipherPool_init(
+    KeyStoreCipherPool_t*   self,
+    OS_Crypto_Handle_t      hCrypto,
+    size_t                  capacity);
+
+/**
+ * Processes a batch of messages with the same key and algorithm on one
+ * context; messages larger than KeyStoreCipherPool_MAX_CHUNK are split up.
+ *
+ * @param[in]   self        Pool
+ * @param[in]   hKey        AES key
+ * @param[in]   alg         One of the ECB and CBC algorithms
+ * @param[in]   msgs        Messages to process, in order
+ * @param[in]   numMsgs     Number of messages
+ * @param[out]  numProcessed Number of messages processed before an error, all
+ *                          of them on success; may be NULL
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_PARAMETER, OS_ERROR_NOT_SUPPORTED for
+ *         other algorithms, or the error of the crypto library; the context
+ *         is dropped after an error
+ */
+OS_Error_t
+KeyStoreCipherPool_processBatch(
+    KeyStoreCipherPool_t*           self,
+    OS_CryptoKey_Handle_t           hKey,
+    OS_CryptoCipher_Alg_t           alg,
+    KeyStoreCipherPool_Msg_t const* msgs,
+    size_t                          numMsgs,
+    size_t*                         numProcessed);
+
+/**
+ * Processes a single message, see KeyStoreCipherPool_processBatch().
+ */
+OS_Error_t
+KeyStoreCipherPool_process(
+    KeyStoreCipherPool_t*   self,
+    OS_CryptoKey_Handle_t   hKey,
+    OS_CryptoCipher_Alg_t   alg,
+    void const*             iv,
+    void const*             in,
+    size_t                  len,
+    void*                   out);
+
+/**
+ * Processes lanes, each a (key, algorithm, buffer) triple of its own; lanes
+ * with the same key and algorithm are processed as one batch, see
+ * KeyStoreCipherPool_processBatch(). A lane does not continue a CBC chain, so
+ * CBC lanes need an IV.
+ *
+ * @param[in]       self        Pool
+ * @param[in,out]   lanes       Lanes to process; the result of every lane is
+ *                              put into its err field
+ * @param[in]       numLanes    Number of lanes, at most
+ *                              KeyStoreCipherPool_MAX_LANES
+ *
+ * @return OS_SUCCESS if all lanes were processed, OS_ERROR_INVALID_PARAMETER
+ *         for bad arguments, or the error of the first lane that failed
+ */
+OS_Error_t
+KeyStoreCipherPool_processLanes(
+    KeyStoreCipherPool_t*       self,
+    KeyStoreCipherPool_Lane_t*  lanes,
+    size_t                      numLanes);
+
+/**
+ * Frees all contexts which use a key.
+ */
+void
+KeyStoreCipherPool_releaseKey(
+    KeyStoreCipherPool_t*   self,
+    OS_CryptoKey_Handle_t   hKey);
+
+/**
+ * Frees all contexts.
+ */
+void
+KeyStoreCipherPool_free(
+    KeyStoreCipherPool_t*   self);
+
+///@}
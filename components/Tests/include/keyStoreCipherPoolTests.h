@@ -0,0 +1,62 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreCipherPoolTests.h
+ *
+ * @brief collection of tests for the pool of cipher contexts used with keys
+ *        loaded from a keystore
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+#include "OS_Crypto.h"
+
+/**
+ * @weakgroup KeyStore_CipherPool_test_cases
+ * @{
+ *
+ * @brief               Test scenario which compares the output of pooled
+ *                      cipher contexts with the one of contexts initialized
+ *                      for every message
+ *
+ * @param hKeystore     handle to the keyStore, it can represent a local instance
+ *                      of the key store library, or a handle to the context which
+ *                      is created in a separate camkes component
+ *
+ * @param hCrypto       handle to the crypto library
+ *
+ *
+ * @test \b TestKeyStore_testCase_32    Encrypt and decrypt batches of ECB messages of
+ *                                      different sizes, also larger than a chunk, with
+ *                                      a key loaded from the keystore and verify that
+ *                                      one context per direction is used
+ *
+ * @test \b TestKeyStore_testCase_33    Encrypt and decrypt CBC messages with different
+ *                                      IVs and continued chains on one context and verify
+ *                                      the results and the eviction of contexts
+ *
+ * @}
+ *
+ */
+void keyStoreCipherPoolTests(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto);
+
+/**
+ * Measures the throughput of small messages with a context initialized for
+ * every message compared to pooled contexts and batched processing.
+ *
+ * @param[in]   hCrypto     Handle to the crypto library
+ */
+void keyStoreCipherPoolBenchmark(
+    OS_Crypto_Handle_t   hCrypto);
+
+///@}
@@ -0,0 +1,49 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreCrc32c.h
+ *
+ * @brief CRC32C (Castagnoli) checksums of key data
+ *
+ * The CRC instructions of the CPU are used if the compiler targets them
+ * (SSE4.2 on x86, the CRC32 extension on ARMv8), otherwise tables for
+ * slicing-by-8 are used.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__SSE4_2__) || defined(__ARM_FEATURE_CRC32)
+#   define KeyStoreCrc32c_HAS_HW    1
+#else
+#   define KeyStoreCrc32c_HAS_HW    0
+#endif
+
+/**
+ * Computes the CRC32C of a buffer, with the CRC instructions of the CPU if
+ * available.
+ */
+uint32_t
+KeyStoreCrc32c_compute(
+    const void* data,
+    size_t      len);
+
+/**
+ * Computes the CRC32C of a buffer with tables, regardless of the CPU.
+ */
+uint32_t
+KeyStoreCrc32c_computeTable(
+    const void* data,
+    size_t      len);
+
+///@}
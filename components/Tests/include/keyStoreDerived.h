@@ -0,0 +1,132 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreDerived.h
+ *
+ * @brief derivation of session keys from master keys held in a keystore
+ *
+ * Master keys are stored as OS_CryptoKey_Data_t (AES or MAC keys), as it is
+ * done by testKeyStoreAES(). On first use a master key is loaded and imported
+ * into OS_Crypto as HMAC key; the handle is kept in a bounded cache, so later
+ * derivations need neither keystore access nor import.
+ *
+ * Child keys are AES keys derived with HKDF-Expand (RFC 5869) using
+ * HMAC-SHA256, with the master key as pseudorandom key and a label as info:
+ *
+ *      child = HMAC-SHA256(master, label || 0x01)[0 .. childSize - 1]
+ *
+ * The extract step is skipped, as master keys are taken from the RNG and are
+ * uniformly random already.
+ *
+ * The cache does not notice changes of the keystore; after a master key was
+ * replaced or deleted, KeyStoreDerived_evict() must be called.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Crypto.h"
+#include "OS_Keystore.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Maximum number of master keys kept imported
+#define KeyStoreDerived_MAX_CACHED_KEYS 8
+// Maximum length of a label
+#define KeyStoreDerived_MAX_LABEL_LEN   64
+// Size of the HMAC-SHA256 output, which limits the size of a child key
+#define KeyStoreDerived_PRK_SIZE        32
+
+typedef struct
+{
+    bool                    valid;
+    char                    name[16];
+    OS_CryptoKey_Handle_t   hKey;
+    OS_CryptoKey_Attrib_t   attribs;
+    uint32_t                lastUse;
+} KeyStoreDerived_CacheEntry_t;
+
+typedef struct
+{
+    OS_Keystore_Handle_t            hKeystore;
+    OS_Crypto_Handle_t              hCrypto;
+    size_t                          capacity;
+    KeyStoreDerived_CacheEntry_t    cache[KeyStoreDerived_MAX_CACHED_KEYS];
+    uint32_t                        clock;
+    size_t                          numHits;
+    size_t                          numMisses;
+    size_t                          numEvictions;
+    OS_CryptoKey_Data_t             keyData;
+} KeyStoreDerived_t;
+
+/**
+ * Initializes the derivation service with an empty cache.
+ *
+ * @param[out]  self        Service to initialize
+ * @param[in]   hKeystore   Keystore holding the master keys
+ * @param[in]   hCrypto     Crypto library the keys are imported into
+ * @param[in]   capacity    Number of master keys to keep imported, at most
+ *                          KeyStoreDerived_MAX_CACHED_KEYS
+ *
+ * @return OS_SUCCESS or OS_ERROR_INVALID_PARAMETER
+ */
+OS_Error_t
+KeyStoreDerived_init(
+    KeyStoreDerived_t*      self,
+    OS_Keystore_Handle_t    hKeystore,
+    OS_Crypto_Handle_t      hCrypto,
+    size_t                  capacity);
+
+/**
+ * Derives an AES key from a master key.
+ *
+ * If the crypto library runs out of memory while importing a master key, the
+ * least recently used handles are freed until the import succeeds.
+ *
+ * @param[in]   self        Service
+ * @param[in]   masterName  Name of the master key in the keystore
+ * @param[in]   label       Label the child key is bound to
+ * @param[in]   labelLen    Length of the label, at most
+ *                          KeyStoreDerived_MAX_LABEL_LEN
+ * @param[in]   childSize   Size of the child key in bytes (16, 24 or 32)
+ * @param[out]  hChild      Handle of the child key, to be freed by the caller
+ *                          with OS_CryptoKey_free(); it gets the attributes of
+ *                          the master key
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_PARAMETER, OS_ERROR_NOT_SUPPORTED if the
+ *         master key is neither an AES nor a MAC key, or the error of loading
+ *         the master key or of the crypto library
+ */
+OS_Error_t
+KeyStoreDerived_deriveKey(
+    KeyStoreDerived_t*      self,
+    const char*             masterName,
+    void const*             label,
+    size_t                  labelLen,
+    size_t                  childSize,
+    OS_CryptoKey_Handle_t*  hChild);
+
+/**
+ * Frees the cached handle of a master key, if there is one.
+ */
+void
+KeyStoreDerived_evict(
+    KeyStoreDerived_t*      self,
+    const char*             masterName);
+
+/**
+ * Frees all cached handles.
+ */
+void
+KeyStoreDerived_flush(
+    KeyStoreDerived_t*      self);
+
+///@}
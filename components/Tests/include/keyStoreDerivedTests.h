@@ -0,0 +1,65 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreDerivedTests.h
+ *
+ * @brief collection of tests for the derivation of session keys from master
+ *        keys held in a keystore
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+#include "OS_Crypto.h"
+
+/**
+ * @weakgroup KeyStore_Derived_test_cases
+ * @{
+ *
+ * @brief               Test scenario which checks derived keys against their
+ *                      recomputation and the handling of the master key cache
+ *
+ * @param hKeystore     handle to the keyStore, it can represent a local instance
+ *                      of the key store library, or a handle to the context which
+ *                      is created in a separate camkes component
+ *
+ * @param hCrypto       handle to the crypto library
+ *
+ *
+ * @test \b TestKeyStore_testCase_30    Derive keys of all sizes from an AES and a MAC
+ *                                      master key and compare them with the HKDF
+ *                                      output computed from the stored master key
+ *
+ * @test \b TestKeyStore_testCase_31    Use more master keys than the cache can hold,
+ *                                      replace a master key and verify that handles are
+ *                                      evicted and derived keys follow the keystore
+ *
+ * @}
+ *
+ */
+void keyStoreDerivedTests(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto);
+
+/**
+ * Measures the rate of key derivations with the master key loaded and
+ * imported for every derivation compared to a warm cache.
+ *
+ * @param[in]   hKeystore   Handle to the keystore
+ * @param[in]   hCrypto     Handle to the crypto library
+ * @param[in]   backend     Name of the keystore implementation behind the
+ *                          handle, used for reporting
+ */
+void keyStoreDerivedBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    const char*          backend);
+
+///@}
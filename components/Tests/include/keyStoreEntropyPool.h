@@ -0,0 +1,104 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreEntropyPool.h
+ *
+ * @brief pre-filled entropy pool in front of the EntropySource
+ *
+ * The pool offers an if_OS_Entropy_t which can be passed to OS_Crypto instead
+ * of the one of the EntropySource component. Requests are served from a local
+ * pool which is filled with as much data per RPC as the dataport of the
+ * EntropySource can hold. Calling KeyStoreEntropyPool_refill() when the
+ * system is idle keeps bursts of key generation free of entropy RPCs.
+ *
+ * Every byte of the pool is handed out only once.
+ *
+ * As the read function of if_OS_Entropy_t has no context parameter, there is
+ * only one pool per component.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Crypto.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Capacity of the pool, multiple of the dataport size of the EntropySource
+#define KeyStoreEntropyPool_SIZE    (2 * OS_DATAPORT_DEFAULT_SIZE)
+
+typedef struct
+{
+    size_t numReads;        ///< requests served to the crypto library
+    size_t numUpstreamReads;///< RPCs to the EntropySource
+    size_t numBytesServed;  ///< bytes handed out to the crypto library
+} KeyStoreEntropyPool_Stats_t;
+
+/**
+ * Initializes the pool and fills it.
+ *
+ * @param[in]   upstream    Interface of the EntropySource component
+ * @param[in]   pooled      If false, every request is forwarded to the
+ *                          EntropySource; used to compare against the
+ *                          unpooled behavior
+ *
+ * @return OS_SUCCESS or OS_ERROR_INVALID_PARAMETER
+ */
+OS_Error_t
+KeyStoreEntropyPool_init(
+    const if_OS_Entropy_t*  upstream,
+    bool                    pooled);
+
+/**
+ * Returns the interface to be put into OS_Crypto_Config_t.entropy.
+ */
+const if_OS_Entropy_t*
+KeyStoreEntropyPool_getInterface(
+    void);
+
+/**
+ * Switches between pooled and forwarding mode.
+ */
+void
+KeyStoreEntropyPool_setPooled(
+    bool pooled);
+
+/**
+ * Tops up the pool; meant to be called when the system is idle.
+ *
+ * @return OS_SUCCESS or OS_ERROR_ABORTED if the EntropySource delivered
+ *         nothing
+ */
+OS_Error_t
+KeyStoreEntropyPool_refill(
+    void);
+
+/**
+ * Returns the number of bytes currently held in the pool.
+ */
+size_t
+KeyStoreEntropyPool_getFillLevel(
+    void);
+
+/**
+ * Copies the counters of the pool to stats.
+ */
+void
+KeyStoreEntropyPool_getStats(
+    KeyStoreEntropyPool_Stats_t* stats);
+
+/**
+ * Resets all counters of the pool to zero.
+ */
+void
+KeyStoreEntropyPool_resetStats(
+    void);
+
+///@}
@@ -0,0 +1,71 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreEntropyPoolTests.h
+ *
+ * @brief collection of tests for the entropy pool used by the crypto api
+ *        which feeds the KeyStore
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+#include "OS_Crypto.h"
+
+/**
+ * @weakgroup KeyStore_EntropyPool_test_cases
+ * @{
+ *
+ * @brief               Test scenario which checks that the entropy pool hands
+ *                      out every byte only once and that key generation is
+ *                      served from the pool without entropy RPCs
+ *
+ * @param hKeystore     handle to the keyStore, it can represent a local instance
+ *                      of the key store library, or a handle to the context which
+ *                      is created in a separate camkes component
+ *
+ * @param hCrypto       handle to the crypto library, it must have been created
+ *                      with the interface of the entropy pool, which has to be
+ *                      topped up with KeyStoreEntropyPool_refill() before
+ *
+ *
+ * @test \b TestKeyStore_testCase_21    Read from the pool and verify that the fill level
+ *                                      drops, no RPC is issued and no data is repeated
+ *
+ * @test \b TestKeyStore_testCase_22    Generate keys, store them in the keystore and verify
+ *                                      that the burst is served from the pool, which the
+ *                                      caller has topped up, without any entropy RPC
+ *
+ * @test \b TestKeyStore_testCase_52    Drain the pool and verify that the next read refills
+ *                                      it with one RPC per dataport of the EntropySource
+ *
+ * @}
+ *
+ */
+void keyStoreEntropyPoolTests(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto);
+
+/**
+ * Measures the throughput of provisioning AES keys into a keystore with the
+ * entropy pool in forwarding and in pooled mode.
+ *
+ * @param[in]   hKeystore   Handle to the keystore
+ * @param[in]   hCrypto     Handle to the crypto library, created with the
+ *                          interface of the entropy pool
+ * @param[in]   backend     Name of the keystore implementation behind the
+ *                          handle, used for reporting
+ */
+void keyStoreEntropyPoolBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    const char*          backend);
+
+///@}
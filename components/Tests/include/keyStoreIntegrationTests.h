@@ -88,6 +88,43 @@ void testKeyStoreAES(
 void testKeyStoreKeyPair(
     OS_Keystore_Handle_t hKeystore,
     OS_Crypto_Handle_t   hCrypto);
+/**
+ * @weakgroup KeyStore_AES_Lanes_test_cases
+ * @{
+ *
+ * @brief               Test scenario which performs known-answer tests of the
+ *                      lanes of the cipher pool with keys taken from the keystore
+ *
+ * @param hKeystore     handle to the keyStore, it can represent a local instance
+ *                      of the key store library, or a handle to the context which
+ *                      is created in a separate camkes component
+ *
+ * @param hCrypto       handle to the crypto library, it can represent a local instance
+ *                      of the library, or a handle to the context which is created in a
+ *                      separate camkes component
+ *
+ *
+ * @test \b TestKeyStore_testCase_34    Store the FIPS-197 and SP 800-38A keys in the keystore,
+ *                                      load them and process interleaved ECB and CBC lanes of
+ *                                      all keys in one call and compare with the known answers;
+ *                                      verify that a bad lane fails on its own, also among good
+ *                                      lanes with the same key
+ *
+ * @}
+ *
+ */
+void testKeyStoreAESLanes(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto);
+
+/**
+ * Measures the throughput of encrypting records with several keys as lanes
+ * on pooled contexts compared to initializing a context for every record.
+ *
+ * @param[in]   hCrypto     Handle to the crypto library
+ */
+void keyStoreAESLanesBenchmark(
+    OS_Crypto_Handle_t   hCrypto);
 
 ///@}
 
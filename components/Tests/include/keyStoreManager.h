@@ -0,0 +1,167 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreManager.h
+ *
+ * @brief many named OS_KeystoreFile instances over one file system
+ *
+ * Keystores are registered by name and opened on their first use. At most a
+ * configured number of them is open at a time; when another one is needed,
+ * the least recently used one is closed. Its keys stay in the file system.
+ *
+ * All keystores share one metadata cache, which remembers for recently used
+ * keys whether they exist and how large they are. Lookups of keys known to
+ * be missing and of the size of a key are answered from it, without opening
+ * the keystore or touching the file system.
+ *
+ * The metadata cache only stays exact if the keystores are only used through
+ * the functions of this module.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Crypto.h"
+#include "OS_FileSystem.h"
+#include "OS_Keystore.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Maximum number of keystores that can be registered
+#define KeyStoreManager_MAX_KEYSTORES   128
+// Maximum number of keystores that can be open at a time
+#define KeyStoreManager_MAX_OPEN        16
+// Number of keys the shared metadata cache remembers
+#define KeyStoreManager_META_SLOTS      64
+
+typedef struct
+{
+    char                    name[16];
+    OS_Keystore_Handle_t    hKeystore;  ///< NULL while the keystore is closed
+    uint32_t                lastUse;
+} KeyStoreManager_Keystore_t;
+
+typedef struct
+{
+    bool        valid;
+    uint16_t    id;
+    char        name[16];
+    bool        exists;
+    size_t      size;
+} KeyStoreManager_Meta_t;
+
+typedef struct
+{
+    OS_FileSystem_Handle_t      hFs;
+    OS_Crypto_Handle_t          hCrypto;
+    size_t                      maxOpen;
+    size_t                      numKeystores;
+    size_t                      numOpen;
+    KeyStoreManager_Keystore_t  keystores[KeyStoreManager_MAX_KEYSTORES];
+    KeyStoreManager_Meta_t      meta[KeyStoreManager_META_SLOTS];
+    uint32_t                    clock;
+    size_t                      numOpens;
+    size_t                      numCloses;
+    size_t                      numMetaHits;
+} KeyStoreManager_t;
+
+/**
+ * Initializes a keystore manager.
+ *
+ * @param[out]  self        Manager to initialize
+ * @param[in]   hFs         File system the keystores are kept in
+ * @param[in]   hCrypto     Crypto instance used by the keystores
+ * @param[in]   maxOpen     Maximum number of keystores open at a time, at
+ *                          most KeyStoreManager_MAX_OPEN
+ *
+ * @return OS_SUCCESS or OS_ERROR_INVALID_PARAMETER
+ */
+OS_Error_t
+KeyStoreManager_init(
+    KeyStoreManager_t*      self,
+    OS_FileSystem_Handle_t  hFs,
+    OS_Crypto_Handle_t      hCrypto,
+    size_t                  maxOpen);
+
+/**
+ * Closes all open keystores, their keys stay in the file system.
+ */
+OS_Error_t
+KeyStoreManager_free(
+    KeyStoreManager_t*      self);
+
+/**
+ * Registers a keystore, it is opened on its first use.
+ *
+ * @param[in]   self        Manager
+ * @param[in]   name        Name of the keystore, as for OS_KeystoreFile_init()
+ * @param[out]  id          Id to access the keystore with
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_PARAMETER if the name is invalid or
+ *         registered already, or OS_ERROR_INSUFFICIENT_SPACE if
+ *         KeyStoreManager_MAX_KEYSTORES keystores are registered
+ */
+OS_Error_t
+KeyStoreManager_addKeystore(
+    KeyStoreManager_t*      self,
+    const char*             name,
+    size_t*                 id);
+
+/**
+ * Same as OS_Keystore_storeKey() on the keystore with the given id.
+ */
+OS_Error_t
+KeyStoreManager_storeKey(
+    KeyStoreManager_t*      self,
+    size_t                  id,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize);
+
+/**
+ * Same as OS_Keystore_loadKey() on the keystore with the given id; missing
+ * keys and buffers that are too small may be reported from the metadata
+ * cache.
+ */
+OS_Error_t
+KeyStoreManager_loadKey(
+    KeyStoreManager_t*      self,
+    size_t                  id,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize);
+
+/**
+ * Same as OS_Keystore_deleteKey() on the keystore with the given id.
+ */
+OS_Error_t
+KeyStoreManager_deleteKey(
+    KeyStoreManager_t*      self,
+    size_t                  id,
+    const char*             name);
+
+/**
+ * Same as OS_Keystore_wipeKeystore() on the keystore with the given id.
+ */
+OS_Error_t
+KeyStoreManager_wipeKeystore(
+    KeyStoreManager_t*      self,
+    size_t                  id);
+
+/**
+ * Returns true if the keystore with the given id is open.
+ */
+bool
+KeyStoreManager_isOpen(
+    KeyStoreManager_t*      self,
+    size_t                  id);
+
+///@}
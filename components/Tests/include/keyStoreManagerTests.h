@@ -0,0 +1,62 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreManagerTests.h
+ *
+ * @brief collection of tests for many keystores over one file system
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Crypto.h"
+#include "OS_FileSystem.h"
+
+/**
+ * @weakgroup KeyStore_Manager_test_cases
+ * @{
+ *
+ * @brief               Test scenario which keeps more than a hundred
+ *                      KeystoreFile instances in one file system, of which
+ *                      only a few are open at a time
+ *
+ * @param hFs           file system to keep the keystores in
+ * @param hCrypto       crypto instance used by the keystores
+ *
+ *
+ * @test \b TestKeyStore_testCase_44    Store a key under the same name in each
+ *                                      keystore, verify that keystores are
+ *                                      opened on first use, that no more than
+ *                                      the maximum is open, and that the keys
+ *                                      of closed keystores are kept apart
+ *
+ * @test \b TestKeyStore_testCase_45    Verify that missing keys and key sizes
+ *                                      are served from the shared metadata
+ *                                      cache without opening a keystore, and
+ *                                      that invalid names and ids are rejected
+ *
+ * @}
+ *
+ */
+void keyStoreManagerTests(
+    OS_FileSystem_Handle_t  hFs,
+    OS_Crypto_Handle_t      hCrypto);
+
+/**
+ * Measures the memory each keystore takes in the manager and the latency of
+ * the first access to a keystore compared to accessing an open one.
+ *
+ * @param[in]   hFs         File system to keep the keystores in
+ * @param[in]   hCrypto     Crypto instance used by the keystores
+ */
+void keyStoreManagerBenchmark(
+    OS_FileSystem_Handle_t  hFs,
+    OS_Crypto_Handle_t      hCrypto);
+
+///@}
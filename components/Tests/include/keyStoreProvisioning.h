@@ -0,0 +1,112 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreProvisioning.h
+ *
+ * @brief bulk provisioning of key pairs into a keystore
+ *
+ * Key pairs are provisioned in batches which pass three stages: generation
+ * of private and public keys, export of both halves and storage into the
+ * keystore as "<prefix><index>Prv" and "<prefix><index>Pub", like
+ * importExportKeyPairTest() does it with "PrvKey" and "PubKey".
+ *
+ * Generation is spread round-robin over a set of OS_Crypto instances, the
+ * workers. The workers are called one after the other from the calling
+ * thread, so more workers do not generate pairs in parallel, not even when
+ * each of them is a crypto server of its own in RPC mode. A batch is stored only after all of its pairs were
+ * generated and exported, and if storing fails the halves of the batch that
+ * were stored already are removed again, so the keystore never holds half a
+ * pair.
+ *
+ * Given the same workers in the same order, each seeded with the same stream
+ * (see keyStoreSeededEntropy.h), a run provisions the same keys.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Crypto.h"
+#include "OS_Keystore.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define KeyStoreProvisioning_MAX_WORKERS        4
+#define KeyStoreProvisioning_MAX_BATCH          8
+// Key names are made of the prefix, four digits and "Prv" or "Pub"
+#define KeyStoreProvisioning_MAX_PREFIX_LEN     8
+#define KeyStoreProvisioning_MAX_PAIRS          10000
+
+typedef struct
+{
+    OS_Keystore_Handle_t        hKeystore;
+    OS_Crypto_Handle_t          workers[KeyStoreProvisioning_MAX_WORKERS];
+    size_t                      numWorkers;
+    size_t                      nextWorker;
+    OS_CryptoKey_Spec_t         spec;
+    size_t                      batchSize;
+    size_t                      numPairs;
+    OS_CryptoKey_Handle_t       hPrv[KeyStoreProvisioning_MAX_BATCH];
+    OS_CryptoKey_Handle_t       hPub[KeyStoreProvisioning_MAX_BATCH];
+    OS_CryptoKey_Data_t         prv[KeyStoreProvisioning_MAX_BATCH];
+    OS_CryptoKey_Data_t         pub[KeyStoreProvisioning_MAX_BATCH];
+} KeyStoreProvisioning_t;
+
+/**
+ * Initializes a provisioning pipeline.
+ *
+ * @param[out]  self        Pipeline to initialize
+ * @param[in]   hKeystore   Keystore the pairs are stored in
+ * @param[in]   workers     Crypto instances the pairs are generated with
+ * @param[in]   numWorkers  Number of workers, at most
+ *                          KeyStoreProvisioning_MAX_WORKERS
+ * @param[in]   spec        Spec of the private keys (RSA or DH)
+ * @param[in]   batchSize   Number of pairs per batch, at most
+ *                          KeyStoreProvisioning_MAX_BATCH
+ *
+ * @return OS_SUCCESS or OS_ERROR_INVALID_PARAMETER
+ */
+OS_Error_t
+KeyStoreProvisioning_init(
+    KeyStoreProvisioning_t*     self,
+    OS_Keystore_Handle_t        hKeystore,
+    const OS_Crypto_Handle_t*   workers,
+    size_t                      numWorkers,
+    const OS_CryptoKey_Spec_t*  spec,
+    size_t                      batchSize);
+
+/**
+ * Provisions key pairs with the indices first .. first + count - 1.
+ *
+ * @param[in]   self        Pipeline
+ * @param[in]   prefix      Prefix of the key names
+ * @param[in]   first       Index of the first pair
+ * @param[in]   count       Number of pairs
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_PARAMETER, or the error of the crypto
+ *         library or the keystore; pairs of earlier batches stay stored
+ */
+OS_Error_t
+KeyStoreProvisioning_run(
+    KeyStoreProvisioning_t*     self,
+    const char*                 prefix,
+    size_t                      first,
+    size_t                      count);
+
+/**
+ * Writes the name of a half of a pair into a buffer of at least 16 bytes.
+ */
+void
+KeyStoreProvisioning_getName(
+    const char*                 prefix,
+    size_t                      index,
+    bool                        isPublic,
+    char*                       name);
+
+///@}
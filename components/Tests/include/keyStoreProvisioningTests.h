@@ -0,0 +1,60 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreProvisioningTests.h
+ *
+ * @brief collection of tests for the bulk provisioning of key pairs
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+
+/**
+ * @weakgroup KeyStore_Provisioning_test_cases
+ * @{
+ *
+ * @brief               Test scenario which provisions key pairs with crypto
+ *                      instances seeded from a deterministic entropy source
+ *                      and checks the stored pairs
+ *
+ * @param hKeystore     handle to the keyStore, it can represent a local instance
+ *                      of the key store library, or a handle to the context which
+ *                      is created in a separate camkes component
+ *
+ *
+ * @test \b TestKeyStore_testCase_35    Provision RSA and DH pairs in several batches with
+ *                                      two workers and verify that every private key
+ *                                      round-trips through the crypto library and yields
+ *                                      the stored public key
+ *
+ * @test \b TestKeyStore_testCase_36    Provision twice with the same seed and once with
+ *                                      another one and verify that only the same seed
+ *                                      gives the same keys
+ *
+ * @}
+ *
+ */
+void keyStoreProvisioningTests(
+    OS_Keystore_Handle_t hKeystore);
+
+/**
+ * Measures the rate at which key pairs are provisioned into the keystore with
+ * one worker.
+ *
+ * @param[in]   hKeystore   Handle to the keystore
+ * @param[in]   backend     Name of the keystore implementation behind the
+ *                          handle, used for reporting
+ */
+void keyStoreProvisioningBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    const char*          backend);
+
+///@}
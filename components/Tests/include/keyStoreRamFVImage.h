@@ -0,0 +1,90 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreRamFVImage.h
+ *
+ * @brief images of the buffer of an OS_KeystoreRamFV in a file, so its keys
+ *        survive a reboot without importing them one by one
+ *
+ * An image consists of a header and the occupied part of the buffer, which
+ * ends with its last non-zero byte; the rest of the buffer is zero and is
+ * restored as such. The header holds the size of the whole buffer and the
+ * CRC32C of the data, so images of buffers of a different size and corrupted
+ * images are rejected.
+ *
+ * The image is restored into the buffer of an OS_KeystoreRamFV instance that
+ * was initialized over a buffer of the same size, while the instance exists.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_FileSystem.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define KeyStoreRamFVImage_MAGIC        0x4B535246u     // "KSRF"
+#define KeyStoreRamFVImage_VERSION      1
+
+typedef struct
+{
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    bufSize;    ///< size of the whole buffer
+    uint32_t    dataSize;   ///< size of the occupied part that follows
+    uint32_t    dataCrc;    ///< CRC32C of the occupied part
+    uint32_t    headerCrc;  ///< CRC32C of the fields above
+} KeyStoreRamFVImage_Header_t;
+
+/**
+ * Writes an image of the buffer of an OS_KeystoreRamFV to a file, replacing
+ * the file if it exists.
+ *
+ * @param[in]   buf         Buffer of the keystore
+ * @param[in]   bufSize     Size of the buffer
+ * @param[in]   hFs         File system to write the image to
+ * @param[in]   fileName    Name of the image file
+ * @param[out]  imageSize   Size of the image file written, may be NULL
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_PARAMETER or the error of the file
+ *         system
+ */
+OS_Error_t
+KeyStoreRamFVImage_serialize(
+    const void*             buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs,
+    const char*             fileName,
+    size_t*                 imageSize);
+
+/**
+ * Restores the buffer of an OS_KeystoreRamFV from an image file.
+ *
+ * The buffer is only written after the header of the image was checked. If
+ * the data does not match its checksum, the buffer is left in an undefined
+ * state and the keystore must be wiped.
+ *
+ * @param[out]  buf         Buffer of the keystore
+ * @param[in]   bufSize     Size of the buffer, must match the image
+ * @param[in]   hFs         File system to read the image from
+ * @param[in]   fileName    Name of the image file
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_PARAMETER, OS_ERROR_INVALID_STATE if
+ *         the image is corrupted or does not fit the buffer, or the error of
+ *         the file system, e.g. if there is no image
+ */
+OS_Error_t
+KeyStoreRamFVImage_deserialize(
+    void*                   buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs,
+    const char*             fileName);
+
+///@}
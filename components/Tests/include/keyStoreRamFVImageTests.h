@@ -0,0 +1,69 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreRamFVImageTests.h
+ *
+ * @brief collection of tests for images of the buffer of an OS_KeystoreRamFV
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_FileSystem.h"
+#include "OS_Keystore.h"
+
+#include <stddef.h>
+
+/**
+ * @weakgroup KeyStore_RamFVImage_test_cases
+ * @{
+ *
+ * @brief               Test scenario which writes the buffer of a RamFV
+ *                      keystore to a file and restores it
+ *
+ * @param hKeystore     handle to a RamFV keystore
+ * @param buf           buffer the keystore was initialized with
+ * @param bufSize       size of the buffer
+ * @param hFs           file system to keep the image in
+ *
+ *
+ * @test \b TestKeyStore_testCase_42    Store keys, write an image of the buffer,
+ *                                      wipe the keystore, restore the image and
+ *                                      verify that buffer and keys are the same
+ *
+ * @test \b TestKeyStore_testCase_43    Verify that images which do not fit the
+ *                                      buffer or are corrupted are rejected
+ *
+ * @}
+ *
+ */
+void keyStoreRamFVImageTests(
+    OS_Keystore_Handle_t    hKeystore,
+    void*                   buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs);
+
+/**
+ * Measures filling a RamFV keystore at boot by importing every key from a
+ * persistent keystore compared to restoring an image of its buffer.
+ *
+ * @param[in]   hKeystore   Handle to a RamFV keystore
+ * @param[in]   buf         Buffer the keystore was initialized with
+ * @param[in]   bufSize     Size of the buffer
+ * @param[in]   hFs         File system to keep the image in
+ * @param[in]   hPersistent Handle to the keystore to import the keys from
+ */
+void keyStoreRamFVImageBenchmark(
+    OS_Keystore_Handle_t    hKeystore,
+    void*                   buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs,
+    OS_Keystore_Handle_t    hPersistent);
+
+///@}
@@ -0,0 +1,64 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreRamFVScaleTests.h
+ *
+ * @brief collection of tests for OS_KeystoreRamFV instances far larger than
+ *        the ones of the other tests
+ *
+ * The tests create their own instances, over a static buffer that holds
+ * KeyStore_Config_SCALE_NUM_ELEMENTS keys. They run for several capacities
+ * and key sizes.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+/**
+ * @weakgroup KeyStore_RamFVScale_test_cases
+ * @{
+ *
+ * @brief               Test scenario which fills RamFV keystores of several
+ *                      capacities and key sizes up to their capacity, drains
+ *                      them, and replaces keys at a constant fill level
+ *
+ *
+ * @test \b TestKeyStore_testCase_46    Fill the keystore until it is full,
+ *                                      verify every key, verify that one more
+ *                                      key does not fit, then delete all keys
+ *                                      in random order
+ *
+ * @test \b TestKeyStore_testCase_47    Replace random keys by new ones at a
+ *                                      constant fill level, verify that no key
+ *                                      is lost and that the keystore can still
+ *                                      be filled up to its capacity
+ *
+ * @}
+ *
+ */
+void keyStoreRamFVScaleTests(void);
+
+/**
+ * Measures the cost per operation of RamFV keystores of several capacities
+ * and key sizes while they fill up, while they drain and during a churn of
+ * deletes and stores at a constant fill level.
+ *
+ * Each phase is split into rounds that are reported separately. The bounds
+ * are checked on the median cost per operation of a round, and only for
+ * rounds of enough operations. The test fails if the cost of storing grows
+ * from the first to the last round of filling by more than
+ * KeyStore_Config_SCALE_MAX_GROWTH_PERCENT of the growth of an operation
+ * whose cost is linear in the number of keys. It also fails if the last round
+ * of the churn costs more than KeyStore_Config_SCALE_MAX_CHURN_GROWTH times
+ * its first. The same percentage bounds the cost of storing into the almost
+ * full keystore of the largest capacity against the one of the smallest.
+ */
+void keyStoreRamFVScaleBenchmark(void);
+
+///@}
@@ -0,0 +1,172 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreRealtime.h
+ *
+ * @brief keystore with fixed-cost, allocation-free operations for callers
+ *        with real-time constraints
+ *
+ * The keys are held in a table of KeyStore_Config_RT_NUM_KEYS slots that is
+ * part of the keystore, so storing, loading and deleting keys never
+ * allocates memory and never calls into a file system, the storage or the
+ * crypto library. Every key has a window of KeyStore_Config_RT_MAX_PROBES
+ * slots, given by the hash of its name, and every operation inspects all
+ * slots of that window, whether the key exists or not and however full the
+ * keystore is. Thus the worst case of storeKey(), loadKey() and deleteKey()
+ * is bounded by:
+ *
+ *   hashing a name of at most KeyStore_Config_MAX_NAME_LEN characters
+ *   + KeyStore_Config_RT_MAX_PROBES times comparing a hash and a name of at
+ *     most KeyStore_Config_MAX_NAME_LEN + 1 characters
+ *   + copying KeyStore_Config_RT_MAX_KEY_SIZE bytes
+ *
+ * The price is that a key is rejected with OS_ERROR_INSUFFICIENT_SPACE once
+ * its window is full, even if other slots are free.
+ *
+ * Optionally, the keystore is backed by another keystore, e.g. an
+ * OS_KeystoreFile. Changes are then written to the backend by
+ * KeyStoreRealtime_flush() only (write-behind), which is meant to be called
+ * outside of the real-time path, and keys of the backend are made available
+ * by KeyStoreRealtime_preload(). A deleted key keeps its slot until its
+ * deletion was flushed.
+ *
+ * The keystore does no locking; calls must not run concurrently.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "system_config.h"
+
+#include "OS_Keystore.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if (KeyStore_Config_RT_NUM_KEYS & (KeyStore_Config_RT_NUM_KEYS - 1)) != 0
+#error "KeyStore_Config_RT_NUM_KEYS must be a power of two"
+#endif
+#if KeyStore_Config_RT_MAX_PROBES > KeyStore_Config_RT_NUM_KEYS
+#error "KeyStore_Config_RT_MAX_PROBES must not exceed KeyStore_Config_RT_NUM_KEYS"
+#endif
+
+typedef enum
+{
+    KeyStoreRealtime_SLOT_FREE = 0,
+    KeyStoreRealtime_SLOT_CLEAN,    ///< same as in the backend, if any
+    KeyStoreRealtime_SLOT_DIRTY,    ///< stored, not yet written to the backend
+    KeyStoreRealtime_SLOT_DELETED   ///< deleted, not yet deleted in the backend
+} KeyStoreRealtime_SlotState_t;
+
+typedef struct
+{
+    uint8_t     state;
+    bool        inBackend;  ///< the backend holds a version of the key
+    uint32_t    hash;
+    char        name[KeyStore_Config_MAX_NAME_LEN + 1];
+    size_t      size;
+    uint8_t     data[KeyStore_Config_RT_MAX_KEY_SIZE];
+} KeyStoreRealtime_Slot_t;
+
+typedef struct
+{
+    OS_Keystore_Handle_t    hBackend;
+    KeyStoreRealtime_Slot_t slots[KeyStore_Config_RT_NUM_KEYS];
+    size_t                  numKeys;        ///< keys that can be loaded
+    size_t                  numPending;     ///< slots waiting for a flush
+    size_t                  flushPos;
+} KeyStoreRealtime_t;
+
+/**
+ * Initializes an empty real-time keystore; the backend is not touched.
+ *
+ * @param[out]  self        Real-time keystore to initialize
+ * @param[in]   hBackend    Keystore to write the keys to, or NULL to keep
+ *                          them in memory only
+ *
+ * @return OS_SUCCESS or OS_ERROR_INVALID_PARAMETER
+ */
+OS_Error_t
+KeyStoreRealtime_init(
+    KeyStoreRealtime_t*     self,
+    OS_Keystore_Handle_t    hBackend);
+
+/**
+ * Same as OS_Keystore_storeKey(), with a fixed worst case; keys larger than
+ * KeyStore_Config_RT_MAX_KEY_SIZE are rejected with
+ * OS_ERROR_INVALID_PARAMETER.
+ */
+OS_Error_t
+KeyStoreRealtime_storeKey(
+    KeyStoreRealtime_t*     self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize);
+
+/**
+ * Same as OS_Keystore_loadKey(), with a fixed worst case; keys of the
+ * backend are only found once they were preloaded.
+ */
+OS_Error_t
+KeyStoreRealtime_loadKey(
+    KeyStoreRealtime_t*     self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize);
+
+/**
+ * Same as OS_Keystore_deleteKey(), with a fixed worst case.
+ */
+OS_Error_t
+KeyStoreRealtime_deleteKey(
+    KeyStoreRealtime_t*     self,
+    const char*             name);
+
+/**
+ * Writes pending changes to the backend, starting where the last call left
+ * off, so the work can be spread over several calls. Not bounded; call it
+ * outside of the real-time path.
+ *
+ * @param[in]   self        Real-time keystore
+ * @param[in]   maxKeys     Maximum number of keys to write or delete in the
+ *                          backend
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_STATE if there is no backend, or the
+ *         error of the backend; the key that failed stays pending
+ */
+OS_Error_t
+KeyStoreRealtime_flush(
+    KeyStoreRealtime_t*     self,
+    size_t                  maxKeys);
+
+/**
+ * Loads a key of the backend into the keystore, so it can be loaded in the
+ * real-time path. Not bounded; call it outside of the real-time path.
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_STATE if there is no backend,
+ *         OS_ERROR_INVALID_PARAMETER if the key is in the keystore already,
+ *         OS_ERROR_INSUFFICIENT_SPACE, or the error of loading it from the
+ *         backend, i.e. OS_ERROR_BUFFER_TOO_SMALL if the key is larger than
+ *         KeyStore_Config_RT_MAX_KEY_SIZE
+ */
+OS_Error_t
+KeyStoreRealtime_preload(
+    KeyStoreRealtime_t*     self,
+    const char*             name);
+
+/**
+ * Same as OS_Keystore_wipeKeystore(), wipes the keystore and its backend,
+ * pending changes are dropped. Not bounded.
+ */
+OS_Error_t
+KeyStoreRealtime_wipeKeystore(
+    KeyStoreRealtime_t*     self);
+
+///@}
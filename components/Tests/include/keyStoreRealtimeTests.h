@@ -0,0 +1,83 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreRealtimeTests.h
+ *
+ * @brief collection of tests for the real-time keystore of
+ *        keyStoreRealtime.h
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+
+#include <stddef.h>
+
+/**
+ * @weakgroup KeyStore_Realtime_test_cases
+ * @{
+ *
+ * @brief               Test scenario which performs tests for the real-time
+ *                      keystore, in memory only and in front of a backend
+ *
+ * @param hBackend      handle to the keystore used as backend, its content is
+ *                      wiped; NULL to skip the tests of a backend
+ *
+ *
+ * @test \b TestKeyStore_testCase_48    Store, load and delete keys and verify
+ *                                      the same results as with OS_Keystore,
+ *                                      also for invalid parameters, existing
+ *                                      and missing keys and small buffers
+ *
+ * @test \b TestKeyStore_testCase_49    Store keys until they are rejected,
+ *                                      verify every stored key, and verify
+ *                                      that a rejected key fits once keys
+ *                                      were deleted
+ *
+ * @test \b TestKeyStore_testCase_50    Verify that changes reach the backend
+ *                                      only when flushed, also in parts, and
+ *                                      that keys preloaded from the backend
+ *                                      can be loaded
+ *
+ * @test \b TestKeyStore_testCase_51    Verify that storing, loading and
+ *                                      deleting keys does not allocate memory,
+ *                                      also with a backend; only built with
+ *                                      KeyStoreAlloc_Config_ENABLED
+ *
+ * @}
+ *
+ */
+void keyStoreRealtimeTests(
+    OS_Keystore_Handle_t hBackend);
+
+/**
+ * Runs KeyStore_Config_RT_NUM_OPS random stores, loads and deletes on the
+ * real-time keystore and on the given keystores, takes the time of every
+ * single operation and reports the average and the maximum latency per
+ * operation, as well as the latency 99.99% of them stay below. The runs on
+ * a KeystoreFile, directly and behind the real-time keystore, do fewer
+ * operations.
+ *
+ * The test fails if an operation of the real-time keystore allocates memory,
+ * which is only counted with KeyStoreAlloc_Config_ENABLED, or, with
+ * KeyStore_Config_RT_MAX_CYCLES set, takes more cycles than that.
+ *
+ * @param[in]   hRamFV          Handle to a KeystoreRamFV, its content is
+ *                              wiped; NULL to skip it
+ * @param[in]   ramFVCapacity   Number of keys the KeystoreRamFV can hold
+ * @param[in]   hFile           Handle to a KeystoreFile, its content is
+ *                              wiped; NULL to skip it
+ */
+void keyStoreRealtimeBenchmark(
+    OS_Keystore_Handle_t hRamFV,
+    size_t               ramFVCapacity,
+    OS_Keystore_Handle_t hFile);
+
+///@}
@@ -0,0 +1,49 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreSeededEntropy.h
+ *
+ * @brief deterministic entropy source for reproducible key generation
+ *
+ * The source offers an if_OS_Entropy_t which can be passed to OS_Crypto
+ * instead of the one of the EntropySource component. It returns a fixed
+ * pseudorandom stream derived from a seed, so the DRBG of the crypto library
+ * and every key generated with it depend on the seed only.
+ *
+ * This is meant for tests and for reproducing provisioning runs; keys
+ * generated with it are predictable and must never be used in the field.
+ *
+ * As the read function of if_OS_Entropy_t has no context parameter, there is
+ * only one stream per component.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Crypto.h"
+
+#include <stdint.h>
+
+/**
+ * Restarts the stream from a seed.
+ *
+ * @param[in]   seed    Seed of the stream
+ */
+void
+KeyStoreSeededEntropy_init(
+    uint64_t    seed);
+
+/**
+ * Returns the interface to be put into OS_Crypto_Config_t.entropy.
+ */
+const if_OS_Entropy_t*
+KeyStoreSeededEntropy_getInterface(
+    void);
+
+///@}
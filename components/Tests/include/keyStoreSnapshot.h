@@ -0,0 +1,169 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreSnapshot.h
+ *
+ * @brief copy-on-write snapshots of a keystore instance
+ *
+ * Taking a snapshot copies no key. Afterwards, the first modification of a
+ * key in the live keystore saves its old data into a shadow keystore; keys
+ * that were not there when the snapshot was taken are only remembered by
+ * name. Unchanged keys are read from the live keystore, so the snapshot and
+ * the live keystore share their storage.
+ *
+ * The snapshot can be read, rolled back into the live keystore or released.
+ * Only one snapshot exists at a time, and the snapshot only stays consistent
+ * if all modifications of the live keystore go through the functions of this
+ * module while it exists.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Maximum number of keys that can be modified while a snapshot exists
+#define KeyStoreSnapshot_MAX_CHANGED_KEYS   32
+
+typedef struct
+{
+    bool    valid;
+    char    name[16];
+    /**
+     * Set if the key existed when the snapshot was taken, its data then is
+     * in the shadow keystore.
+     */
+    bool    existed;
+} KeyStoreSnapshot_Change_t;
+
+typedef struct
+{
+    OS_Keystore_Handle_t        hLive;
+    OS_Keystore_Handle_t        hShadow;
+    bool                        taken;
+    KeyStoreSnapshot_Change_t   changes[KeyStoreSnapshot_MAX_CHANGED_KEYS];
+    size_t                      numPreserved;
+} KeyStoreSnapshot_t;
+
+/**
+ * Initializes the snapshot support of a keystore and wipes the shadow
+ * keystore.
+ *
+ * @param[out]  self        Snapshot support to initialize
+ * @param[in]   hLive       Keystore to take snapshots of
+ * @param[in]   hShadow     Keystore that keeps the old data of keys changed
+ *                          while a snapshot exists, must not be used
+ *                          otherwise
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_PARAMETER or the error of wiping the
+ *         shadow keystore
+ */
+OS_Error_t
+KeyStoreSnapshot_init(
+    KeyStoreSnapshot_t*     self,
+    OS_Keystore_Handle_t    hLive,
+    OS_Keystore_Handle_t    hShadow);
+
+/**
+ * Takes a snapshot of the live keystore, which copies no key data.
+ *
+ * @return OS_SUCCESS or OS_ERROR_INVALID_STATE if a snapshot exists already
+ */
+OS_Error_t
+KeyStoreSnapshot_take(
+    KeyStoreSnapshot_t*     self);
+
+/**
+ * Same as OS_Keystore_loadKey(), but reads the key as it was when the
+ * snapshot was taken.
+ *
+ * @return OS_ERROR_INVALID_STATE if no snapshot exists, otherwise the same as
+ *         OS_Keystore_loadKey()
+ */
+OS_Error_t
+KeyStoreSnapshot_loadSnapshotKey(
+    KeyStoreSnapshot_t*     self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize);
+
+/**
+ * Restores the live keystore to the state of the snapshot and releases the
+ * snapshot.
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_STATE if no snapshot exists or the
+ *         error of restoring a key; in that case the snapshot is kept, so the
+ *         rollback can be retried
+ */
+OS_Error_t
+KeyStoreSnapshot_rollback(
+    KeyStoreSnapshot_t*     self);
+
+/**
+ * Releases the snapshot, keeping the live keystore as it is.
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_STATE if no snapshot exists or the
+ *         error of wiping the shadow keystore
+ */
+OS_Error_t
+KeyStoreSnapshot_release(
+    KeyStoreSnapshot_t*     self);
+
+/**
+ * Same as OS_Keystore_storeKey() on the live keystore.
+ *
+ * @return OS_ERROR_INSUFFICIENT_SPACE if a new key is stored after
+ *         KeyStoreSnapshot_MAX_CHANGED_KEYS keys were changed since the
+ *         snapshot was taken, otherwise the same as OS_Keystore_storeKey()
+ */
+OS_Error_t
+KeyStoreSnapshot_storeKey(
+    KeyStoreSnapshot_t*     self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize);
+
+/**
+ * Same as OS_Keystore_loadKey() on the live keystore.
+ */
+OS_Error_t
+KeyStoreSnapshot_loadKey(
+    KeyStoreSnapshot_t*     self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize);
+
+/**
+ * Same as OS_Keystore_deleteKey() on the live keystore; the data of the key is
+ * saved in the shadow keystore first if a snapshot needs it.
+ *
+ * @return OS_ERROR_INSUFFICIENT_SPACE if an existing key is deleted after
+ *         KeyStoreSnapshot_MAX_CHANGED_KEYS keys were changed since the
+ *         snapshot was taken or the shadow keystore is full, otherwise the
+ *         same as OS_Keystore_deleteKey()
+ */
+OS_Error_t
+KeyStoreSnapshot_deleteKey(
+    KeyStoreSnapshot_t*     self,
+    const char*             name);
+
+/**
+ * Same as OS_Keystore_wipeKeystore() on the live keystore.
+ *
+ * @return OS_ERROR_INVALID_STATE if a snapshot exists, as the keys to save
+ *         are not known, otherwise the same as OS_Keystore_wipeKeystore()
+ */
+OS_Error_t
+KeyStoreSnapshot_wipeKeystore(
+    KeyStoreSnapshot_t*     self);
+
+///@}
@@ -0,0 +1,71 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreSnapshotTests.h
+ *
+ * @brief collection of tests for copy-on-write snapshots of a keystore
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+
+/**
+ * @weakgroup KeyStore_Snapshot_test_cases
+ * @{
+ *
+ * @brief               Test scenario which takes snapshots of a keystore,
+ *                      modifies the keystore and rolls it back
+ *
+ * @param hLive         handle to the keyStore to take snapshots of
+ * @param hShadow       handle to a keyStore keeping the data of changed keys,
+ *                      it is wiped by the tests
+ *
+ *
+ * @test \b TestKeyStore_testCase_38    Take a snapshot, store, delete and replace
+ *                                      keys and verify that the snapshot still
+ *                                      shows the old keys while only the changed
+ *                                      keys were copied
+ *
+ * @test \b TestKeyStore_testCase_39    Roll back a modified keystore and verify
+ *                                      that it is restored exactly, then release
+ *                                      a snapshot and verify that the changes
+ *                                      are kept
+ *
+ * @test \b TestKeyStore_testCase_53    Fill the change log of a snapshot and
+ *                                      verify that only storing new keys and
+ *                                      deleting existing ones are rejected for
+ *                                      lack of space, while other calls fail as
+ *                                      without the snapshot, and that releasing
+ *                                      the snapshot empties the shadow keystore
+ *
+ * @}
+ *
+ */
+void keyStoreSnapshotTests(
+    OS_Keystore_Handle_t hLive,
+    OS_Keystore_Handle_t hShadow);
+
+/**
+ * Measures a full backup of a keystore by copying every key compared to
+ * taking a snapshot and rotating some of the keys afterwards, and reports the
+ * number of keys the snapshot had to copy.
+ *
+ * @param[in]   hLive       Handle to the keystore to take snapshots of
+ * @param[in]   hShadow     Handle to a second keystore, it is wiped
+ * @param[in]   backend     Name of the keystore implementation behind the
+ *                          handles, used for reporting
+ */
+void keyStoreSnapshotBenchmark(
+    OS_Keystore_Handle_t hLive,
+    OS_Keystore_Handle_t hShadow,
+    const char*          backend);
+
+///@}
@@ -0,0 +1,39 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreStatic.h
+ *
+ * @brief selection of the keystore backends the test is built for
+ *
+ * With KeyStore_Config_STATIC_BACKEND set, the test is built for that
+ * backend only, so the other backend is neither tested nor linked. The calls
+ * of the OS_Keystore API still go through the dispatch of the SDK, whose
+ * backend entry points are not public.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "system_config.h"
+
+#if defined(KeyStore_Config_STATIC_BACKEND)
+#   if (KeyStore_Config_STATIC_BACKEND != KeyStore_BACKEND_FILE) \
+       && (KeyStore_Config_STATIC_BACKEND != KeyStore_BACKEND_RAMFV)
+#       error "KeyStore_Config_STATIC_BACKEND is not a known backend"
+#   endif
+#   define KeyStoreStatic_HAS_FILE \
+        (KeyStore_Config_STATIC_BACKEND == KeyStore_BACKEND_FILE)
+#   define KeyStoreStatic_HAS_RAMFV \
+        (KeyStore_Config_STATIC_BACKEND == KeyStore_BACKEND_RAMFV)
+#else
+#   define KeyStoreStatic_HAS_FILE      1
+#   define KeyStoreStatic_HAS_RAMFV     1
+#endif
+
+///@}
@@ -0,0 +1,123 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreTiered.h
+ *
+ * @brief keystore combining a bounded hot tier (e.g. an OS_KeystoreRamFV)
+ *        with a persistent cold tier (e.g. an OS_KeystoreFile)
+ *
+ * The cold tier holds every key and is always written first (write-through),
+ * so it stays the durable copy. The hot tier holds copies of recently or
+ * frequently used keys: keys are promoted into it when they are stored or
+ * loaded from the cold tier, and the least recently or least frequently used
+ * key is dropped from it when it is full.
+ *
+ * The hot tier is wiped at initialization and must not be used otherwise
+ * while it is part of a tiered keystore.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Maximum number of keys tracked in the hot tier
+#define KeyStoreTiered_MAX_HOT_KEYS     32
+
+typedef enum
+{
+    KeyStoreTiered_EVICT_LRU,   ///< drop the least recently used key
+    KeyStoreTiered_EVICT_LFU    ///< drop the least frequently used key
+} KeyStoreTiered_Policy_t;
+
+typedef struct
+{
+    bool        valid;
+    char        name[16];
+    uint32_t    lastUse;
+    uint32_t    uses;
+} KeyStoreTiered_HotEntry_t;
+
+typedef struct
+{
+    OS_Keystore_Handle_t        hHot;
+    OS_Keystore_Handle_t        hCold;
+    KeyStoreTiered_Policy_t     policy;
+    size_t                      hotCapacity;
+    KeyStoreTiered_HotEntry_t   hot[KeyStoreTiered_MAX_HOT_KEYS];
+    uint32_t                    clock;
+    size_t                      numHits;
+    size_t                      numMisses;
+    size_t                      numEvictions;
+} KeyStoreTiered_t;
+
+/**
+ * Initializes a tiered keystore and wipes its hot tier.
+ *
+ * @param[out]  self            Tiered keystore to initialize
+ * @param[in]   hHot            Keystore used as hot tier
+ * @param[in]   hotCapacity     Maximum number of keys to keep in the hot tier,
+ *                              at most KeyStoreTiered_MAX_HOT_KEYS; if the hot
+ *                              tier fills up earlier, keys are evicted then
+ * @param[in]   hCold           Keystore used as cold tier
+ * @param[in]   policy          Eviction policy of the hot tier
+ *
+ * @return OS_SUCCESS, OS_ERROR_INVALID_PARAMETER or the error of wiping the
+ *         hot tier
+ */
+OS_Error_t
+KeyStoreTiered_init(
+    KeyStoreTiered_t*       self,
+    OS_Keystore_Handle_t    hHot,
+    size_t                  hotCapacity,
+    OS_Keystore_Handle_t    hCold,
+    KeyStoreTiered_Policy_t policy);
+
+/**
+ * Same as OS_Keystore_storeKey(); the key is written to the cold tier and
+ * then promoted into the hot tier.
+ */
+OS_Error_t
+KeyStoreTiered_storeKey(
+    KeyStoreTiered_t*       self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize);
+
+/**
+ * Same as OS_Keystore_loadKey(); keys found in the cold tier only are
+ * promoted into the hot tier.
+ */
+OS_Error_t
+KeyStoreTiered_loadKey(
+    KeyStoreTiered_t*       self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize);
+
+/**
+ * Same as OS_Keystore_deleteKey(), removes the key from both tiers.
+ */
+OS_Error_t
+KeyStoreTiered_deleteKey(
+    KeyStoreTiered_t*       self,
+    const char*             name);
+
+/**
+ * Same as OS_Keystore_wipeKeystore(), wipes both tiers.
+ */
+OS_Error_t
+KeyStoreTiered_wipeKeystore(
+    KeyStoreTiered_t*       self);
+
+///@}
@@ -0,0 +1,66 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreTieredTests.h
+ *
+ * @brief collection of tests for the keystore with a hot and a cold tier
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+
+/**
+ * @weakgroup KeyStore_Tiered_test_cases
+ * @{
+ *
+ * @brief               Test scenario which performs tests for a keystore made
+ *                      of a bounded hot tier in front of a persistent cold tier
+ *
+ * @param hHot          handle to the keystore used as hot tier, its content is
+ *                      wiped
+ * @param hotCapacity   number of keys the hot tier can hold
+ * @param hCold         handle to the keystore used as cold tier
+ *
+ *
+ * @test \b TestKeyStore_testCase_28    Store more keys than the hot tier can hold,
+ *                                      also with a configured capacity beyond the
+ *                                      one of the hot tier, and verify that all keys
+ *                                      can be loaded, are in the cold tier and that
+ *                                      deleted keys are gone from both tiers
+ *
+ * @test \b TestKeyStore_testCase_29    Load keys with a skewed (Zipfian) access
+ *                                      pattern and verify that the hot tier serves
+ *                                      more loads than it would with uniform accesses,
+ *                                      for both the LRU and the LFU policy
+ *
+ * @}
+ *
+ */
+void keyStoreTieredTests(
+    OS_Keystore_Handle_t hHot,
+    int                  hotCapacity,
+    OS_Keystore_Handle_t hCold);
+
+/**
+ * Measures the latency of loading keys with a skewed (Zipfian) access pattern
+ * through the tiered keystore compared to loading them from the cold tier, and
+ * reports the hit rate of the hot tier.
+ *
+ * @param[in]   hHot        Handle to the keystore used as hot tier
+ * @param[in]   hotCapacity Number of keys the hot tier can hold
+ * @param[in]   hCold       Handle to the keystore used as cold tier
+ */
+void keyStoreTieredBenchmark(
+    OS_Keystore_Handle_t hHot,
+    int                  hotCapacity,
+    OS_Keystore_Handle_t hCold);
+
+///@}
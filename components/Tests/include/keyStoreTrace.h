@@ -0,0 +1,106 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreTrace.h
+ *
+ * @brief trace points with cycle counter timestamps, to break the latency of
+ *        keystore operations down into the phases they spend it in
+ *
+ * The trace points are set by keyStoreTraceWrap.c around the entry points of
+ * the keystore, the file system, the crypto digests and the storage RPC. The
+ * linker routes every call to them through the wrappers, including the calls
+ * the keystore backends make internally (see keyStoreTrace.cmake).
+ *
+ * Time spent in a phase is counted for the innermost phase only, so it is
+ * split up as follows:
+ * - keystore: checking the parameters and the logic of the backend
+ * - filesystem: the file system, without its storage accesses
+ * - storage: the RPC round trip to the storage, e.g. the RamDisk
+ * - crypto: digests computed with the crypto instance of the keystore
+ *
+ * Tracing is compiled in with KeyStoreTrace_Config_ENABLED, which the build
+ * option KEYSTORE_TRACE sets along with linking the wrappers; otherwise the
+ * trace points compile to nothing and the functions are not wrapped. With
+ * KeyStoreTrace_Config_CHROME_FORMAT, the events are dumped in the Chrome
+ * trace event format instead of the breakdown per operation.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "system_config.h"
+
+#include <stddef.h>
+
+// Starts every line of a dump in the Chrome trace event format
+#define KeyStoreTrace_JSON_TAG      "KEYSTORE_TRACE"
+
+// Maximum nesting of phases
+#define KeyStoreTrace_MAX_DEPTH     8
+// Number of distinct operations the breakdown is kept for
+#define KeyStoreTrace_MAX_OPS       16
+
+#if !defined(KeyStoreTrace_Config_MAX_EVENTS)
+#define KeyStoreTrace_Config_MAX_EVENTS     1024
+#endif
+
+typedef enum
+{
+    KeyStoreTrace_PHASE_KEYSTORE,
+    KeyStoreTrace_PHASE_FILESYSTEM,
+    KeyStoreTrace_PHASE_STORAGE,
+    KeyStoreTrace_PHASE_CRYPTO,
+    KeyStoreTrace_NUM_PHASES
+} KeyStoreTrace_Phase_t;
+
+#if defined(KeyStoreTrace_Config_ENABLED)
+#   define KeyStoreTrace_BEGIN(_phase_, _name_) \
+        KeyStoreTrace_begin(_phase_, _name_)
+#   define KeyStoreTrace_END()  KeyStoreTrace_end()
+#else
+#   define KeyStoreTrace_BEGIN(_phase_, _name_)
+#   define KeyStoreTrace_END()
+#endif
+
+/**
+ * Enters a phase. The outermost phase names the operation the time of all
+ * phases nested in it is accounted to.
+ *
+ * @param[in]   phase       Phase that is entered
+ * @param[in]   name        Name of the traced function, must be a literal
+ */
+void
+KeyStoreTrace_begin(
+    KeyStoreTrace_Phase_t   phase,
+    const char*             name);
+
+/**
+ * Leaves the phase entered last.
+ */
+void
+KeyStoreTrace_end(
+    void);
+
+/**
+ * Prints what was traced since the last dump on the log and starts over;
+ * does nothing unless tracing is compiled in.
+ *
+ * By default, a table is printed with the number of calls of each operation
+ * and the cycles per call it spent in each phase. In the Chrome trace event
+ * format, every event is printed on a line of its own after
+ * KeyStoreTrace_JSON_TAG, tools/trace_to_chrome.py collects them into a
+ * file for chrome://tracing or Perfetto.
+ *
+ * @param[in]   scenario    Name of the test scenario that was traced
+ */
+void
+KeyStoreTrace_dump(
+    const char*             scenario);
+
+///@}
@@ -0,0 +1,226 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreVersioned.h
+ *
+ * @brief keystore layer with per-key generation numbers and compare-and-swap
+ *        replacement of keys
+ *
+ * Every key is kept in one of two slots in the underlying keystore, each slot
+ * holding a small header with the generation of the key in front of the key
+ * data. Replacing a key writes the new generation into the free slot before
+ * the old slot is deleted, so the key is never missing in between; readers
+ * always pick the slot with the newer generation.
+ *
+ * The header also carries the size, creation time and type tag of the key.
+ * These are kept in a small cache, so KeyStoreVersioned_statKey() needs no
+ * access to the keystore for recently used keys, and loading a key reads
+ * only the slot it is cached in. The metadata returned by statKey() may be
+ * stale if the key was changed by another instance.
+ *
+ * Replacing a cached key writes the free slot right away and then reads the
+ * old slot once to check that it still holds the expected generation, before
+ * deleting it. A key replaced by another instance in between is detected
+ * either by the free slot being taken or by that check, and the replacement
+ * is rolled back. Slots are only deleted right after they were read and found
+ * to hold the expected or an older generation. As the keystore cannot delete
+ * a key conditionally, a replacement by another instance between that read
+ * and the delete can still be lost, so writers of the same key on different
+ * instances have to be serialized for full safety.
+ *
+ * Only keys written by this layer can be accessed through it, as keys are
+ * looked up by their slot names.
+ *
+ * Slot names are built by appending two characters to the key name, which
+ * limits key names to KeyStoreVersioned_MAX_NAME_LEN characters.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+#include "OS_KeystoreRamFV.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define KeyStoreVersioned_MAX_NAME_LEN      13
+// Both keystore implementations have the same maximum key size
+#define KeyStoreVersioned_MAX_RECORD_SIZE   OS_KeystoreRamFV_MAX_KEY_SIZE
+// Number of keys whose metadata is cached
+#define KeyStoreVersioned_CACHE_SIZE        16
+
+// Marks the records written by this layer
+#define KeyStoreVersioned_RECORD_MAGIC      0x4b53564eu
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t generation;
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t createdAt;
+} KeyStoreVersioned_Header_t;
+
+#define KeyStoreVersioned_MAX_KEY_SIZE \
+    (KeyStoreVersioned_MAX_RECORD_SIZE - sizeof(KeyStoreVersioned_Header_t))
+
+// Generation reported for keys that do not exist
+#define KeyStoreVersioned_GENERATION_NONE   0
+// Type tag of keys stored without one
+#define KeyStoreVersioned_TYPE_NONE         0
+
+/**
+ * Metadata of a key as returned by KeyStoreVersioned_statKey().
+ */
+typedef struct
+{
+    bool        exists;
+    size_t      size;       ///< size of the key data
+    uint64_t    createdAt;  ///< time the first generation was stored
+    uint32_t    type;       ///< type tag given when the key was stored
+    uint32_t    generation;
+} KeyStoreVersioned_Info_t;
+
+typedef struct
+{
+    bool        valid;
+    char        name[KeyStoreVersioned_MAX_NAME_LEN + 1];
+    int         slot;       ///< slot holding the current generation
+    bool        hasStale;   ///< other slot holds an old generation
+    KeyStoreVersioned_Info_t info;
+} KeyStoreVersioned_CacheEntry_t;
+
+typedef struct
+{
+    OS_Keystore_Handle_t            hKeystore;
+    uint64_t                        (*getTime)(void);
+    KeyStoreVersioned_CacheEntry_t  cache[KeyStoreVersioned_CACHE_SIZE];
+    size_t                          nextVictim;
+    // Accesses to the underlying keystore
+    size_t                          numLoads;
+    size_t                          numStores;
+    size_t                          numDeletes;
+    uint8_t                         record[KeyStoreVersioned_MAX_RECORD_SIZE];
+    uint8_t                         other[KeyStoreVersioned_MAX_RECORD_SIZE];
+} KeyStoreVersioned_t;
+
+/**
+ * Initializes the layer on top of a keystore.
+ *
+ * @param[out]  self        Layer to initialize
+ * @param[in]   hKeystore   Underlying keystore
+ *
+ * @return OS_SUCCESS or OS_ERROR_INVALID_PARAMETER
+ */
+OS_Error_t
+KeyStoreVersioned_init(
+    KeyStoreVersioned_t*    self,
+    OS_Keystore_Handle_t    hKeystore);
+
+/**
+ * Sets the clock used for the creation time of keys; without a clock, the
+ * creation time is always 0.
+ */
+void
+KeyStoreVersioned_setTimeSource(
+    KeyStoreVersioned_t*    self,
+    uint64_t                (*getTime)(void));
+
+/**
+ * Stores a new key with generation 1; like OS_Keystore_storeKey() it fails
+ * with OS_ERROR_INVALID_PARAMETER if the key exists already.
+ */
+OS_Error_t
+KeyStoreVersioned_storeKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize);
+
+/**
+ * Same as KeyStoreVersioned_storeKey(), additionally tags the key with a type
+ * which is kept for all generations of the key.
+ */
+OS_Error_t
+KeyStoreVersioned_storeTypedKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    uint32_t                type,
+    void const*             keyData,
+    size_t                  keySize);
+
+/**
+ * Replaces a key if its generation is still expectedGeneration. On success
+ * the key has generation expectedGeneration + 1. Passing
+ * KeyStoreVersioned_GENERATION_NONE creates a key which does not exist yet.
+ *
+ * @param[in]   self                Layer
+ * @param[in]   name                Name of the key
+ * @param[in]   keyData             New key data
+ * @param[in]   keySize             Size of the new key data
+ * @param[in]   expectedGeneration  Generation the caller has last seen
+ *
+ * @return OS_SUCCESS, OS_ERROR_ABORTED if the key has been replaced (or
+ *         created, or deleted) by someone else in the meantime, or the error
+ *         of the underlying keystore
+ */
+OS_Error_t
+KeyStoreVersioned_replaceKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize,
+    uint32_t                expectedGeneration);
+
+/**
+ * Same as OS_Keystore_loadKey(), additionally returns the generation of the
+ * key if generation is not NULL.
+ */
+OS_Error_t
+KeyStoreVersioned_loadKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize,
+    uint32_t*               generation);
+
+/**
+ * Returns the metadata of a key without copying out the key data. For keys
+ * in the cache, the keystore is not accessed at all. Otherwise both slots of
+ * the key are loaded in full, as the header can't be read on its own; that is
+ * one load more than probing a plain key with a zero-sized buffer.
+ *
+ * Only keys written by this layer are known, keys stored directly with
+ * OS_Keystore_storeKey() are reported as missing.
+ *
+ * @param[in]   self        Layer
+ * @param[in]   name        Name of the key
+ * @param[out]  info        Metadata of the key, info->exists is false if
+ *                          there is no such key
+ *
+ * @return OS_SUCCESS, OS_ERROR_NOT_FOUND, OS_ERROR_INVALID_PARAMETER or the
+ *         error of the underlying keystore
+ */
+OS_Error_t
+KeyStoreVersioned_statKey(
+    KeyStoreVersioned_t*        self,
+    const char*                 name,
+    KeyStoreVersioned_Info_t*   info);
+
+/**
+ * Same as OS_Keystore_deleteKey().
+ */
+OS_Error_t
+KeyStoreVersioned_deleteKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name);
+
+///@}
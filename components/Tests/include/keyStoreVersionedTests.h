@@ -0,0 +1,82 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file keyStoreVersionedTests.h
+ *
+ * @brief collection of tests for keys with generation numbers, their
+ *        compare-and-swap replacement and their metadata
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Keystore.h"
+
+/**
+ * @weakgroup KeyStore_Versioned_test_cases
+ * @{
+ *
+ * @brief               Test scenario which performs tests for the replacement
+ *                      of keys based on their generation and for the query of
+ *                      key metadata
+ *
+ * @param hKeystore     handle to the keyStore, it can represent a local instance
+ *                      of the key store library, or a handle to the context which
+ *                      is created in a separate camkes component
+ *
+ *
+ * @test \b TestKeyStore_testCase_23    Store a key, replace it and verify that the
+ *                                      generation is counted up and only one copy
+ *                                      of the key is left in the keystore
+ *
+ * @test \b TestKeyStore_testCase_24    Let two clients, each with a layer of its own
+ *                                      on the same keystore, rotate the same key based
+ *                                      on the same generation and verify that only the
+ *                                      first one succeeds, its key survives and the
+ *                                      second one can retry; also for a key deleted
+ *                                      and created again in the meantime
+ *
+ * @test \b TestKeyStore_testCase_54    Let a client rotate a key based on the generation
+ *                                      in its cache after another client has rotated it
+ *                                      twice and verify that the rotation is rejected
+ *                                      and the key of the other client survives; count
+ *                                      the keystore accesses of a rotation
+ *
+ * @test \b TestKeyStore_testCase_25    Leave an old generation of a key behind, as an
+ *                                      interrupted rotation would do, and verify that
+ *                                      it is ignored and cleaned up
+ *
+ * @test \b TestKeyStore_testCase_26    Query the metadata of a key and verify that it
+ *                                      is kept over rotations and restarts
+ *
+ * @test \b TestKeyStore_testCase_27    Compare the keystore accesses needed to size a
+ *                                      buffer with statKey() against probing with a
+ *                                      zero-sized buffer, with a warm and a cold cache,
+ *                                      and verify that keys not written by the layer
+ *                                      are not found
+ *
+ * @}
+ *
+ */
+void keyStoreVersionedTests(
+    OS_Keystore_Handle_t hKeystore);
+
+/**
+ * Measures the rate at which a key can be rotated with replaceKey() compared
+ * to deleting and storing it again.
+ *
+ * @param[in]   hKeystore   Handle to the keystore
+ * @param[in]   backend     Name of the keystore implementation behind the
+ *                          handle, used for reporting
+ */
+void keyStoreVersionedBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    const char*          backend);
+
+///@}
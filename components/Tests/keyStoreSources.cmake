@@ -0,0 +1,69 @@
+#
+# Test Keystore, sources and libraries of the test component, shared by the
+# CAmkES system and the host build
+#
+# Copyright (C) 2024, HENSOLDT Cyber GmbH
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+
+set(KEYSTORE_TEST_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+set(KEYSTORE_TEST_INCLUDES
+    ${KEYSTORE_TEST_DIR}/include
+)
+
+set(KEYSTORE_TEST_SOURCES "")
+foreach(src
+    test_OS_Keystore.c
+    keyStoreUnitTests.c
+    keyStoreIntegrationTests.c
+    keyStoreMultiInstanceTests.c
+    keyStoreBloomTests.c
+    keyStoreBloom.c
+    keyStoreEntropyPoolTests.c
+    keyStoreEntropyPool.c
+    keyStoreVersionedTests.c
+    keyStoreVersioned.c
+    keyStoreTieredTests.c
+    keyStoreTiered.c
+    keyStoreDerivedTests.c
+    keyStoreDerived.c
+    keyStoreCipherPoolTests.c
+    keyStoreCipherPool.c
+    keyStoreProvisioningTests.c
+    keyStoreProvisioning.c
+    keyStoreSeededEntropy.c
+    keyStoreSnapshotTests.c
+    keyStoreSnapshot.c
+    keyStoreChecksumTests.c
+    keyStoreChecksum.c
+    keyStoreCrc32c.c
+    keyStoreRamFVImageTests.c
+    keyStoreRamFVImage.c
+    keyStoreManagerTests.c
+    keyStoreManager.c
+    keyStoreRamFVScaleTests.c
+    keyStoreRealtimeTests.c
+    keyStoreRealtime.c
+    keyStoreTrace.c
+    keyStoreBenchmark.c
+)
+    list(APPEND KEYSTORE_TEST_SOURCES ${KEYSTORE_TEST_DIR}/src/${src})
+endforeach()
+
+# The wrappers of keyStoreTrace.cmake are added by the build options there
+
+# Libraries of the SDK the test links against; the CAmkES system adds
+# sel4bench, which the host build replaces with a header
+set(KEYSTORE_TEST_LIBS
+    os_core_api
+    lib_debug
+    lib_macros
+    os_keystore_file
+    os_keystore_ram_fv
+    os_filesystem
+    os_crypto
+)
@@ -0,0 +1,70 @@
+#
+# Test Keystore, functions wrapped by keyStoreTraceWrap.c and
+# keyStoreAllocWrap.c
+#
+# Copyright (C) 2024, HENSOLDT Cyber GmbH
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+
+# Both are off by default, so a normal build calls the SDK and the allocator
+# directly
+option(KEYSTORE_TRACE
+    "Trace the phases of keystore operations, see keyStoreTrace.h" OFF)
+option(KEYSTORE_COUNT_ALLOCS
+    "Count the calls of the allocator, see keyStoreAlloc.h" OFF)
+
+# Calls of these functions, also from within the SDK libraries, are routed
+# through the trace points of keyStoreTrace.h
+set(KEYSTORE_TRACE_WRAPPED
+    OS_Keystore_storeKey
+    OS_Keystore_loadKey
+    OS_Keystore_deleteKey
+    OS_Keystore_copyKey
+    OS_Keystore_moveKey
+    OS_Keystore_wipeKeystore
+    OS_FileSystemFile_open
+    OS_FileSystemFile_close
+    OS_FileSystemFile_read
+    OS_FileSystemFile_write
+    OS_FileSystemFile_delete
+    OS_FileSystemFile_getSize
+    OS_CryptoDigest_init
+    OS_CryptoDigest_process
+    OS_CryptoDigest_finalize
+    storage_rpc_write
+    storage_rpc_read
+    storage_rpc_erase
+)
+
+# Calls of the allocator are counted, see keyStoreAlloc.h
+set(KEYSTORE_ALLOC_WRAPPED
+    malloc
+    calloc
+    realloc
+)
+
+# Sources, compiler and linker flags to add to the test component
+set(KEYSTORE_TRACE_SOURCES "")
+set(KEYSTORE_TRACE_C_FLAGS "")
+set(KEYSTORE_TRACE_LD_FLAGS "")
+
+if(KEYSTORE_TRACE)
+    list(APPEND KEYSTORE_TRACE_SOURCES
+        ${CMAKE_CURRENT_LIST_DIR}/src/keyStoreTraceWrap.c)
+    list(APPEND KEYSTORE_TRACE_C_FLAGS -DKeyStoreTrace_Config_ENABLED)
+    foreach(fn ${KEYSTORE_TRACE_WRAPPED})
+        list(APPEND KEYSTORE_TRACE_LD_FLAGS "-Wl,--wrap=${fn}")
+    endforeach()
+endif()
+
+if(KEYSTORE_COUNT_ALLOCS)
+    list(APPEND KEYSTORE_TRACE_SOURCES
+        ${CMAKE_CURRENT_LIST_DIR}/src/keyStoreAllocWrap.c)
+    list(APPEND KEYSTORE_TRACE_C_FLAGS -DKeyStoreAlloc_Config_ENABLED)
+    foreach(fn ${KEYSTORE_ALLOC_WRAPPED})
+        list(APPEND KEYSTORE_TRACE_LD_FLAGS "-Wl,--wrap=${fn}")
+    endforeach()
+endif()
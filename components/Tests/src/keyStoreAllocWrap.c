@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/*
+ * Wrappers counting the calls of the allocator for keyStoreAlloc.h. The
+ * linker binds every call of a wrapped function to __wrap_<function> and the
+ * original to __real_<function>, see keyStoreTrace.cmake.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreAlloc.h"
+
+#include <stddef.h>
+
+/* Original functions, bound by the linker -----------------------------------*/
+void*
+__real_malloc(
+    size_t size);
+void*
+__real_calloc(
+    size_t nmemb,
+    size_t size);
+void*
+__real_realloc(
+    void*  ptr,
+    size_t size);
+
+/* Private variables ---------------------------------------------------------*/
+static size_t numAllocs;
+
+/* Public functions -----------------------------------------------------------*/
+void*
+__wrap_malloc(
+    size_t size)
+{
+    numAllocs++;
+    return __real_malloc(size);
+}
+
+void*
+__wrap_calloc(
+    size_t nmemb,
+    size_t size)
+{
+    numAllocs++;
+    return __real_calloc(nmemb, size);
+}
+
+void*
+__wrap_realloc(
+    void*  ptr,
+    size_t size)
+{
+    numAllocs++;
+    return __real_realloc(ptr, size);
+}
+
+size_t
+KeyStoreAlloc_getCount(
+    void)
+{
+    return numAllocs;
+}
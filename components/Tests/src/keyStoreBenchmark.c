@@ -0,0 +1,56 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "system_config.h"
+
+#include "keyStoreBenchmark.h"
+#include "lib_debug/Debug.h"
+
+#include <stdio.h>
+
+#include <sel4bench/sel4bench.h>
+
+/* Public functions -----------------------------------------------------------*/
+void
+KeyStoreBenchmark_init(
+    void)
+{
+    sel4bench_init();
+}
+
+KeyStoreBenchmark_Cycles_t
+KeyStoreBenchmark_getCycles(
+    void)
+{
+    return (KeyStoreBenchmark_Cycles_t) sel4bench_get_cycle_count();
+}
+
+void
+KeyStoreBenchmark_report(
+    const char*                 op,
+    const char*                 backend,
+    size_t                      keySize,
+    size_t                      count,
+    KeyStoreBenchmark_Cycles_t  cycles)
+{
+    unsigned long long perOp = count ? cycles / count : 0;
+
+#if defined(KeyStoreBenchmark_Config_JSON_OUTPUT)
+    // Printed without the log prefix, so every result is exactly one line
+    printf(KeyStoreBenchmark_JSON_TAG
+           " {\"op\":\"%s\",\"backend\":\"%s\",\"keySize\":%zu,"
+           "\"count\":%zu,\"cycles\":%llu,\"cyclesPerOp\":%llu}\n",
+           op, backend, keySize, count, (unsigned long long) cycles, perOp);
+#else
+    Debug_LOG_INFO("BENCHMARK %s/%s: keySize=%zu count=%zu cycles=%llu "
+                   "cycles/op=%llu",
+                   op, backend, keySize, count,
+                   (unsigned long long) cycles, perOp);
+#endif
+}
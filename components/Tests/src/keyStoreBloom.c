@@ -0,0 +1,285 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreBloom.h"
+#include "lib_debug/Debug.h"
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+// Names longer than this are rejected by the keystore implementations
+#define NAME_LEN_MAX        15
+
+#define FNV_OFFSET_BASIS    0x811c9dc5u
+#define FNV_PRIME           0x01000193u
+// Second hash function is the FNV-1a with a different start value
+#define FNV_OFFSET_ALT      0x5bd1e995u
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t
+hashName(
+    const char* name,
+    uint32_t    basis)
+{
+    uint32_t h = basis;
+
+    for (; *name != '\0'; name++)
+    {
+        h ^= (uint8_t) *name;
+        h *= FNV_PRIME;
+    }
+
+    return h;
+}
+
+// Computes the counter indices of a name by double hashing
+static void
+getIndices(
+    const char* name,
+    size_t      idx[KeyStoreBloom_NUM_HASHES])
+{
+    uint32_t h1 = hashName(name, FNV_OFFSET_BASIS);
+    uint32_t h2 = hashName(name, FNV_OFFSET_ALT) | 1;
+
+    for (size_t i = 0; i < KeyStoreBloom_NUM_HASHES; i++)
+    {
+        idx[i] = (h1 + i * h2) % KeyStoreBloom_NUM_COUNTERS;
+    }
+}
+
+// Only names which the keystore would accept are answered from the filter, so
+// that invalid names still get OS_ERROR_INVALID_PARAMETER from the keystore
+static bool
+isValidName(
+    const char* name)
+{
+    size_t len;
+
+    if (NULL == name)
+    {
+        return false;
+    }
+
+    len = strnlen(name, NAME_LEN_MAX + 1);
+
+    return (len > 0) && (len <= NAME_LEN_MAX);
+}
+
+static void
+addName(
+    KeyStoreBloom_t*    self,
+    const char*         name)
+{
+    size_t idx[KeyStoreBloom_NUM_HASHES];
+
+    getIndices(name, idx);
+    for (size_t i = 0; i < KeyStoreBloom_NUM_HASHES; i++)
+    {
+        if (self->counters[idx[i]] < UINT8_MAX)
+        {
+            self->counters[idx[i]]++;
+        }
+    }
+}
+
+static void
+removeName(
+    KeyStoreBloom_t*    self,
+    const char*         name)
+{
+    size_t idx[KeyStoreBloom_NUM_HASHES];
+
+    getIndices(name, idx);
+    for (size_t i = 0; i < KeyStoreBloom_NUM_HASHES; i++)
+    {
+        // A saturated counter has lost track of how many names it holds
+        if ((self->counters[idx[i]] > 0)
+            && (self->counters[idx[i]] < UINT8_MAX))
+        {
+            self->counters[idx[i]]--;
+        }
+    }
+}
+
+// Returns true if the lookup can be answered with OS_ERROR_NOT_FOUND
+static bool
+isDefiniteMiss(
+    KeyStoreBloom_t*    self,
+    const char*         name)
+{
+    self->numLookups++;
+
+    if (!isValidName(name) || KeyStoreBloom_mayContain(self, name))
+    {
+        return false;
+    }
+
+    self->numFiltered++;
+
+    return true;
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreBloom_init(
+    KeyStoreBloom_t*        self,
+    OS_Keystore_Handle_t    hKeystore,
+    const char* const*      names,
+    size_t                  numNames)
+{
+    OS_Error_t err;
+    uint8_t probe;
+    size_t probeSize;
+
+    if ((NULL == self) || (NULL == hKeystore)
+        || ((NULL == names) && (numNames > 0)))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(self, 0, sizeof(*self));
+    self->hKeystore = hKeystore;
+
+    for (size_t i = 0; i < numNames; i++)
+    {
+        // A key which exists does not fit into a zero-sized buffer
+        probeSize = 0;
+        err = OS_Keystore_loadKey(hKeystore, names[i], &probe, &probeSize);
+        if (OS_ERROR_BUFFER_TOO_SMALL == err)
+        {
+            addName(self, names[i]);
+        }
+        else if (err != OS_ERROR_NOT_FOUND)
+        {
+            Debug_LOG_ERROR("Probing key '%s' failed with %d", names[i], err);
+            return err;
+        }
+    }
+
+    self->complete = (names != NULL);
+
+    return OS_SUCCESS;
+}
+
+bool
+KeyStoreBloom_mayContain(
+    const KeyStoreBloom_t*  self,
+    const char*             name)
+{
+    size_t idx[KeyStoreBloom_NUM_HASHES];
+
+    Debug_ASSERT_SELF(self);
+
+    if (!self->complete)
+    {
+        return true;
+    }
+
+    getIndices(name, idx);
+    for (size_t i = 0; i < KeyStoreBloom_NUM_HASHES; i++)
+    {
+        if (0 == self->counters[idx[i]])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+OS_Error_t
+KeyStoreBloom_storeKey(
+    KeyStoreBloom_t*        self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize)
+{
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    err = OS_Keystore_storeKey(self->hKeystore, name, keyData, keySize);
+    switch (err)
+    {
+    case OS_SUCCESS:
+        addName(self, name);
+        break;
+    case OS_ERROR_INVALID_PARAMETER:
+    case OS_ERROR_INSUFFICIENT_SPACE:
+        // Nothing was written
+        break;
+    default:
+        // We can't tell whether the key was written partially, so treat it as
+        // present; a false positive only costs an additional lookup
+        if (isValidName(name))
+        {
+            addName(self, name);
+        }
+        break;
+    }
+
+    return err;
+}
+
+OS_Error_t
+KeyStoreBloom_loadKey(
+    KeyStoreBloom_t*        self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize)
+{
+    Debug_ASSERT_SELF(self);
+
+    if ((keyData != NULL) && (keySize != NULL) && isDefiniteMiss(self, name))
+    {
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    return OS_Keystore_loadKey(self->hKeystore, name, keyData, keySize);
+}
+
+OS_Error_t
+KeyStoreBloom_deleteKey(
+    KeyStoreBloom_t*        self,
+    const char*             name)
+{
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if (isDefiniteMiss(self, name))
+    {
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    err = OS_Keystore_deleteKey(self->hKeystore, name);
+    if (OS_SUCCESS == err)
+    {
+        removeName(self, name);
+    }
+
+    return err;
+}
+
+OS_Error_t
+KeyStoreBloom_wipeKeystore(
+    KeyStoreBloom_t*        self)
+{
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    err = OS_Keystore_wipeKeystore(self->hKeystore);
+    if (OS_SUCCESS == err)
+    {
+        memset(self->counters, 0, sizeof(self->counters));
+        self->complete = true;
+    }
+
+    return err;
+}
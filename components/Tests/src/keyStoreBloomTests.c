@@ -0,0 +1,267 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreBloomTests.h"
+#include "keyStoreBloom.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Keystore.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define KEY_NAME            "Key"
+#define KEY_NAME_NOT_THERE  "KeyNotThere"
+#define KEY_NAME_TOO_LARGE  "PrivateKey123456"  // strlen is 16
+#define KEY_NAME_EMPTY      ""
+#define KEY_DATA            "0123456789ABCDEF"
+
+// Number of keys living in the keystore at the same time; must not exceed the
+// capacity of the smallest keystore under test
+#define NUM_KEYS            4
+// Number of store/delete rounds for the false-negative test
+#define NUM_ROUNDS          8
+// Number of lookups per benchmark run
+#define NUM_LOOKUPS         100
+
+/* Private variables ---------------------------------------------------------*/
+static KeyStoreBloom_t bloom;
+static char keyData[sizeof(KEY_DATA)];
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testBloomMiss(
+    OS_Keystore_Handle_t hKeystore);
+static void
+testBloomDeleteRestore(
+    OS_Keystore_Handle_t hKeystore);
+static void
+testBloomRebuild(
+    OS_Keystore_Handle_t hKeystore);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreBloomTests(
+    OS_Keystore_Handle_t hKeystore)
+{
+    TEST_START();
+
+    testBloomMiss(hKeystore);
+    testBloomDeleteRestore(hKeystore);
+    testBloomRebuild(hKeystore);
+
+    TEST_FINISH();
+}
+
+void keyStoreBloomBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    const char*          backend)
+{
+    TEST_START("backend", backend);
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    char name[sizeof(KEY_NAME) + 11];
+    size_t len;
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t plain = 0;
+    KeyStoreBenchmark_Cycles_t filtered = 0;
+
+    err = KeyStoreBloom_init(&bloom, hKeystore, NULL, 0);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreBloom_wipeKeystore(&bloom);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Have some keys in there, so the lookups are not trivial
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        sprintf(name, "%s-%d", KEY_NAME, i);
+        err = KeyStoreBloom_storeKey(&bloom, name, KEY_DATA, strlen(KEY_DATA));
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    for (int i = 0; i < NUM_LOOKUPS; i++)
+    {
+        sprintf(name, "Miss-%d", i);
+
+        len = sizeof(keyData);
+        start = KeyStoreBenchmark_getCycles();
+        err = OS_Keystore_loadKey(hKeystore, name, keyData, &len);
+        plain += KeyStoreBenchmark_getCycles() - start;
+        ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+        len = sizeof(keyData);
+        start = KeyStoreBenchmark_getCycles();
+        err = KeyStoreBloom_loadKey(&bloom, name, keyData, &len);
+        filtered += KeyStoreBenchmark_getCycles() - start;
+        ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    }
+
+    KeyStoreBenchmark_report("loadKeyMiss", backend, strlen(KEY_DATA),
+                             NUM_LOOKUPS, plain);
+    KeyStoreBenchmark_report("loadKeyMissBloom", backend, strlen(KEY_DATA),
+                             NUM_LOOKUPS, filtered);
+    Debug_LOG_INFO("%zu of %zu lookups answered by the filter",
+                   bloom.numFiltered, bloom.numLookups);
+
+    err = KeyStoreBloom_wipeKeystore(&bloom);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void
+testBloomMiss(
+    OS_Keystore_Handle_t hKeystore)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_18 ************************************/
+    err = KeyStoreBloom_init(&bloom, hKeystore, NULL, 0);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Without knowing the content of the keystore, nothing can be filtered
+    ASSERT_TRUE(KeyStoreBloom_mayContain(&bloom, KEY_NAME_NOT_THERE));
+
+    err = KeyStoreBloom_wipeKeystore(&bloom);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_TRUE(!KeyStoreBloom_mayContain(&bloom, KEY_NAME_NOT_THERE));
+
+    len = sizeof(keyData);
+    err = KeyStoreBloom_loadKey(&bloom, KEY_NAME_NOT_THERE, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    ASSERT_EQ_SZ(1, bloom.numFiltered);
+
+    err = KeyStoreBloom_deleteKey(&bloom, KEY_NAME_NOT_THERE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    ASSERT_EQ_SZ(2, bloom.numFiltered);
+
+    // Invalid parameters must still be reported as such
+    len = sizeof(keyData);
+    err = KeyStoreBloom_loadKey(&bloom, KEY_NAME_TOO_LARGE, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreBloom_loadKey(&bloom, KEY_NAME_EMPTY, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreBloom_loadKey(&bloom, NULL, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreBloom_loadKey(&bloom, KEY_NAME_NOT_THERE, NULL, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreBloom_deleteKey(&bloom, KEY_NAME_EMPTY);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+}
+
+static void
+testBloomDeleteRestore(
+    OS_Keystore_Handle_t hKeystore)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    char name[sizeof(KEY_NAME) + 11];
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_19 ************************************/
+    err = KeyStoreBloom_init(&bloom, hKeystore, NULL, 0);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreBloom_wipeKeystore(&bloom);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        sprintf(name, "%s-%d", KEY_NAME, i);
+        err = KeyStoreBloom_storeKey(&bloom, name, KEY_DATA, strlen(KEY_DATA));
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    // Rotate through the keys; deleting one must never hide another one and
+    // storing a deleted one again must make it visible again
+    for (int round = 0; round < NUM_ROUNDS; round++)
+    {
+        sprintf(name, "%s-%d", KEY_NAME, round % NUM_KEYS);
+
+        err = KeyStoreBloom_deleteKey(&bloom, name);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+        len = sizeof(keyData);
+        err = KeyStoreBloom_loadKey(&bloom, name, keyData, &len);
+        ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+        for (int i = 0; i < NUM_KEYS; i++)
+        {
+            if (i == (round % NUM_KEYS))
+            {
+                continue;
+            }
+            sprintf(name, "%s-%d", KEY_NAME, i);
+            ASSERT_TRUE(KeyStoreBloom_mayContain(&bloom, name));
+
+            len = sizeof(keyData);
+            err = KeyStoreBloom_loadKey(&bloom, name, keyData, &len);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+            ASSERT_EQ_SZ(strlen(KEY_DATA), len);
+        }
+
+        sprintf(name, "%s-%d", KEY_NAME, round % NUM_KEYS);
+        err = KeyStoreBloom_storeKey(&bloom, name, KEY_DATA, strlen(KEY_DATA));
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+        len = sizeof(keyData);
+        err = KeyStoreBloom_loadKey(&bloom, name, keyData, &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        ASSERT_EQ_INT(0, memcmp(KEY_DATA, keyData, strlen(KEY_DATA)));
+    }
+
+    // A failed store must not make the filter lose the existing key
+    err = KeyStoreBloom_storeKey(&bloom, name, KEY_DATA, strlen(KEY_DATA));
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    ASSERT_TRUE(KeyStoreBloom_mayContain(&bloom, name));
+
+    err = KeyStoreBloom_wipeKeystore(&bloom);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_TRUE(!KeyStoreBloom_mayContain(&bloom, name));
+}
+
+static void
+testBloomRebuild(
+    OS_Keystore_Handle_t hKeystore)
+{
+    static const char* const names[] = { KEY_NAME, KEY_NAME_NOT_THERE };
+    OS_Error_t err = OS_ERROR_GENERIC;
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_20 ************************************/
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_Keystore_storeKey(hKeystore, KEY_NAME, KEY_DATA, strlen(KEY_DATA));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreBloom_init(&bloom, hKeystore, names,
+                             sizeof(names) / sizeof(names[0]));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    ASSERT_TRUE(KeyStoreBloom_mayContain(&bloom, KEY_NAME));
+
+    len = sizeof(keyData);
+    err = KeyStoreBloom_loadKey(&bloom, KEY_NAME, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(strlen(KEY_DATA), len);
+
+    len = sizeof(keyData);
+    err = KeyStoreBloom_loadKey(&bloom, KEY_NAME_NOT_THERE, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    err = KeyStoreBloom_wipeKeystore(&bloom);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
@@ -0,0 +1,290 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreChecksum.h"
+#include "keyStoreCrc32c.h"
+#include "lib_debug/Debug.h"
+#include <string.h>
+
+/* Private functions ---------------------------------------------------------*/
+static KeyStoreChecksum_Entry_t*
+findEntry(
+    KeyStoreChecksum_t* self,
+    const char*         name)
+{
+    for (size_t i = 0; i < KeyStoreChecksum_MAX_KEYS; i++)
+    {
+        if (self->entries[i].valid && !strcmp(self->entries[i].name, name))
+        {
+            return &self->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+static KeyStoreChecksum_Entry_t*
+findFree(
+    KeyStoreChecksum_t* self)
+{
+    for (size_t i = 0; i < KeyStoreChecksum_MAX_KEYS; i++)
+    {
+        if (!self->entries[i].valid)
+        {
+            return &self->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Loads the record of a key and verifies it, the key data then starts at
+// KeyStoreChecksum_CRC_SIZE in the record
+static OS_Error_t
+loadRecord(
+    KeyStoreChecksum_t* self,
+    const char*         name,
+    size_t*             recordSize)
+{
+    uint32_t crc = 0;
+    OS_Error_t err;
+
+    *recordSize = sizeof(self->record);
+    if ((err = OS_Keystore_loadKey(self->hKeystore, name, self->record,
+                                   recordSize)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    self->numVerified++;
+
+    if (*recordSize >= KeyStoreChecksum_CRC_SIZE)
+    {
+        memcpy(&crc, self->record, sizeof(crc));
+    }
+    if ((*recordSize < KeyStoreChecksum_CRC_SIZE)
+        || (crc != KeyStoreCrc32c_compute(
+                self->record + KeyStoreChecksum_CRC_SIZE,
+                *recordSize - KeyStoreChecksum_CRC_SIZE)))
+    {
+        Debug_LOG_ERROR("Key '%s' does not match its checksum", name);
+        self->numCorrupt++;
+        return KeyStoreChecksum_ERROR_CORRUPT;
+    }
+
+    return OS_SUCCESS;
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreChecksum_init(
+    KeyStoreChecksum_t*     self,
+    OS_Keystore_Handle_t    hKeystore)
+{
+    if ((NULL == self) || (NULL == hKeystore))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(self, 0, sizeof(*self));
+    self->hKeystore = hKeystore;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreChecksum_storeKey(
+    KeyStoreChecksum_t*     self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize)
+{
+    KeyStoreChecksum_Entry_t* entry;
+    uint32_t crc;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((NULL == name) || (NULL == keyData) || (0 == keySize)
+        || (keySize > KeyStoreChecksum_MAX_KEY_SIZE)
+        || (strlen(name) >= sizeof(entry->name)))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    // Stored already, which the keystore will refuse; otherwise it must be
+    // possible to scrub the key later
+    if ((NULL == (entry = findEntry(self, name)))
+        && (NULL == (entry = findFree(self))))
+    {
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    crc = KeyStoreCrc32c_compute(keyData, keySize);
+    memcpy(self->record, &crc, sizeof(crc));
+    memcpy(self->record + KeyStoreChecksum_CRC_SIZE, keyData, keySize);
+
+    err = OS_Keystore_storeKey(self->hKeystore, name, self->record,
+                               KeyStoreChecksum_CRC_SIZE + keySize);
+    if ((OS_SUCCESS == err) && !entry->valid)
+    {
+        strcpy(entry->name, name);
+        entry->corrupt = false;
+        entry->valid   = true;
+    }
+
+    return err;
+}
+
+OS_Error_t
+KeyStoreChecksum_loadKey(
+    KeyStoreChecksum_t*     self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize)
+{
+    KeyStoreChecksum_Entry_t* entry;
+    size_t recordSize;
+    size_t dataSize;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((NULL == name) || (NULL == keyData) || (NULL == keySize))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    err = loadRecord(self, name, &recordSize);
+    if (KeyStoreChecksum_ERROR_CORRUPT == err)
+    {
+        if ((entry = findEntry(self, name)) != NULL)
+        {
+            entry->corrupt = true;
+        }
+        return err;
+    }
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    dataSize = recordSize - KeyStoreChecksum_CRC_SIZE;
+    if (*keySize < dataSize)
+    {
+        *keySize = dataSize;
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    memcpy(keyData, self->record + KeyStoreChecksum_CRC_SIZE, dataSize);
+    *keySize = dataSize;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreChecksum_deleteKey(
+    KeyStoreChecksum_t*     self,
+    const char*             name)
+{
+    KeyStoreChecksum_Entry_t* entry;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    err = OS_Keystore_deleteKey(self->hKeystore, name);
+    if (((OS_SUCCESS == err) || (OS_ERROR_NOT_FOUND == err))
+        && (name != NULL) && ((entry = findEntry(self, name)) != NULL))
+    {
+        entry->valid = false;
+    }
+
+    return err;
+}
+
+OS_Error_t
+KeyStoreChecksum_wipeKeystore(
+    KeyStoreChecksum_t*     self)
+{
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((err = OS_Keystore_wipeKeystore(self->hKeystore)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    memset(self->entries, 0, sizeof(self->entries));
+    self->scrubCursor = 0;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreChecksum_scrub(
+    KeyStoreChecksum_t*     self,
+    size_t                  maxKeys,
+    size_t*                 numCorrupt)
+{
+    KeyStoreChecksum_Entry_t* entry;
+    size_t recordSize;
+    size_t checked = 0;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if (NULL == numCorrupt)
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    *numCorrupt = 0;
+
+    // At most one pass over all entries per call
+    for (size_t i = 0;
+         (i < KeyStoreChecksum_MAX_KEYS) && (checked < maxKeys);
+         i++)
+    {
+        entry = &self->entries[self->scrubCursor];
+        self->scrubCursor = (self->scrubCursor + 1) % KeyStoreChecksum_MAX_KEYS;
+        if (!entry->valid)
+        {
+            continue;
+        }
+
+        checked++;
+        err = loadRecord(self, entry->name, &recordSize);
+        if (err != OS_SUCCESS)
+        {
+            if (err != KeyStoreChecksum_ERROR_CORRUPT)
+            {
+                Debug_LOG_ERROR("Key '%s' cannot be loaded, error %d",
+                                entry->name, err);
+            }
+            entry->corrupt = true;
+            (*numCorrupt)++;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+bool
+KeyStoreChecksum_isCorrupt(
+    KeyStoreChecksum_t*     self,
+    const char*             name)
+{
+    KeyStoreChecksum_Entry_t* entry;
+
+    Debug_ASSERT_SELF(self);
+
+    return (name != NULL) && ((entry = findEntry(self, name)) != NULL)
+           && entry->corrupt;
+}
@@ -0,0 +1,419 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreChecksumTests.h"
+#include "keyStoreChecksum.h"
+#include "keyStoreCrc32c.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Dataport.h"
+#include "OS_Keystore.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define KEY_NAME            "Crc"
+#define KEY_DATA            "ChecksummedKeyData0123456789abcd"
+#define KEY_SIZE            (sizeof(KEY_DATA) - 1)
+
+// Keys stored for the fault injection, every one with its own data
+#define NUM_FAULT_KEYS      6
+#define FAULT_KEY_SIZE      32
+// Index of the key whose data is corrupted
+#define FAULT_KEY_INDEX     2
+// Keys checked per call of the scrubber
+#define SCRUB_STEP          2
+
+// Key sizes and number of operations for the benchmark
+#define BENCH_KEY_SIZE_SMALL    32
+#define BENCH_KEY_SIZE_LARGE    2048
+#define NUM_LOADS               20
+#define NUM_CRC_RUNS            100
+
+/* Private variables ---------------------------------------------------------*/
+static KeyStoreChecksum_t checksum;
+static uint8_t keyData[KeyStore_Config_MAX_KEY_SIZE];
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testChecksums(
+    OS_Keystore_Handle_t hKeystore);
+static void
+testFaultInjection(
+    KeyStoreChecksumTests_Corrupt_t corrupt);
+static void
+makeFaultKey(
+    size_t  index,
+    char*   name,
+    size_t  nameSize,
+    uint8_t data[FAULT_KEY_SIZE]);
+
+/* Public functions -----------------------------------------------------------*/
+size_t keyStoreCorruptStorage(
+    const if_OS_Storage_t*  storage,
+    const void*             pattern,
+    size_t                  len)
+{
+    uint8_t* buf = OS_Dataport_getBuf(storage->dataport);
+    size_t chunk = OS_Dataport_getSize(storage->dataport);
+    size_t found = 0;
+    size_t done;
+    size_t n;
+    off_t size;
+    bool dirty;
+
+    if ((0 == len) || (len > chunk)
+        || (storage->getSize(&size) != OS_SUCCESS))
+    {
+        return 0;
+    }
+
+    // Chunks overlap, so a pattern crossing a chunk boundary is found; a
+    // corrupted copy does not match anymore when it is read again
+    for (off_t offset = 0; offset < size; offset += chunk - len + 1)
+    {
+        n = ((size - offset) < (off_t) chunk) ? (size_t)(size - offset) : chunk;
+        if ((storage->read(offset, n, &done) != OS_SUCCESS) || (done != n))
+        {
+            break;
+        }
+
+        dirty = false;
+        for (size_t i = 0; i + len <= n; i++)
+        {
+            if (!memcmp(&buf[i], pattern, len))
+            {
+                buf[i + len / 2] ^= 0x01;
+                dirty = true;
+                found++;
+            }
+        }
+
+        if (dirty
+            && ((storage->write(offset, n, &done) != OS_SUCCESS)
+                || (done != n)))
+        {
+            Debug_LOG_ERROR("Writing the corrupted data back failed");
+            break;
+        }
+    }
+
+    return found;
+}
+
+size_t keyStoreCorruptBuffer(
+    void*                   buf,
+    size_t                  size,
+    const void*             pattern,
+    size_t                  len)
+{
+    uint8_t* p = buf;
+    size_t found = 0;
+
+    for (size_t i = 0; (len > 0) && (i + len <= size); i++)
+    {
+        if (!memcmp(&p[i], pattern, len))
+        {
+            p[i + len / 2] ^= 0x01;
+            found++;
+        }
+    }
+
+    return found;
+}
+
+void keyStoreChecksumTests(
+    OS_Keystore_Handle_t            hKeystore,
+    KeyStoreChecksumTests_Corrupt_t corrupt)
+{
+    TEST_START();
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+
+    err = KeyStoreChecksum_init(&checksum, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreChecksum_wipeKeystore(&checksum);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    testChecksums(hKeystore);
+    testFaultInjection(corrupt);
+
+    err = KeyStoreChecksum_wipeKeystore(&checksum);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+void keyStoreChecksumBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    const char*          backend)
+{
+    TEST_START("backend", backend);
+
+    static const size_t sizes[] = { BENCH_KEY_SIZE_SMALL, BENCH_KEY_SIZE_LARGE };
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+    size_t numCorrupt;
+    size_t len;
+
+    err = KeyStoreChecksum_init(&checksum, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    memset(keyData, 0xA5, sizeof(keyData));
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        err = KeyStoreChecksum_wipeKeystore(&checksum);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+        // The same key data, once without and once with checksum
+        err = OS_Keystore_storeKey(hKeystore, "Plain", keyData, sizes[s]);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        err = KeyStoreChecksum_storeKey(&checksum, KEY_NAME, keyData,
+                                        sizes[s]);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+        start = KeyStoreBenchmark_getCycles();
+        for (int i = 0; i < NUM_LOADS; i++)
+        {
+            len = sizeof(keyData);
+            err = OS_Keystore_loadKey(hKeystore, "Plain", keyData, &len);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        }
+        cycles = KeyStoreBenchmark_getCycles() - start;
+        KeyStoreBenchmark_report("loadKeyPlain", backend, sizes[s], NUM_LOADS,
+                                 cycles);
+
+        start = KeyStoreBenchmark_getCycles();
+        for (int i = 0; i < NUM_LOADS; i++)
+        {
+            len = sizeof(keyData);
+            err = KeyStoreChecksum_loadKey(&checksum, KEY_NAME, keyData, &len);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        }
+        cycles = KeyStoreBenchmark_getCycles() - start;
+        KeyStoreBenchmark_report("loadKeyChecksum", backend, sizes[s],
+                                 NUM_LOADS, cycles);
+
+        // One key per call, as a scheduler would spread it over idle time
+        start = KeyStoreBenchmark_getCycles();
+        for (int i = 0; i < NUM_LOADS; i++)
+        {
+            err = KeyStoreChecksum_scrub(&checksum, 1, &numCorrupt);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+            ASSERT_EQ_SZ(0, numCorrupt);
+        }
+        cycles = KeyStoreBenchmark_getCycles() - start;
+        KeyStoreBenchmark_report("scrubKey", backend, sizes[s], NUM_LOADS,
+                                 cycles);
+    }
+
+    err = KeyStoreChecksum_wipeKeystore(&checksum);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+void keyStoreCrc32cBenchmark(
+    void)
+{
+    TEST_START();
+
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+    volatile uint32_t crc = 0;
+
+    memset(keyData, 0x5A, sizeof(keyData));
+
+    start = KeyStoreBenchmark_getCycles();
+    for (int i = 0; i < NUM_CRC_RUNS; i++)
+    {
+        crc ^= KeyStoreCrc32c_computeTable(keyData, BENCH_KEY_SIZE_LARGE);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("crc32cTable", "CPU", BENCH_KEY_SIZE_LARGE,
+                             NUM_CRC_RUNS, cycles);
+
+#if KeyStoreCrc32c_HAS_HW
+    start = KeyStoreBenchmark_getCycles();
+    for (int i = 0; i < NUM_CRC_RUNS; i++)
+    {
+        crc ^= KeyStoreCrc32c_compute(keyData, BENCH_KEY_SIZE_LARGE);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("crc32cHw", "CPU", BENCH_KEY_SIZE_LARGE,
+                             NUM_CRC_RUNS, cycles);
+#else
+    Debug_LOG_INFO("CRC instructions are not used by this build");
+#endif
+
+    // Both runs of the same data cancel out
+    ASSERT_EQ_INT(0, (int) crc);
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void
+makeFaultKey(
+    size_t  index,
+    char*   name,
+    size_t  nameSize,
+    uint8_t data[FAULT_KEY_SIZE])
+{
+    snprintf(name, nameSize, "Fault%zu", index);
+    // Unique data, so the fault injection hits exactly one key
+    for (size_t i = 0; i < FAULT_KEY_SIZE; i++)
+    {
+        data[i] = (uint8_t)(0x3C + 7 * index + 13 * i);
+    }
+}
+
+static void
+testChecksums(
+    OS_Keystore_Handle_t hKeystore)
+{
+    static const uint8_t zeros[32];
+    static const char kat[] = "123456789";
+    OS_Error_t err = OS_ERROR_GENERIC;
+    size_t numCorrupt;
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_40 ************************************/
+    // Known answers of RFC 3720
+    ASSERT_TRUE(0xE3069283u == KeyStoreCrc32c_computeTable(kat, strlen(kat)));
+    ASSERT_TRUE(0xE3069283u == KeyStoreCrc32c_compute(kat, strlen(kat)));
+    ASSERT_TRUE(0x8A9136AAu == KeyStoreCrc32c_computeTable(zeros,
+                                                           sizeof(zeros)));
+    ASSERT_TRUE(0x8A9136AAu == KeyStoreCrc32c_compute(zeros, sizeof(zeros)));
+
+    // Both paths agree for every length and alignment
+    for (size_t i = 0; i < 64; i++)
+    {
+        keyData[i] = (uint8_t)(i * 31);
+    }
+    for (size_t off = 0; off < 8; off++)
+    {
+        for (size_t n = 0; n + off <= 64; n++)
+        {
+            ASSERT_TRUE(KeyStoreCrc32c_compute(keyData + off, n)
+                        == KeyStoreCrc32c_computeTable(keyData + off, n));
+        }
+    }
+
+    err = KeyStoreChecksum_storeKey(&checksum, KEY_NAME, KEY_DATA, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreChecksum_loadKey(&checksum, KEY_NAME, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(KEY_SIZE, len);
+    ASSERT_EQ_INT(0, memcmp(KEY_DATA, keyData, KEY_SIZE));
+
+    // The checksum is stored in the keystore with the key data
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hKeystore, KEY_NAME, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(KeyStoreChecksum_CRC_SIZE + KEY_SIZE, len);
+
+    // The size of the key data is reported without the checksum
+    len = KEY_SIZE - 1;
+    err = KeyStoreChecksum_loadKey(&checksum, KEY_NAME, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_BUFFER_TOO_SMALL, err);
+    ASSERT_EQ_SZ(KEY_SIZE, len);
+
+    // No room left for the checksum
+    err = KeyStoreChecksum_storeKey(&checksum, "CrcTooLarge", keyData,
+                                    KeyStoreChecksum_MAX_KEY_SIZE + 1);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreChecksum_loadKey(&checksum, "CrcNotThere", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    err = KeyStoreChecksum_scrub(&checksum, KeyStoreChecksum_MAX_KEYS,
+                                 &numCorrupt);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(0, numCorrupt);
+    ASSERT_TRUE(!KeyStoreChecksum_isCorrupt(&checksum, KEY_NAME));
+
+    err = KeyStoreChecksum_deleteKey(&checksum, KEY_NAME);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testFaultInjection(
+    KeyStoreChecksumTests_Corrupt_t corrupt)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    char name[16];
+    uint8_t data[FAULT_KEY_SIZE];
+    size_t numCorrupt;
+    size_t total;
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_41 ************************************/
+    for (size_t i = 0; i < NUM_FAULT_KEYS; i++)
+    {
+        makeFaultKey(i, name, sizeof(name), data);
+        err = KeyStoreChecksum_storeKey(&checksum, name, data, sizeof(data));
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    makeFaultKey(FAULT_KEY_INDEX, name, sizeof(name), data);
+    ASSERT_TRUE(corrupt(data, sizeof(data)) > 0);
+
+    // Loading detects the corruption; the backend may detect it first
+    len = sizeof(keyData);
+    err = KeyStoreChecksum_loadKey(&checksum, name, keyData, &len);
+    ASSERT_TRUE(err != OS_SUCCESS);
+    ASSERT_TRUE(err != OS_ERROR_NOT_FOUND);
+
+    // Scrubbing a few keys per call finds it, and only it
+    total = 0;
+    for (size_t i = 0; i < NUM_FAULT_KEYS; i += SCRUB_STEP)
+    {
+        err = KeyStoreChecksum_scrub(&checksum, SCRUB_STEP, &numCorrupt);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        ASSERT_TRUE(numCorrupt <= SCRUB_STEP);
+        total += numCorrupt;
+    }
+    ASSERT_EQ_SZ(1, total);
+
+    for (size_t i = 0; i < NUM_FAULT_KEYS; i++)
+    {
+        makeFaultKey(i, name, sizeof(name), data);
+        ASSERT_TRUE(KeyStoreChecksum_isCorrupt(&checksum, name)
+                    == (FAULT_KEY_INDEX == i));
+        if (FAULT_KEY_INDEX == i)
+        {
+            continue;
+        }
+
+        len = sizeof(keyData);
+        err = KeyStoreChecksum_loadKey(&checksum, name, keyData, &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        ASSERT_EQ_SZ(sizeof(data), len);
+        ASSERT_EQ_INT(0, memcmp(data, keyData, sizeof(data)));
+    }
+
+    // A corrupted key can be deleted and stored again
+    makeFaultKey(FAULT_KEY_INDEX, name, sizeof(name), data);
+    err = KeyStoreChecksum_deleteKey(&checksum, name);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreChecksum_storeKey(&checksum, name, data, sizeof(data));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    len = sizeof(keyData);
+    err = KeyStoreChecksum_loadKey(&checksum, name, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_TRUE(!KeyStoreChecksum_isCorrupt(&checksum, name));
+}
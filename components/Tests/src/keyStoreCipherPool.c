@@ -0,0 +1,440 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreCipherPool.h"
+#include "lib_debug/Debug.h"
+#include <stdbool.h>
+#include <string.h>
+
+/* Private functions ---------------------------------------------------------*/
+static bool
+isCbc(
+    OS_CryptoCipher_Alg_t alg)
+{
+    return (OS_CryptoCipher_ALG_AES_CBC_ENC == alg)
+           || (OS_CryptoCipher_ALG_AES_CBC_DEC == alg);
+}
+
+// Checks a lane the way KeyStoreCipherPool_processBatch() checks a message, so
+// a bad lane does not fail the batch of the good lanes with the same key
+static bool
+isValidLane(
+    KeyStoreCipherPool_Lane_t const* lane)
+{
+    if ((NULL == lane->in) || (NULL == lane->out) || (0 == lane->len)
+        || (lane->len % KeyStoreCipherPool_BLOCK_SIZE))
+    {
+        return false;
+    }
+
+    // Lanes are independent, so there is no chain to continue
+    return !(isCbc(lane->alg) && (NULL == lane->iv));
+}
+
+static void
+dropContext(
+    KeyStoreCipherPool_Context_t*   ctx)
+{
+    OS_Error_t err;
+
+    if ((err = OS_CryptoCipher_free(ctx->hCipher)) != OS_SUCCESS)
+    {
+        Debug_LOG_WARNING("OS_CryptoCipher_free() failed with %d", err);
+    }
+
+    ctx->valid = false;
+}
+
+// Returns the context for key and algorithm, creating it with the given IV if
+// there is none yet
+static OS_Error_t
+getContext(
+    KeyStoreCipherPool_t*           self,
+    OS_CryptoKey_Handle_t           hKey,
+    OS_CryptoCipher_Alg_t           alg,
+    void const*                     iv,
+    KeyStoreCipherPool_Context_t**  ctx)
+{
+    KeyStoreCipherPool_Context_t* c = NULL;
+    OS_Error_t err;
+
+    for (size_t i = 0; i < self->capacity; i++)
+    {
+        if (self->ctx[i].valid && (self->ctx[i].hKey == hKey)
+            && (self->ctx[i].alg == alg))
+        {
+            self->numReuses++;
+            *ctx = &self->ctx[i];
+            return OS_SUCCESS;
+        }
+        if (!self->ctx[i].valid)
+        {
+            c = &self->ctx[i];
+        }
+    }
+
+    // A chain can only be continued on an existing context
+    if (isCbc(alg) && (NULL == iv))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    if (NULL == c)
+    {
+        c = &self->ctx[0];
+        for (size_t i = 1; i < self->capacity; i++)
+        {
+            if (self->ctx[i].lastUse < c->lastUse)
+            {
+                c = &self->ctx[i];
+            }
+        }
+        dropContext(c);
+        self->numEvictions++;
+    }
+
+    if (isCbc(alg))
+    {
+        err = OS_CryptoCipher_init(&c->hCipher, self->hCrypto, hKey, alg, iv,
+                                   KeyStoreCipherPool_BLOCK_SIZE);
+        memcpy(c->chain, iv, KeyStoreCipherPool_BLOCK_SIZE);
+    }
+    else
+    {
+        err = OS_CryptoCipher_init(&c->hCipher, self->hCrypto, hKey, alg,
+                                   NULL, 0);
+    }
+    if (err != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    c->valid = true;
+    c->hKey  = hKey;
+    c->alg   = alg;
+    self->numInits++;
+    *ctx = c;
+
+    return OS_SUCCESS;
+}
+
+static OS_Error_t
+processChunked(
+    KeyStoreCipherPool_Context_t*   ctx,
+    const uint8_t*                  in,
+    size_t                          len,
+    uint8_t*                        out)
+{
+    size_t chunk;
+    size_t outLen;
+    OS_Error_t err;
+
+    while (len > 0)
+    {
+        chunk  = (len > KeyStoreCipherPool_MAX_CHUNK) ?
+                 KeyStoreCipherPool_MAX_CHUNK : len;
+        outLen = chunk;
+        if ((err = OS_CryptoCipher_process(ctx->hCipher, in, chunk, out,
+                                           &outLen)) != OS_SUCCESS)
+        {
+            return err;
+        }
+        if (outLen != chunk)
+        {
+            return OS_ERROR_GENERIC;
+        }
+        in  += chunk;
+        out += chunk;
+        len -= chunk;
+    }
+
+    return OS_SUCCESS;
+}
+
+static OS_Error_t
+processMsg(
+    KeyStoreCipherPool_t*           self,
+    KeyStoreCipherPool_Context_t*   ctx,
+    KeyStoreCipherPool_Msg_t const* msg)
+{
+    const size_t bs = KeyStoreCipherPool_BLOCK_SIZE;
+    const uint8_t* in = msg->in;
+    uint8_t* out = msg->out;
+    uint8_t delta[KeyStoreCipherPool_BLOCK_SIZE];
+    uint8_t lastIn[KeyStoreCipherPool_BLOCK_SIZE];
+    bool newIv;
+    OS_Error_t err;
+
+    if (!isCbc(ctx->alg))
+    {
+        return processChunked(ctx, in, msg->len, out);
+    }
+
+    newIv = (msg->iv != NULL) && memcmp(msg->iv, ctx->chain, bs);
+    if (newIv)
+    {
+        for (size_t i = 0; i < bs; i++)
+        {
+            delta[i] = ((const uint8_t*) msg->iv)[i] ^ ctx->chain[i];
+        }
+    }
+
+    if (OS_CryptoCipher_ALG_AES_CBC_ENC == ctx->alg)
+    {
+        if (newIv)
+        {
+            // E(p1 ^ chain ^ delta) = E(p1 ^ iv)
+            for (size_t i = 0; i < bs; i++)
+            {
+                self->block[i] = in[i] ^ delta[i];
+            }
+            if ((err = processChunked(ctx, self->block, bs, out))
+                != OS_SUCCESS)
+            {
+                return err;
+            }
+            in  += bs;
+            out += bs;
+        }
+        if ((err = processChunked(ctx, in, msg->len - (newIv ? bs : 0), out))
+            != OS_SUCCESS)
+        {
+            return err;
+        }
+        memcpy(ctx->chain, (uint8_t*) msg->out + msg->len - bs, bs);
+    }
+    else
+    {
+        // Output may overwrite the input, so keep the next chaining value
+        memcpy(lastIn, in + msg->len - bs, bs);
+        if ((err = processChunked(ctx, in, msg->len, out)) != OS_SUCCESS)
+        {
+            return err;
+        }
+        if (newIv)
+        {
+            // D(c1) ^ chain ^ delta = D(c1) ^ iv
+            for (size_t i = 0; i < bs; i++)
+            {
+                out[i] ^= delta[i];
+            }
+        }
+        memcpy(ctx->chain, lastIn, bs);
+    }
+
+    return OS_SUCCESS;
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreCipherPool_init(
+    KeyStoreCipherPool_t*   self,
+    OS_Crypto_Handle_t      hCrypto,
+    size_t                  capacity)
+{
+    if ((NULL == self) || (NULL == hCrypto) || (0 == capacity)
+        || (capacity > KeyStoreCipherPool_MAX_CONTEXTS))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(self, 0, sizeof(*self));
+    self->hCrypto  = hCrypto;
+    self->capacity = capacity;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreCipherPool_processBatch(
+    KeyStoreCipherPool_t*           self,
+    OS_CryptoKey_Handle_t           hKey,
+    OS_CryptoCipher_Alg_t           alg,
+    KeyStoreCipherPool_Msg_t const* msgs,
+    size_t                          numMsgs,
+    size_t*                         numProcessed)
+{
+    KeyStoreCipherPool_Context_t* ctx;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if (numProcessed != NULL)
+    {
+        *numProcessed = 0;
+    }
+
+    if ((NULL == hKey) || (NULL == msgs) || (0 == numMsgs))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+    if ((alg != OS_CryptoCipher_ALG_AES_ECB_ENC)
+        && (alg != OS_CryptoCipher_ALG_AES_ECB_DEC) && !isCbc(alg))
+    {
+        return OS_ERROR_NOT_SUPPORTED;
+    }
+    for (size_t i = 0; i < numMsgs; i++)
+    {
+        if ((NULL == msgs[i].in) || (NULL == msgs[i].out) || (0 == msgs[i].len)
+            || (msgs[i].len % KeyStoreCipherPool_BLOCK_SIZE))
+        {
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    if ((err = getContext(self, hKey, alg, msgs[0].iv, &ctx)) != OS_SUCCESS)
+    {
+        return err;
+    }
+    ctx->lastUse = ++self->clock;
+
+    for (size_t i = 0; i < numMsgs; i++)
+    {
+        if ((err = processMsg(self, ctx, &msgs[i])) != OS_SUCCESS)
+        {
+            // State of the context is unknown now
+            Debug_LOG_ERROR("Processing message %zu failed with %d", i, err);
+            dropContext(ctx);
+            return err;
+        }
+        if (numProcessed != NULL)
+        {
+            *numProcessed = i + 1;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreCipherPool_process(
+    KeyStoreCipherPool_t*   self,
+    OS_CryptoKey_Handle_t   hKey,
+    OS_CryptoCipher_Alg_t   alg,
+    void const*             iv,
+    void const*             in,
+    size_t                  len,
+    void*                   out)
+{
+    KeyStoreCipherPool_Msg_t msg =
+    {
+        .in  = in,
+        .len = len,
+        .out = out,
+        .iv  = iv
+    };
+
+    return KeyStoreCipherPool_processBatch(self, hKey, alg, &msg, 1, NULL);
+}
+
+OS_Error_t
+KeyStoreCipherPool_processLanes(
+    KeyStoreCipherPool_t*       self,
+    KeyStoreCipherPool_Lane_t*  lanes,
+    size_t                      numLanes)
+{
+    KeyStoreCipherPool_Msg_t msgs[KeyStoreCipherPool_MAX_LANES];
+    size_t group[KeyStoreCipherPool_MAX_LANES];
+    bool done[KeyStoreCipherPool_MAX_LANES] = { false };
+    OS_Error_t err;
+    size_t n;
+    size_t numProcessed;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((NULL == lanes) || (0 == numLanes)
+        || (numLanes > KeyStoreCipherPool_MAX_LANES))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    for (size_t i = 0; i < numLanes; i++)
+    {
+        if (done[i])
+        {
+            continue;
+        }
+
+        // Collect all lanes with the same key and algorithm
+        n = 0;
+        for (size_t j = i; j < numLanes; j++)
+        {
+            if (!done[j] && (lanes[j].hKey == lanes[i].hKey)
+                && (lanes[j].alg == lanes[i].alg))
+            {
+                if (!isValidLane(&lanes[j]))
+                {
+                    lanes[j].err = OS_ERROR_INVALID_PARAMETER;
+                }
+                else
+                {
+                    msgs[n].in  = lanes[j].in;
+                    msgs[n].len = lanes[j].len;
+                    msgs[n].out = lanes[j].out;
+                    msgs[n].iv  = lanes[j].iv;
+                    group[n++]  = j;
+                }
+                done[j] = true;
+            }
+        }
+
+        if (n > 0)
+        {
+            err = KeyStoreCipherPool_processBatch(self, lanes[i].hKey,
+                                                  lanes[i].alg, msgs, n,
+                                                  &numProcessed);
+            // Lanes before the one that failed have their output already
+            for (size_t k = 0; k < n; k++)
+            {
+                lanes[group[k]].err = (k < numProcessed) ? OS_SUCCESS : err;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < numLanes; i++)
+    {
+        if (lanes[i].err != OS_SUCCESS)
+        {
+            return lanes[i].err;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+void
+KeyStoreCipherPool_releaseKey(
+    KeyStoreCipherPool_t*   self,
+    OS_CryptoKey_Handle_t   hKey)
+{
+    Debug_ASSERT_SELF(self);
+
+    for (size_t i = 0; i < self->capacity; i++)
+    {
+        if (self->ctx[i].valid && (self->ctx[i].hKey == hKey))
+        {
+            dropContext(&self->ctx[i]);
+        }
+    }
+}
+
+void
+KeyStoreCipherPool_free(
+    KeyStoreCipherPool_t*   self)
+{
+    Debug_ASSERT_SELF(self);
+
+    for (size_t i = 0; i < self->capacity; i++)
+    {
+        if (self->ctx[i].valid)
+        {
+            dropContext(&self->ctx[i]);
+        }
+    }
+}
@@ -0,0 +1,452 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreCipherPoolTests.h"
+#include "keyStoreCipherPool.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Crypto.h"
+#include "OS_Keystore.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define AES_KEY_NAME        "PoolKey"
+#define BLOCK_LEN           KeyStoreCipherPool_BLOCK_SIZE
+#define NUM_MSGS            4
+// Large enough to be split into chunks
+#define LARGE_MSG_LEN       (KeyStoreCipherPool_MAX_CHUNK + 2 * BLOCK_LEN)
+// Number of messages per benchmark run
+#define NUM_BENCH_MSGS      64
+
+/* Private variables ---------------------------------------------------------*/
+static KeyStoreCipherPool_t pool;
+static OS_CryptoKey_Data_t keyData;
+static uint8_t plain[LARGE_MSG_LEN];
+static uint8_t ref[LARGE_MSG_LEN];
+static uint8_t out[LARGE_MSG_LEN];
+
+static const size_t msgLen[NUM_MSGS] =
+{
+    BLOCK_LEN, 2 * BLOCK_LEN, 4 * BLOCK_LEN, 5 * BLOCK_LEN
+};
+static const size_t benchLen[] = { BLOCK_LEN, 4 * BLOCK_LEN };
+
+static const OS_CryptoKey_Spec_t aes256Spec =
+{
+    .type = OS_CryptoKey_SPECTYPE_BITS,
+    .key = {
+        .type = OS_CryptoKey_TYPE_AES,
+        .attribs.keepLocal = true,
+        .params.bits = 256
+    }
+};
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testPoolEcb(
+    OS_Crypto_Handle_t    hCrypto,
+    OS_CryptoKey_Handle_t hKey);
+static void
+testPoolCbc(
+    OS_Crypto_Handle_t    hCrypto,
+    OS_CryptoKey_Handle_t hKey);
+static OS_CryptoKey_Handle_t
+loadKey(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto);
+static void
+processFresh(
+    OS_Crypto_Handle_t    hCrypto,
+    OS_CryptoKey_Handle_t hKey,
+    OS_CryptoCipher_Alg_t alg,
+    const uint8_t*        iv,
+    const uint8_t*        in,
+    size_t                len,
+    uint8_t*              outBuf);
+static void
+fillPattern(
+    uint8_t* buf,
+    size_t   len,
+    uint8_t  seed);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreCipherPoolTests(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto)
+{
+    TEST_START();
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hKey;
+
+    hKey = loadKey(hKeystore, hCrypto);
+
+    testPoolEcb(hCrypto, hKey);
+    testPoolCbc(hCrypto, hKey);
+
+    err = OS_CryptoKey_free(hKey);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+void keyStoreCipherPoolBenchmark(
+    OS_Crypto_Handle_t   hCrypto)
+{
+    TEST_START();
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hKey;
+    KeyStoreCipherPool_Msg_t msgs[NUM_BENCH_MSGS];
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+    uint8_t iv[BLOCK_LEN];
+    size_t len;
+
+    err = OS_CryptoKey_generate(&hKey, hCrypto, &aes256Spec);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreCipherPool_init(&pool, hCrypto, 2);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    fillPattern(plain, sizeof(plain), 1);
+    fillPattern(iv, sizeof(iv), 2);
+
+    for (size_t l = 0; l < sizeof(benchLen) / sizeof(benchLen[0]); l++)
+    {
+        len = benchLen[l];
+
+        // Context set up for every message
+        start = KeyStoreBenchmark_getCycles();
+        for (int i = 0; i < NUM_BENCH_MSGS; i++)
+        {
+            processFresh(hCrypto, hKey, OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+                         plain + i * BLOCK_LEN, len, out + i * BLOCK_LEN);
+        }
+        cycles = KeyStoreBenchmark_getCycles() - start;
+        KeyStoreBenchmark_report("aesEcbFresh", "Crypto", len, NUM_BENCH_MSGS,
+                                 cycles);
+
+        start = KeyStoreBenchmark_getCycles();
+        for (int i = 0; i < NUM_BENCH_MSGS; i++)
+        {
+            iv[0] = i;
+            processFresh(hCrypto, hKey, OS_CryptoCipher_ALG_AES_CBC_ENC, iv,
+                         plain + i * BLOCK_LEN, len, out + i * BLOCK_LEN);
+        }
+        cycles = KeyStoreBenchmark_getCycles() - start;
+        KeyStoreBenchmark_report("aesCbcFresh", "Crypto", len, NUM_BENCH_MSGS,
+                                 cycles);
+
+        // Pooled context, one call per message
+        start = KeyStoreBenchmark_getCycles();
+        for (int i = 0; i < NUM_BENCH_MSGS; i++)
+        {
+            err = KeyStoreCipherPool_process(&pool, hKey,
+                                             OS_CryptoCipher_ALG_AES_ECB_ENC,
+                                             NULL, plain + i * BLOCK_LEN, len,
+                                             out + i * BLOCK_LEN);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        }
+        cycles = KeyStoreBenchmark_getCycles() - start;
+        KeyStoreBenchmark_report("aesEcbPooled", "Crypto", len, NUM_BENCH_MSGS,
+                                 cycles);
+
+        start = KeyStoreBenchmark_getCycles();
+        for (int i = 0; i < NUM_BENCH_MSGS; i++)
+        {
+            iv[0] = i;
+            err = KeyStoreCipherPool_process(&pool, hKey,
+                                             OS_CryptoCipher_ALG_AES_CBC_ENC,
+                                             iv, plain + i * BLOCK_LEN, len,
+                                             out + i * BLOCK_LEN);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        }
+        cycles = KeyStoreBenchmark_getCycles() - start;
+        KeyStoreBenchmark_report("aesCbcPooled", "Crypto", len, NUM_BENCH_MSGS,
+                                 cycles);
+
+        // Pooled context, all messages in one call
+        for (int i = 0; i < NUM_BENCH_MSGS; i++)
+        {
+            msgs[i].in  = plain + i * BLOCK_LEN;
+            msgs[i].len = len;
+            msgs[i].out = out + i * BLOCK_LEN;
+            msgs[i].iv  = NULL;
+        }
+        start = KeyStoreBenchmark_getCycles();
+        err = KeyStoreCipherPool_processBatch(&pool, hKey,
+                                              OS_CryptoCipher_ALG_AES_ECB_ENC,
+                                              msgs, NUM_BENCH_MSGS, NULL);
+        cycles = KeyStoreBenchmark_getCycles() - start;
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        KeyStoreBenchmark_report("aesEcbBatched", "Crypto", len,
+                                 NUM_BENCH_MSGS, cycles);
+    }
+
+    KeyStoreCipherPool_free(&pool);
+
+    err = OS_CryptoKey_free(hKey);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void
+testPoolEcb(
+    OS_Crypto_Handle_t    hCrypto,
+    OS_CryptoKey_Handle_t hKey)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreCipherPool_Msg_t msgs[NUM_MSGS];
+    size_t offset;
+
+    /********************************** TestKeyStore_testCase_32 ************************************/
+    err = KeyStoreCipherPool_init(&pool, hCrypto, 2);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    fillPattern(plain, sizeof(plain), 0);
+
+    // Reference: one context per block, as aesEncrypt() does it
+    for (offset = 0; offset < LARGE_MSG_LEN; offset += BLOCK_LEN)
+    {
+        processFresh(hCrypto, hKey, OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+                     plain + offset, BLOCK_LEN, ref + offset);
+    }
+
+    // Messages of different sizes in one batch
+    offset = 0;
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        msgs[i].in  = plain + offset;
+        msgs[i].len = msgLen[i];
+        msgs[i].out = out + offset;
+        msgs[i].iv  = NULL;
+        offset += msgLen[i];
+    }
+    memset(out, 0, sizeof(out));
+    err = KeyStoreCipherPool_processBatch(&pool, hKey,
+                                          OS_CryptoCipher_ALG_AES_ECB_ENC,
+                                          msgs, NUM_MSGS, NULL);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(0, memcmp(ref, out, offset));
+
+    // Single messages reuse the context; a large one is split into chunks
+    err = KeyStoreCipherPool_process(&pool, hKey,
+                                     OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+                                     plain, LARGE_MSG_LEN, out);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(0, memcmp(ref, out, LARGE_MSG_LEN));
+    ASSERT_EQ_SZ(1, pool.numInits);
+    ASSERT_EQ_SZ(1, pool.numReuses);
+
+    // Decrypt in place
+    err = KeyStoreCipherPool_process(&pool, hKey,
+                                     OS_CryptoCipher_ALG_AES_ECB_DEC, NULL,
+                                     out, LARGE_MSG_LEN, out);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(0, memcmp(plain, out, LARGE_MSG_LEN));
+    ASSERT_EQ_SZ(2, pool.numInits);
+
+    // Contexts of a released key are set up again
+    KeyStoreCipherPool_releaseKey(&pool, hKey);
+    err = KeyStoreCipherPool_process(&pool, hKey,
+                                     OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+                                     plain, BLOCK_LEN, out);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(0, memcmp(ref, out, BLOCK_LEN));
+    ASSERT_EQ_SZ(3, pool.numInits);
+
+    // Parameter checks
+    err = KeyStoreCipherPool_process(&pool, hKey,
+                                     OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+                                     plain, BLOCK_LEN - 1, out);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreCipherPool_process(&pool, hKey,
+                                     OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+                                     NULL, BLOCK_LEN, out);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreCipherPool_process(&pool, hKey,
+                                     OS_CryptoCipher_ALG_AES_GCM_ENC, plain,
+                                     plain, BLOCK_LEN, out);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_SUPPORTED, err);
+
+    err = KeyStoreCipherPool_init(&pool, hCrypto,
+                                  KeyStoreCipherPool_MAX_CONTEXTS + 1);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    KeyStoreCipherPool_free(&pool);
+}
+
+static void
+testPoolCbc(
+    OS_Crypto_Handle_t    hCrypto,
+    OS_CryptoKey_Handle_t hKey)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreCipherPool_Msg_t msgs[NUM_MSGS];
+    uint8_t ivs[NUM_MSGS][BLOCK_LEN];
+    size_t offset;
+
+    /********************************** TestKeyStore_testCase_33 ************************************/
+    err = KeyStoreCipherPool_init(&pool, hCrypto, 2);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    fillPattern(plain, sizeof(plain), 3);
+
+    // Reference: every message with its own IV on a fresh context
+    offset = 0;
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        fillPattern(ivs[i], BLOCK_LEN, 0x40 + i);
+        processFresh(hCrypto, hKey, OS_CryptoCipher_ALG_AES_CBC_ENC, ivs[i],
+                     plain + offset, msgLen[i], ref + offset);
+
+        msgs[i].in  = plain + offset;
+        msgs[i].len = msgLen[i];
+        msgs[i].out = out + offset;
+        msgs[i].iv  = ivs[i];
+        offset += msgLen[i];
+    }
+
+    memset(out, 0, sizeof(out));
+    err = KeyStoreCipherPool_processBatch(&pool, hKey,
+                                          OS_CryptoCipher_ALG_AES_CBC_ENC,
+                                          msgs, NUM_MSGS, NULL);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(0, memcmp(ref, out, offset));
+
+    // Decrypt in place, one call per message
+    for (int i = 0; i < NUM_MSGS; i++)
+    {
+        err = KeyStoreCipherPool_process(&pool, hKey,
+                                         OS_CryptoCipher_ALG_AES_CBC_DEC,
+                                         ivs[i], msgs[i].out, msgs[i].len,
+                                         msgs[i].out);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    ASSERT_EQ_INT(0, memcmp(plain, out, offset));
+    ASSERT_EQ_SZ(2, pool.numInits);
+
+    // A message without IV continues the chain of the previous one
+    processFresh(hCrypto, hKey, OS_CryptoCipher_ALG_AES_CBC_ENC, ivs[0],
+                 plain, 3 * BLOCK_LEN, ref);
+
+    err = KeyStoreCipherPool_process(&pool, hKey,
+                                     OS_CryptoCipher_ALG_AES_CBC_ENC, ivs[0],
+                                     plain, BLOCK_LEN, out);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreCipherPool_process(&pool, hKey,
+                                     OS_CryptoCipher_ALG_AES_CBC_ENC, NULL,
+                                     plain + BLOCK_LEN, 2 * BLOCK_LEN,
+                                     out + BLOCK_LEN);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(0, memcmp(ref, out, 3 * BLOCK_LEN));
+
+    // A third context evicts the least recently used one (CBC decryption)
+    err = KeyStoreCipherPool_process(&pool, hKey,
+                                     OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+                                     plain, BLOCK_LEN, out);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(1, pool.numEvictions);
+
+    // There is no chain to continue on a new context
+    err = KeyStoreCipherPool_process(&pool, hKey,
+                                     OS_CryptoCipher_ALG_AES_CBC_DEC, NULL,
+                                     ref, BLOCK_LEN, out);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreCipherPool_process(&pool, hKey,
+                                     OS_CryptoCipher_ALG_AES_CBC_DEC, ivs[0],
+                                     ref, 3 * BLOCK_LEN, out);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(0, memcmp(plain, out, 3 * BLOCK_LEN));
+    ASSERT_EQ_SZ(2, pool.numEvictions);
+
+    KeyStoreCipherPool_free(&pool);
+}
+
+// Stores a new AES key and loads it again, as testKeyStoreAES() does
+static OS_CryptoKey_Handle_t
+loadKey(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hKey;
+    size_t len;
+
+    err = OS_CryptoKey_generate(&hKey, hCrypto, &aes256Spec);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_CryptoKey_export(hKey, &keyData);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_CryptoKey_free(hKey);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_Keystore_storeKey(hKeystore, AES_KEY_NAME, &keyData,
+                               sizeof(keyData));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hKeystore, AES_KEY_NAME, &keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_CryptoKey_import(&hKey, hCrypto, &keyData);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    return hKey;
+}
+
+// Processes a message on a context of its own, as aesEncrypt() does
+static void
+processFresh(
+    OS_Crypto_Handle_t    hCrypto,
+    OS_CryptoKey_Handle_t hKey,
+    OS_CryptoCipher_Alg_t alg,
+    const uint8_t*        iv,
+    const uint8_t*        in,
+    size_t                len,
+    uint8_t*              outBuf)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoCipher_Handle_t hCipher;
+    size_t outLen = len;
+
+    err = OS_CryptoCipher_init(&hCipher, hCrypto, hKey, alg, iv,
+                               (NULL == iv) ? 0 : BLOCK_LEN);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_CryptoCipher_process(hCipher, in, len, outBuf, &outLen);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(len, outLen);
+
+    err = OS_CryptoCipher_free(hCipher);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+fillPattern(
+    uint8_t* buf,
+    size_t   len,
+    uint8_t  seed)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        buf[i] = (uint8_t)(seed + i * 7);
+    }
+}
@@ -0,0 +1,151 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreCrc32c.h"
+#include <string.h>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+/* Defines -------------------------------------------------------------------*/
+// Reflected polynomial of CRC32C
+#define CRC32C_POLY     0x82F63B78u
+
+/* Private variables ---------------------------------------------------------*/
+// Tables for slicing-by-8, table[0] is the classic bytewise table
+static uint32_t table[8][256];
+static bool tableReady;
+
+/* Private functions ---------------------------------------------------------*/
+static void
+initTable(
+    void)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+        }
+        table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        for (int t = 1; t < 8; t++)
+        {
+            table[t][i] = (table[t - 1][i] >> 8)
+                          ^ table[0][table[t - 1][i] & 0xFF];
+        }
+    }
+    tableReady = true;
+}
+
+static uint32_t
+updateTable(
+    uint32_t        crc,
+    const uint8_t*  p,
+    size_t          len)
+{
+    uint32_t lo;
+    uint32_t hi;
+
+    if (!tableReady)
+    {
+        initTable();
+    }
+
+    // Eight bytes per step; the words are assembled bytewise, so this works
+    // for any alignment and byte order
+    for (; len >= 8; len -= 8, p += 8)
+    {
+        lo = crc ^ ((uint32_t) p[0] | ((uint32_t) p[1] << 8)
+                    | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24));
+        hi = (uint32_t) p[4] | ((uint32_t) p[5] << 8)
+             | ((uint32_t) p[6] << 16) | ((uint32_t) p[7] << 24);
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF]
+              ^ table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24]
+              ^ table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF]
+              ^ table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+    }
+    while (len--)
+    {
+        crc = table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#if KeyStoreCrc32c_HAS_HW
+static inline uint32_t
+updateHwWord(
+    uint32_t    crc,
+    uint64_t    word)
+{
+#if defined(__SSE4_2__) && defined(__x86_64__)
+    return (uint32_t) _mm_crc32_u64(crc, word);
+#elif defined(__SSE4_2__)
+    // There is no _mm_crc32_u64 on 32-bit x86, the word is little endian
+    crc = _mm_crc32_u32(crc, (uint32_t) word);
+    return _mm_crc32_u32(crc, (uint32_t)(word >> 32));
+#else
+    return __crc32cd(crc, word);
+#endif
+}
+
+static uint32_t
+updateHw(
+    uint32_t        crc,
+    const uint8_t*  p,
+    size_t          len)
+{
+    uint64_t word;
+
+    // Eight bytes per step, the copy avoids unaligned accesses
+    for (; len >= sizeof(word); len -= sizeof(word), p += sizeof(word))
+    {
+        memcpy(&word, p, sizeof(word));
+        crc = updateHwWord(crc, word);
+    }
+    while (len--)
+    {
+#if defined(__SSE4_2__)
+        crc = _mm_crc32_u8(crc, *p++);
+#else
+        crc = __crc32cb(crc, *p++);
+#endif
+    }
+
+    return crc;
+}
+#endif
+
+/* Public functions -----------------------------------------------------------*/
+uint32_t
+KeyStoreCrc32c_compute(
+    const void* data,
+    size_t      len)
+{
+#if KeyStoreCrc32c_HAS_HW
+    return ~updateHw(~0u, data, len);
+#else
+    return ~updateTable(~0u, data, len);
+#endif
+}
+
+uint32_t
+KeyStoreCrc32c_computeTable(
+    const void* data,
+    size_t      len)
+{
+    return ~updateTable(~0u, data, len);
+}
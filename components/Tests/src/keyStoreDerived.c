@@ -0,0 +1,299 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreDerived.h"
+#include "lib_debug/Debug.h"
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+// Counter of the first (and only) block of HKDF-Expand
+#define HKDF_BLOCK_COUNTER  0x01
+
+/* Private functions ---------------------------------------------------------*/
+static KeyStoreDerived_CacheEntry_t*
+findEntry(
+    KeyStoreDerived_t*  self,
+    const char*         name)
+{
+    for (size_t i = 0; i < self->capacity; i++)
+    {
+        if (self->cache[i].valid && !strcmp(self->cache[i].name, name))
+        {
+            return &self->cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static KeyStoreDerived_CacheEntry_t*
+findFree(
+    KeyStoreDerived_t*  self)
+{
+    for (size_t i = 0; i < self->capacity; i++)
+    {
+        if (!self->cache[i].valid)
+        {
+            return &self->cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void
+evictEntry(
+    KeyStoreDerived_t*              self,
+    KeyStoreDerived_CacheEntry_t*   entry)
+{
+    OS_Error_t err;
+
+    if ((err = OS_CryptoKey_free(entry->hKey)) != OS_SUCCESS)
+    {
+        Debug_LOG_WARNING("OS_CryptoKey_free() for '%s' failed with %d",
+                          entry->name, err);
+    }
+
+    entry->valid = false;
+    self->numEvictions++;
+}
+
+// Evicts the least recently used entry; returns false if the cache is empty
+static bool
+evictLru(
+    KeyStoreDerived_t*  self)
+{
+    KeyStoreDerived_CacheEntry_t* victim = NULL;
+
+    for (size_t i = 0; i < self->capacity; i++)
+    {
+        if (self->cache[i].valid
+            && ((NULL == victim)
+                || (self->cache[i].lastUse < victim->lastUse)))
+        {
+            victim = &self->cache[i];
+        }
+    }
+
+    if (NULL == victim)
+    {
+        return false;
+    }
+
+    evictEntry(self, victim);
+
+    return true;
+}
+
+// Loads a master key, imports it as MAC key and puts it into the cache
+static OS_Error_t
+importMaster(
+    KeyStoreDerived_t*              self,
+    const char*                     name,
+    KeyStoreDerived_CacheEntry_t**  entry)
+{
+    OS_CryptoKey_Data_t* data = &self->keyData;
+    OS_CryptoKey_Handle_t hKey;
+    KeyStoreDerived_CacheEntry_t* e;
+    size_t len = sizeof(*data);
+    OS_Error_t err;
+
+    if ((err = OS_Keystore_loadKey(self->hKeystore, name, data, &len))
+        != OS_SUCCESS)
+    {
+        return err;
+    }
+    if (len != sizeof(*data))
+    {
+        err = OS_ERROR_INVALID_PARAMETER;
+        goto out;
+    }
+
+    switch (data->type)
+    {
+    case OS_CryptoKey_TYPE_MAC:
+        break;
+    case OS_CryptoKey_TYPE_AES:
+        // Use the AES key material as HMAC key
+        len = data->data.aes.len;
+        if (len > sizeof(data->data.aes.bytes))
+        {
+            err = OS_ERROR_INVALID_PARAMETER;
+            goto out;
+        }
+        memmove(data->data.mac.bytes, data->data.aes.bytes, len);
+        data->data.mac.len = len;
+        data->type = OS_CryptoKey_TYPE_MAC;
+        break;
+    default:
+        err = OS_ERROR_NOT_SUPPORTED;
+        goto out;
+    }
+
+    // Free cached handles as long as the crypto library is out of memory
+    while (((err = OS_CryptoKey_import(&hKey, self->hCrypto, data))
+            == OS_ERROR_INSUFFICIENT_SPACE)
+           && evictLru(self))
+    {
+        ;
+    }
+    if (err != OS_SUCCESS)
+    {
+        goto out;
+    }
+
+    if ((NULL == (e = findFree(self))) && evictLru(self))
+    {
+        e = findFree(self);
+    }
+    Debug_ASSERT(NULL != e);
+
+    strcpy(e->name, name);
+    e->hKey    = hKey;
+    e->attribs = data->attribs;
+    e->valid   = true;
+    *entry     = e;
+
+out:
+    // Do not keep key material around longer than needed
+    memset(data, 0, sizeof(*data));
+
+    return err;
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreDerived_init(
+    KeyStoreDerived_t*      self,
+    OS_Keystore_Handle_t    hKeystore,
+    OS_Crypto_Handle_t      hCrypto,
+    size_t                  capacity)
+{
+    if ((NULL == self) || (NULL == hKeystore) || (NULL == hCrypto)
+        || (0 == capacity) || (capacity > KeyStoreDerived_MAX_CACHED_KEYS))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(self, 0, sizeof(*self));
+    self->hKeystore = hKeystore;
+    self->hCrypto   = hCrypto;
+    self->capacity  = capacity;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreDerived_deriveKey(
+    KeyStoreDerived_t*      self,
+    const char*             masterName,
+    void const*             label,
+    size_t                  labelLen,
+    size_t                  childSize,
+    OS_CryptoKey_Handle_t*  hChild)
+{
+    const uint8_t counter = HKDF_BLOCK_COUNTER;
+    KeyStoreDerived_CacheEntry_t* entry;
+    OS_CryptoMac_Handle_t hMac;
+    OS_CryptoKey_Data_t child;
+    uint8_t prk[KeyStoreDerived_PRK_SIZE];
+    size_t prkLen = sizeof(prk);
+    OS_Error_t err, errFree;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((NULL == masterName) || (strlen(masterName) >= sizeof(entry->name))
+        || ((NULL == label) && (labelLen > 0))
+        || (labelLen > KeyStoreDerived_MAX_LABEL_LEN)
+        || ((childSize != 16) && (childSize != 24) && (childSize != 32))
+        || (NULL == hChild))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    if ((entry = findEntry(self, masterName)) != NULL)
+    {
+        self->numHits++;
+    }
+    else
+    {
+        self->numMisses++;
+        if ((err = importMaster(self, masterName, &entry)) != OS_SUCCESS)
+        {
+            return err;
+        }
+    }
+    entry->lastUse = ++self->clock;
+
+    // T(1) of HKDF-Expand, which is all we need for up to 32 bytes
+    if ((err = OS_CryptoMac_init(&hMac, self->hCrypto, entry->hKey,
+                                 OS_CryptoMac_ALG_HMAC_SHA256)) != OS_SUCCESS)
+    {
+        return err;
+    }
+    if (((labelLen == 0)
+         || ((err = OS_CryptoMac_process(hMac, label, labelLen))
+             == OS_SUCCESS))
+        && ((err = OS_CryptoMac_process(hMac, &counter, sizeof(counter)))
+            == OS_SUCCESS))
+    {
+        err = OS_CryptoMac_finalize(hMac, prk, &prkLen);
+    }
+    if ((errFree = OS_CryptoMac_free(hMac)) != OS_SUCCESS)
+    {
+        Debug_LOG_WARNING("OS_CryptoMac_free() failed with %d", errFree);
+    }
+    if (err != OS_SUCCESS)
+    {
+        goto out;
+    }
+    Debug_ASSERT(prkLen >= childSize);
+
+    memset(&child, 0, sizeof(child));
+    child.type    = OS_CryptoKey_TYPE_AES;
+    child.attribs = entry->attribs;
+    memcpy(child.data.aes.bytes, prk, childSize);
+    child.data.aes.len = childSize;
+
+    err = OS_CryptoKey_import(hChild, self->hCrypto, &child);
+    memset(&child, 0, sizeof(child));
+
+out:
+    memset(prk, 0, sizeof(prk));
+
+    return err;
+}
+
+void
+KeyStoreDerived_evict(
+    KeyStoreDerived_t*      self,
+    const char*             masterName)
+{
+    KeyStoreDerived_CacheEntry_t* entry;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((masterName != NULL)
+        && ((entry = findEntry(self, masterName)) != NULL))
+    {
+        evictEntry(self, entry);
+    }
+}
+
+void
+KeyStoreDerived_flush(
+    KeyStoreDerived_t*      self)
+{
+    Debug_ASSERT_SELF(self);
+
+    while (evictLru(self))
+    {
+        ;
+    }
+}
@@ -0,0 +1,415 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreDerivedTests.h"
+#include "keyStoreDerived.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Crypto.h"
+#include "OS_Keystore.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define AES_MASTER_NAME     "MasterAes"
+#define MAC_MASTER_NAME     "MasterMac"
+#define LABEL_A             "session-a"
+#define LABEL_B             "session-b"
+#define LABEL_LEN           (sizeof(LABEL_A) - 1)
+#define MAC_MASTER_SIZE     48
+#define CACHE_CAPACITY      2
+// Number of master keys in the eviction test, more than CACHE_CAPACITY
+#define NUM_MASTERS         4
+// Number of derivations per benchmark run
+#define NUM_DERIVATIONS     50
+
+/* Private variables ---------------------------------------------------------*/
+static KeyStoreDerived_t derived;
+static OS_CryptoKey_Data_t keyData;
+
+static const OS_CryptoKey_Spec_t aes256Spec =
+{
+    .type = OS_CryptoKey_SPECTYPE_BITS,
+    .key = {
+        .type = OS_CryptoKey_TYPE_AES,
+        .attribs.keepLocal = true,
+        .params.bits = 256
+    }
+};
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testDeriveKey(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto);
+static void
+testCacheEviction(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto);
+static void
+storeAesMaster(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    const char*          name);
+static void
+storeMacMaster(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    const char*          name);
+static void
+checkDerivedKey(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    const char*          name,
+    const char*          label,
+    size_t               childSize);
+static void
+exportChild(
+    const char* name,
+    const char* label,
+    size_t      childSize,
+    uint8_t*    bytes);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreDerivedTests(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto)
+{
+    TEST_START();
+
+    testDeriveKey(hKeystore, hCrypto);
+    testCacheEviction(hKeystore, hCrypto);
+
+    TEST_FINISH();
+}
+
+void keyStoreDerivedBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    const char*          backend)
+{
+    TEST_START("backend", backend);
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hChild;
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    storeAesMaster(hKeystore, hCrypto, AES_MASTER_NAME);
+
+    err = KeyStoreDerived_init(&derived, hKeystore, hCrypto, CACHE_CAPACITY);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Load and import the master key for every derivation
+    start = KeyStoreBenchmark_getCycles();
+    for (int i = 0; i < NUM_DERIVATIONS; i++)
+    {
+        KeyStoreDerived_flush(&derived);
+        err = KeyStoreDerived_deriveKey(&derived, AES_MASTER_NAME, LABEL_A,
+                                        LABEL_LEN, 32, &hChild);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        err = OS_CryptoKey_free(hChild);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("deriveKeyUncached", backend, 32,
+                             NUM_DERIVATIONS, cycles);
+
+    // Master key stays imported
+    start = KeyStoreBenchmark_getCycles();
+    for (int i = 0; i < NUM_DERIVATIONS; i++)
+    {
+        err = KeyStoreDerived_deriveKey(&derived, AES_MASTER_NAME, LABEL_A,
+                                        LABEL_LEN, 32, &hChild);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        err = OS_CryptoKey_free(hChild);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("deriveKeyCached", backend, 32,
+                             NUM_DERIVATIONS, cycles);
+    ASSERT_EQ_SZ(NUM_DERIVATIONS, derived.numMisses);
+
+    KeyStoreDerived_flush(&derived);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void
+testDeriveKey(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hChild;
+    uint8_t childA[32];
+    uint8_t childB[32];
+
+    /********************************** TestKeyStore_testCase_30 ************************************/
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    storeAesMaster(hKeystore, hCrypto, AES_MASTER_NAME);
+    storeMacMaster(hKeystore, hCrypto, MAC_MASTER_NAME);
+
+    err = KeyStoreDerived_init(&derived, hKeystore, hCrypto, CACHE_CAPACITY);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (size_t childSize = 16; childSize <= 32; childSize += 8)
+    {
+        checkDerivedKey(hKeystore, hCrypto, AES_MASTER_NAME, LABEL_A,
+                        childSize);
+        checkDerivedKey(hKeystore, hCrypto, MAC_MASTER_NAME, LABEL_A,
+                        childSize);
+    }
+    checkDerivedKey(hKeystore, hCrypto, AES_MASTER_NAME, "", 32);
+
+    // Each master key was loaded only once
+    ASSERT_EQ_SZ(2, derived.numMisses);
+
+    // Same label gives the same key, different labels give different keys
+    exportChild(AES_MASTER_NAME, LABEL_A, 32, childA);
+    exportChild(AES_MASTER_NAME, LABEL_A, 32, childB);
+    ASSERT_EQ_INT(0, memcmp(childA, childB, 32));
+    exportChild(AES_MASTER_NAME, LABEL_B, 32, childB);
+    ASSERT_TRUE(memcmp(childA, childB, 32) != 0);
+    exportChild(MAC_MASTER_NAME, LABEL_A, 32, childB);
+    ASSERT_TRUE(memcmp(childA, childB, 32) != 0);
+
+    // Parameter checks
+    err = KeyStoreDerived_deriveKey(&derived, AES_MASTER_NAME, LABEL_A,
+                                    LABEL_LEN, 20, &hChild);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreDerived_deriveKey(&derived, AES_MASTER_NAME, NULL,
+                                    LABEL_LEN, 32, &hChild);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreDerived_deriveKey(&derived, AES_MASTER_NAME, LABEL_A,
+                                    KeyStoreDerived_MAX_LABEL_LEN + 1, 32,
+                                    &hChild);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreDerived_deriveKey(&derived, AES_MASTER_NAME, LABEL_A,
+                                    LABEL_LEN, 32, NULL);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreDerived_init(&derived, hKeystore, hCrypto,
+                               KeyStoreDerived_MAX_CACHED_KEYS + 1);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    KeyStoreDerived_flush(&derived);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testCacheEviction(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hChild;
+    char name[16];
+    uint8_t childOld[32];
+    uint8_t childNew[32];
+
+    /********************************** TestKeyStore_testCase_31 ************************************/
+    err = KeyStoreDerived_init(&derived, hKeystore, hCrypto, CACHE_CAPACITY);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (int i = 0; i < NUM_MASTERS; i++)
+    {
+        snprintf(name, sizeof(name), "Master%d", i);
+        storeAesMaster(hKeystore, hCrypto, name);
+    }
+
+    // Cycling through more master keys than the cache holds evicts handles
+    for (int round = 0; round < 2; round++)
+    {
+        for (int i = 0; i < NUM_MASTERS; i++)
+        {
+            snprintf(name, sizeof(name), "Master%d", i);
+            checkDerivedKey(hKeystore, hCrypto, name, LABEL_A, 32);
+        }
+    }
+    ASSERT_EQ_SZ(2 * NUM_MASTERS, derived.numMisses);
+    ASSERT_EQ_SZ(2 * NUM_MASTERS - CACHE_CAPACITY, derived.numEvictions);
+
+    // The most recently used keys are still cached
+    exportChild(name, LABEL_A, 32, childOld);
+    ASSERT_EQ_SZ(2 * NUM_MASTERS, derived.numMisses);
+
+    // After replacing the master key, the cached handle has to be evicted
+    err = OS_Keystore_deleteKey(hKeystore, name);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    storeAesMaster(hKeystore, hCrypto, name);
+
+    KeyStoreDerived_evict(&derived, name);
+    exportChild(name, LABEL_A, 32, childNew);
+    ASSERT_TRUE(memcmp(childOld, childNew, 32) != 0);
+    checkDerivedKey(hKeystore, hCrypto, name, LABEL_A, 32);
+
+    // Deleted master keys cannot be used once evicted
+    err = OS_Keystore_deleteKey(hKeystore, name);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    KeyStoreDerived_evict(&derived, name);
+
+    err = KeyStoreDerived_deriveKey(&derived, name, LABEL_A, LABEL_LEN, 32,
+                                    &hChild);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    // Master keys of other types are rejected
+    memset(&keyData, 0, sizeof(keyData));
+    keyData.type = OS_CryptoKey_TYPE_RSA_PRV;
+    err = OS_Keystore_storeKey(hKeystore, name, &keyData, sizeof(keyData));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreDerived_deriveKey(&derived, name, LABEL_A, LABEL_LEN, 32,
+                                    &hChild);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_SUPPORTED, err);
+
+    KeyStoreDerived_flush(&derived);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+storeAesMaster(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    const char*          name)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hKey;
+
+    err = OS_CryptoKey_generate(&hKey, hCrypto, &aes256Spec);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_CryptoKey_export(hKey, &keyData);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_CryptoKey_free(hKey);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_Keystore_storeKey(hKeystore, name, &keyData, sizeof(keyData));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+storeMacMaster(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    const char*          name)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+
+    memset(&keyData, 0, sizeof(keyData));
+    keyData.type = OS_CryptoKey_TYPE_MAC;
+    keyData.attribs.keepLocal = true;
+    keyData.data.mac.len = MAC_MASTER_SIZE;
+
+    err = OS_CryptoRng_getBytes(hCrypto, OS_CryptoRng_FLAG_NONE,
+                                keyData.data.mac.bytes, MAC_MASTER_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_Keystore_storeKey(hKeystore, name, &keyData, sizeof(keyData));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+// Compares a derived key with HMAC-SHA256(master, label || 0x01), computed
+// from the master key as it is in the keystore
+static void
+checkDerivedKey(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    const char*          name,
+    const char*          label,
+    size_t               childSize)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hMaster;
+    OS_CryptoMac_Handle_t hMac;
+    static const uint8_t counter = 0x01;
+    uint8_t expected[32];
+    uint8_t child[32];
+    size_t len;
+
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hKeystore, name, &keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    if (OS_CryptoKey_TYPE_AES == keyData.type)
+    {
+        len = keyData.data.aes.len;
+        memmove(keyData.data.mac.bytes, keyData.data.aes.bytes, len);
+        keyData.data.mac.len = len;
+        keyData.type = OS_CryptoKey_TYPE_MAC;
+    }
+
+    err = OS_CryptoKey_import(&hMaster, hCrypto, &keyData);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_CryptoMac_init(&hMac, hCrypto, hMaster,
+                            OS_CryptoMac_ALG_HMAC_SHA256);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    if (strlen(label) > 0)
+    {
+        err = OS_CryptoMac_process(hMac, label, strlen(label));
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    err = OS_CryptoMac_process(hMac, &counter, sizeof(counter));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    len = sizeof(expected);
+    err = OS_CryptoMac_finalize(hMac, expected, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(sizeof(expected), len);
+
+    err = OS_CryptoMac_free(hMac);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = OS_CryptoKey_free(hMaster);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    exportChild(name, label, childSize, child);
+    ASSERT_EQ_INT(0, memcmp(expected, child, childSize));
+}
+
+static void
+exportChild(
+    const char* name,
+    const char* label,
+    size_t      childSize,
+    uint8_t*    bytes)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hChild;
+
+    err = KeyStoreDerived_deriveKey(&derived, name, label, strlen(label),
+                                    childSize, &hChild);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_CryptoKey_export(hChild, &keyData);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(OS_CryptoKey_TYPE_AES, keyData.type);
+    ASSERT_EQ_SZ(childSize, keyData.data.aes.len);
+    memcpy(bytes, keyData.data.aes.bytes, childSize);
+
+    err = OS_CryptoKey_free(hChild);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
@@ -0,0 +1,164 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreEntropyPool.h"
+#include "lib_debug/Debug.h"
+#include <string.h>
+
+/* Private functions prototypes ----------------------------------------------*/
+static size_t
+poolRead(
+    const size_t len);
+
+/* Private variables ---------------------------------------------------------*/
+static struct
+{
+    if_OS_Entropy_t             upstream;
+    bool                        pooled;
+    size_t                      level;
+    uint8_t                     data[KeyStoreEntropyPool_SIZE];
+    KeyStoreEntropyPool_Stats_t stats;
+} pool;
+
+// Replaces the dataport of the EntropySource towards the crypto library
+static uint8_t portBuf[OS_DATAPORT_DEFAULT_SIZE];
+static void* portPtr = portBuf;
+
+static const if_OS_Entropy_t poolIf =
+{
+    .read     = poolRead,
+    .dataport = OS_DATAPORT_ASSIGN(portPtr),
+};
+
+/* Private functions ---------------------------------------------------------*/
+// Reads up to len bytes from the EntropySource into dst
+static size_t
+upstreamRead(
+    void*   dst,
+    size_t  len)
+{
+    size_t portSize = OS_Dataport_getSize(pool.upstream.dataport);
+    size_t n;
+
+    n = pool.upstream.read((len < portSize) ? len : portSize);
+    pool.stats.numUpstreamReads++;
+
+    n = (n < len) ? n : len;
+    memcpy(dst, OS_Dataport_getBuf(pool.upstream.dataport), n);
+
+    return n;
+}
+
+static size_t
+poolRead(
+    const size_t len)
+{
+    size_t n = (len < sizeof(portBuf)) ? len : sizeof(portBuf);
+
+    pool.stats.numReads++;
+
+    if (!pool.pooled)
+    {
+        n = upstreamRead(portBuf, n);
+    }
+    else
+    {
+        if ((pool.level < n) && (KeyStoreEntropyPool_refill() != OS_SUCCESS))
+        {
+            Debug_LOG_WARNING("Entropy pool could not be refilled");
+        }
+
+        n = (pool.level < n) ? pool.level : n;
+
+        // Hand out from the top of the pool and wipe what was handed out, so
+        // it cannot be handed out twice
+        pool.level -= n;
+        memcpy(portBuf, &pool.data[pool.level], n);
+        memset(&pool.data[pool.level], 0, n);
+    }
+
+    pool.stats.numBytesServed += n;
+
+    return n;
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreEntropyPool_init(
+    const if_OS_Entropy_t*  upstream,
+    bool                    pooled)
+{
+    if ((NULL == upstream) || (NULL == upstream->read))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(&pool, 0, sizeof(pool));
+    pool.upstream = *upstream;
+    pool.pooled   = pooled;
+
+    return pooled ? KeyStoreEntropyPool_refill() : OS_SUCCESS;
+}
+
+const if_OS_Entropy_t*
+KeyStoreEntropyPool_getInterface(
+    void)
+{
+    return &poolIf;
+}
+
+void
+KeyStoreEntropyPool_setPooled(
+    bool pooled)
+{
+    pool.pooled = pooled;
+}
+
+OS_Error_t
+KeyStoreEntropyPool_refill(
+    void)
+{
+    size_t n;
+
+    while (pool.level < sizeof(pool.data))
+    {
+        n = upstreamRead(&pool.data[pool.level],
+                         sizeof(pool.data) - pool.level);
+        if (0 == n)
+        {
+            return OS_ERROR_ABORTED;
+        }
+        pool.level += n;
+    }
+
+    return OS_SUCCESS;
+}
+
+size_t
+KeyStoreEntropyPool_getFillLevel(
+    void)
+{
+    return pool.level;
+}
+
+void
+KeyStoreEntropyPool_getStats(
+    KeyStoreEntropyPool_Stats_t* stats)
+{
+    Debug_ASSERT(NULL != stats);
+
+    *stats = pool.stats;
+}
+
+void
+KeyStoreEntropyPool_resetStats(
+    void)
+{
+    memset(&pool.stats, 0, sizeof(pool.stats));
+}
@@ -0,0 +1,252 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreEntropyPoolTests.h"
+#include "keyStoreEntropyPool.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Crypto.h"
+#include "OS_Keystore.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define KEY_NAME            "Prov"
+#define READ_LEN            32
+// Number of keys generated per run; must not exceed the capacity of the
+// smallest keystore under test
+#define NUM_KEYS            8
+// Entropy the crypto library draws per generated key, at most; a burst of
+// NUM_KEYS keys has to fit into what is left of the pool after the reads of
+// test case 21
+#define MAX_ENTROPY_PER_KEY 512
+#define MAX_ENTROPY_BURST   (NUM_KEYS * MAX_ENTROPY_PER_KEY)
+
+Debug_STATIC_ASSERT(MAX_ENTROPY_BURST + 2 * READ_LEN
+                    <= KeyStoreEntropyPool_SIZE);
+
+/* Private variables ---------------------------------------------------------*/
+static OS_CryptoKey_Data_t keyData;
+
+static const OS_CryptoKey_Spec_t aes256Spec =
+{
+    .type = OS_CryptoKey_SPECTYPE_BITS,
+    .key = {
+        .type = OS_CryptoKey_TYPE_AES,
+        .attribs.keepLocal = true,
+        .params.bits = 256
+    }
+};
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testPoolRead(
+    void);
+static void
+testPoolKeyGeneration(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto);
+static void
+testPoolExhausted(
+    void);
+static KeyStoreBenchmark_Cycles_t
+provisionKeys(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreEntropyPoolTests(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto)
+{
+    TEST_START();
+
+    testPoolRead();
+    testPoolKeyGeneration(hKeystore, hCrypto);
+    testPoolExhausted();
+
+    TEST_FINISH();
+}
+
+void keyStoreEntropyPoolBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    const char*          backend)
+{
+    TEST_START("backend", backend);
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreEntropyPool_Stats_t stats;
+    KeyStoreBenchmark_Cycles_t cycles;
+
+    // Every request goes to the EntropySource
+    KeyStoreEntropyPool_setPooled(false);
+    KeyStoreEntropyPool_resetStats();
+    cycles = provisionKeys(hKeystore, hCrypto);
+    KeyStoreEntropyPool_getStats(&stats);
+    KeyStoreBenchmark_report("provisionKey", backend, sizeof(keyData),
+                             NUM_KEYS, cycles);
+    Debug_LOG_INFO("Unpooled: %zu entropy RPCs for %d keys",
+                   stats.numUpstreamReads, NUM_KEYS);
+
+    // Pool is topped up before the burst, as an idle loop would do
+    KeyStoreEntropyPool_setPooled(true);
+    err = KeyStoreEntropyPool_refill();
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    KeyStoreEntropyPool_resetStats();
+    cycles = provisionKeys(hKeystore, hCrypto);
+    KeyStoreEntropyPool_getStats(&stats);
+    KeyStoreBenchmark_report("provisionKeyPooled", backend, sizeof(keyData),
+                             NUM_KEYS, cycles);
+    Debug_LOG_INFO("Pooled: %zu entropy RPCs for %d keys",
+                   stats.numUpstreamReads, NUM_KEYS);
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void
+testPoolRead(
+    void)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    const if_OS_Entropy_t* entropy = KeyStoreEntropyPool_getInterface();
+    KeyStoreEntropyPool_Stats_t stats;
+    uint8_t first[READ_LEN];
+    size_t level;
+    size_t n;
+
+    /********************************** TestKeyStore_testCase_21 ************************************/
+    err = KeyStoreEntropyPool_refill();
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(KeyStoreEntropyPool_SIZE, KeyStoreEntropyPool_getFillLevel());
+
+    KeyStoreEntropyPool_resetStats();
+    level = KeyStoreEntropyPool_getFillLevel();
+
+    n = entropy->read(READ_LEN);
+    ASSERT_EQ_SZ(READ_LEN, n);
+    memcpy(first, OS_Dataport_getBuf(entropy->dataport), READ_LEN);
+    ASSERT_EQ_SZ(level - READ_LEN, KeyStoreEntropyPool_getFillLevel());
+
+    n = entropy->read(READ_LEN);
+    ASSERT_EQ_SZ(READ_LEN, n);
+    ASSERT_TRUE(memcmp(first, OS_Dataport_getBuf(entropy->dataport),
+                       READ_LEN) != 0);
+
+    KeyStoreEntropyPool_getStats(&stats);
+    ASSERT_EQ_SZ(2, stats.numReads);
+    ASSERT_EQ_SZ(0, stats.numUpstreamReads);
+    ASSERT_EQ_SZ(2 * READ_LEN, stats.numBytesServed);
+}
+
+static void
+testPoolKeyGeneration(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto)
+{
+    KeyStoreEntropyPool_Stats_t stats;
+
+    /********************************** TestKeyStore_testCase_22 ************************************/
+    // The pool was topped up by the caller and holds enough for the burst
+    ASSERT_TRUE(KeyStoreEntropyPool_getFillLevel() >= MAX_ENTROPY_BURST);
+    KeyStoreEntropyPool_resetStats();
+
+    provisionKeys(hKeystore, hCrypto);
+
+    KeyStoreEntropyPool_getStats(&stats);
+    Debug_LOG_INFO("%zu entropy RPCs and %zu bytes of entropy for %d keys",
+                   stats.numUpstreamReads, stats.numBytesServed, NUM_KEYS);
+
+    ASSERT_TRUE(stats.numBytesServed <= MAX_ENTROPY_BURST);
+    ASSERT_EQ_SZ(0, stats.numUpstreamReads);
+}
+
+static void
+testPoolExhausted(
+    void)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    const if_OS_Entropy_t* entropy = KeyStoreEntropyPool_getInterface();
+    KeyStoreEntropyPool_Stats_t stats;
+    size_t served;
+    size_t n;
+
+    /********************************** TestKeyStore_testCase_52 ************************************/
+    err = KeyStoreEntropyPool_refill();
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    KeyStoreEntropyPool_resetStats();
+
+    // Drain the pool, which takes no RPC
+    for (served = 0; served < KeyStoreEntropyPool_SIZE; served += n)
+    {
+        n = entropy->read(KeyStoreEntropyPool_SIZE - served);
+        ASSERT_TRUE(n > 0);
+    }
+    ASSERT_EQ_SZ(KeyStoreEntropyPool_SIZE, served);
+    ASSERT_EQ_SZ(0, KeyStoreEntropyPool_getFillLevel());
+
+    KeyStoreEntropyPool_getStats(&stats);
+    ASSERT_EQ_SZ(0, stats.numUpstreamReads);
+
+    // The next read refills the whole pool, one RPC per dataport
+    n = entropy->read(READ_LEN);
+    ASSERT_EQ_SZ(READ_LEN, n);
+    ASSERT_EQ_SZ(KeyStoreEntropyPool_SIZE - READ_LEN,
+                 KeyStoreEntropyPool_getFillLevel());
+
+    KeyStoreEntropyPool_getStats(&stats);
+    ASSERT_EQ_SZ(KeyStoreEntropyPool_SIZE / OS_DATAPORT_DEFAULT_SIZE,
+                 stats.numUpstreamReads);
+    ASSERT_EQ_SZ(KeyStoreEntropyPool_SIZE + READ_LEN, stats.numBytesServed);
+}
+
+// Generates NUM_KEYS keys, stores them into the keystore and wipes it again;
+// returns the cycles spent on generation and storing
+static KeyStoreBenchmark_Cycles_t
+provisionKeys(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hKey;
+    char name[sizeof(KEY_NAME) + 11];
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles = 0;
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        sprintf(name, "%s-%d", KEY_NAME, i);
+
+        start = KeyStoreBenchmark_getCycles();
+
+        err = OS_CryptoKey_generate(&hKey, hCrypto, &aes256Spec);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+        err = OS_CryptoKey_export(hKey, &keyData);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+        err = OS_Keystore_storeKey(hKeystore, name, &keyData, sizeof(keyData));
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+        cycles += KeyStoreBenchmark_getCycles() - start;
+
+        err = OS_CryptoKey_free(hKey);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    return cycles;
+}
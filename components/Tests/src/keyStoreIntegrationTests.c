@@ -8,6 +8,8 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "keyStoreIntegrationTests.h"
+#include "keyStoreCipherPool.h"
+#include "keyStoreBenchmark.h"
 #include "OS_Crypto.h"
 #include "OS_Keystore.h"
 #include "lib_debug/Debug.h"
@@ -22,6 +24,11 @@
 // Configuration of the testKeyStoreKeyPair
 #define PRV_KEY_NAME        "PrvKey"
 #define PUB_KEY_NAME        "PubKey"
+// Configuration of the testKeyStoreAESLanes
+#define NUM_KAT_LANES       7
+#define NUM_BENCH_KEYS      4
+#define NUM_BENCH_LANES     16
+#define BENCH_RECORD_LEN    (4 * AES_BLOCK_LEN)
 
 static const OS_CryptoKey_Spec_t aes256Spec =
 {
@@ -51,10 +58,94 @@ static const OS_CryptoKey_Spec_t rsa128Spec =
     }
 };
 
+// Known answers from FIPS-197 (appendix C) and SP 800-38A (F.1.1, F.2.1)
+static const struct
+{
+    const char* name;
+    uint8_t     key[32];
+    size_t      keyLen;
+} katKeys[] =
+{
+    {
+        "KatFips128",
+        {
+            0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+            0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+        },
+        16
+    },
+    {
+        "KatFips256",
+        {
+            0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+            0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+            0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+            0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f
+        },
+        32
+    },
+    {
+        "KatSp800",
+        {
+            0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+            0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+        },
+        16
+    },
+};
+static const uint8_t katFipsPt[AES_BLOCK_LEN] =
+{
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+static const uint8_t katFips128Ct[AES_BLOCK_LEN] =
+{
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+    0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+static const uint8_t katFips256Ct[AES_BLOCK_LEN] =
+{
+    0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+    0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89
+};
+static const uint8_t katSp800Pt[2 * AES_BLOCK_LEN] =
+{
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+    0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51
+};
+static const uint8_t katSp800EcbCt[2 * AES_BLOCK_LEN] =
+{
+    0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60,
+    0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97,
+    0xf5, 0xd3, 0xd5, 0x85, 0x03, 0xb9, 0x69, 0x9d,
+    0xe7, 0x85, 0x89, 0x5a, 0x96, 0xfd, 0xba, 0xaf
+};
+static const uint8_t katSp800Iv[AES_BLOCK_LEN] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+static const uint8_t katSp800CbcCt[2 * AES_BLOCK_LEN] =
+{
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+    0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee,
+    0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2
+};
+
 /* Private variables ---------------------------------------------------------*/
 static OS_CryptoKey_Data_t keyData;
+static KeyStoreCipherPool_t cipherPool;
+static uint8_t laneOut[NUM_BENCH_LANES][BENCH_RECORD_LEN];
 
 /* Private functions prototypes ----------------------------------------------*/
+static OS_CryptoKey_Handle_t
+loadKatKey(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    size_t               idx);
 static bool
 importExportKeyPairTest(
     OS_Keystore_Handle_t       hKeystore,
@@ -162,6 +253,231 @@ void testKeyStoreKeyPair(
     TEST_FINISH();
 }
 
+void testKeyStoreAESLanes(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto)
+{
+    TEST_START();
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hKeys[sizeof(katKeys) / sizeof(katKeys[0])];
+    KeyStoreCipherPool_Lane_t lanes[NUM_KAT_LANES];
+    uint8_t cbcPt[sizeof(katSp800Pt)];
+
+    /********************************** TestKeyStore_testCase_34 ************************************/
+    for (size_t i = 0; i < sizeof(katKeys) / sizeof(katKeys[0]); i++)
+    {
+        hKeys[i] = loadKatKey(hKeystore, hCrypto, i);
+    }
+
+    err = KeyStoreCipherPool_init(&cipherPool, hCrypto,
+                                  KeyStoreCipherPool_MAX_CONTEXTS);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Lanes with different keys, algorithms and sizes, interleaved
+    memset(laneOut, 0, sizeof(laneOut));
+    memset(lanes, 0, sizeof(lanes));
+    lanes[0] = (KeyStoreCipherPool_Lane_t)
+    {
+        hKeys[0], OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+        katFipsPt, AES_BLOCK_LEN, laneOut[0], OS_ERROR_GENERIC
+    };
+    lanes[1] = (KeyStoreCipherPool_Lane_t)
+    {
+        hKeys[2], OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+        katSp800Pt, AES_BLOCK_LEN, laneOut[1], OS_ERROR_GENERIC
+    };
+    lanes[2] = (KeyStoreCipherPool_Lane_t)
+    {
+        hKeys[1], OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+        katFipsPt, AES_BLOCK_LEN, laneOut[2], OS_ERROR_GENERIC
+    };
+    lanes[3] = (KeyStoreCipherPool_Lane_t)
+    {
+        hKeys[2], OS_CryptoCipher_ALG_AES_CBC_ENC, katSp800Iv,
+        katSp800Pt, sizeof(katSp800Pt), laneOut[3], OS_ERROR_GENERIC
+    };
+    lanes[4] = (KeyStoreCipherPool_Lane_t)
+    {
+        hKeys[2], OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+        katSp800Pt + AES_BLOCK_LEN, AES_BLOCK_LEN, laneOut[4], OS_ERROR_GENERIC
+    };
+    lanes[5] = (KeyStoreCipherPool_Lane_t)
+    {
+        hKeys[0], OS_CryptoCipher_ALG_AES_ECB_DEC, NULL,
+        katFips128Ct, AES_BLOCK_LEN, laneOut[5], OS_ERROR_GENERIC
+    };
+    lanes[6] = (KeyStoreCipherPool_Lane_t)
+    {
+        hKeys[2], OS_CryptoCipher_ALG_AES_CBC_DEC, katSp800Iv,
+        katSp800CbcCt, sizeof(katSp800CbcCt), laneOut[6], OS_ERROR_GENERIC
+    };
+
+    err = KeyStoreCipherPool_processLanes(&cipherPool, lanes, NUM_KAT_LANES);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    for (int i = 0; i < NUM_KAT_LANES; i++)
+    {
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, lanes[i].err);
+    }
+
+    ASSERT_EQ_INT(0, memcmp(katFips128Ct, laneOut[0], AES_BLOCK_LEN));
+    ASSERT_EQ_INT(0, memcmp(katSp800EcbCt, laneOut[1], AES_BLOCK_LEN));
+    ASSERT_EQ_INT(0, memcmp(katFips256Ct, laneOut[2], AES_BLOCK_LEN));
+    ASSERT_EQ_INT(0, memcmp(katSp800CbcCt, laneOut[3],
+                            sizeof(katSp800CbcCt)));
+    ASSERT_EQ_INT(0, memcmp(katSp800EcbCt + AES_BLOCK_LEN, laneOut[4],
+                            AES_BLOCK_LEN));
+    ASSERT_EQ_INT(0, memcmp(katFipsPt, laneOut[5], AES_BLOCK_LEN));
+    ASSERT_EQ_INT(0, memcmp(katSp800Pt, laneOut[6], sizeof(katSp800Pt)));
+
+    // One context per key and algorithm, no matter how lanes are ordered
+    ASSERT_EQ_SZ(6, cipherPool.numInits);
+
+    // Decrypt the CBC lane in place, on the pooled context
+    memcpy(cbcPt, katSp800CbcCt, sizeof(cbcPt));
+    lanes[0] = (KeyStoreCipherPool_Lane_t)
+    {
+        hKeys[2], OS_CryptoCipher_ALG_AES_CBC_DEC, katSp800Iv,
+        cbcPt, sizeof(cbcPt), cbcPt, OS_ERROR_GENERIC
+    };
+    err = KeyStoreCipherPool_processLanes(&cipherPool, lanes, 1);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(0, memcmp(katSp800Pt, cbcPt, sizeof(cbcPt)));
+    ASSERT_EQ_SZ(6, cipherPool.numInits);
+
+    // A bad lane fails on its own
+    lanes[1] = lanes[0];
+    lanes[1].iv  = NULL;
+    lanes[1].in  = katSp800CbcCt;
+    lanes[1].out = laneOut[1];
+    lanes[1].err = OS_ERROR_GENERIC;
+    memcpy(cbcPt, katSp800CbcCt, sizeof(cbcPt));
+    err = KeyStoreCipherPool_processLanes(&cipherPool, lanes, 2);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, lanes[0].err);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, lanes[1].err);
+    ASSERT_EQ_INT(0, memcmp(katSp800Pt, cbcPt, sizeof(cbcPt)));
+
+    // A bad lane does not fail the good lanes which share its key
+    memset(laneOut, 0, sizeof(laneOut));
+    lanes[0] = (KeyStoreCipherPool_Lane_t)
+    {
+        hKeys[2], OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+        katSp800Pt, AES_BLOCK_LEN, laneOut[0], OS_ERROR_GENERIC
+    };
+    lanes[1] = (KeyStoreCipherPool_Lane_t)
+    {
+        hKeys[2], OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+        katSp800Pt, AES_BLOCK_LEN - 1, laneOut[1], OS_ERROR_GENERIC
+    };
+    lanes[2] = (KeyStoreCipherPool_Lane_t)
+    {
+        hKeys[2], OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+        katSp800Pt + AES_BLOCK_LEN, AES_BLOCK_LEN, laneOut[2], OS_ERROR_GENERIC
+    };
+    err = KeyStoreCipherPool_processLanes(&cipherPool, lanes, 3);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, lanes[0].err);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, lanes[1].err);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, lanes[2].err);
+    ASSERT_EQ_INT(0, memcmp(katSp800EcbCt, laneOut[0], AES_BLOCK_LEN));
+    ASSERT_EQ_INT(0, memcmp(katSp800EcbCt + AES_BLOCK_LEN, laneOut[2],
+                            AES_BLOCK_LEN));
+
+    err = KeyStoreCipherPool_processLanes(&cipherPool, lanes,
+                                          KeyStoreCipherPool_MAX_LANES + 1);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    KeyStoreCipherPool_free(&cipherPool);
+
+    for (size_t i = 0; i < sizeof(katKeys) / sizeof(katKeys[0]); i++)
+    {
+        err = OS_CryptoKey_free(hKeys[i]);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+void keyStoreAESLanesBenchmark(
+    OS_Crypto_Handle_t   hCrypto)
+{
+    TEST_START();
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hKeys[NUM_BENCH_KEYS];
+    KeyStoreCipherPool_Lane_t lanes[NUM_BENCH_LANES];
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+    size_t len;
+
+    for (int i = 0; i < NUM_BENCH_KEYS; i++)
+    {
+        err = OS_CryptoKey_generate(&hKeys[i], hCrypto, &aes256Spec);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    // Records are spread round-robin over the keys
+    for (int i = 0; i < NUM_BENCH_LANES; i++)
+    {
+        memset(laneOut[i], i, BENCH_RECORD_LEN);
+        lanes[i] = (KeyStoreCipherPool_Lane_t)
+        {
+            hKeys[i % NUM_BENCH_KEYS], OS_CryptoCipher_ALG_AES_ECB_ENC, NULL,
+            laneOut[i], BENCH_RECORD_LEN, laneOut[i], OS_ERROR_GENERIC
+        };
+    }
+
+    // Looping over the single-buffer API
+    start = KeyStoreBenchmark_getCycles();
+    for (int i = 0; i < NUM_BENCH_LANES; i++)
+    {
+        OS_CryptoCipher_Handle_t hCipher;
+
+        err = OS_CryptoCipher_init(&hCipher, hCrypto, lanes[i].hKey,
+                                   lanes[i].alg, NULL, 0);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        len = BENCH_RECORD_LEN;
+        err = OS_CryptoCipher_process(hCipher, lanes[i].in, lanes[i].len,
+                                      lanes[i].out, &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        err = OS_CryptoCipher_free(hCipher);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("aesSingleBufferLoop", "Crypto",
+                             BENCH_RECORD_LEN, NUM_BENCH_LANES, cycles);
+
+    // All lanes in one call, with cold and with warm contexts
+    err = KeyStoreCipherPool_init(&cipherPool, hCrypto, NUM_BENCH_KEYS);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (int run = 0; run < 2; run++)
+    {
+        start = KeyStoreBenchmark_getCycles();
+        err = KeyStoreCipherPool_processLanes(&cipherPool, lanes,
+                                              NUM_BENCH_LANES);
+        cycles = KeyStoreBenchmark_getCycles() - start;
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        KeyStoreBenchmark_report(run ? "aesLanesWarm" :
+                                 "aesLanesCold", "Crypto",
+                                 BENCH_RECORD_LEN, NUM_BENCH_LANES, cycles);
+    }
+
+    KeyStoreCipherPool_free(&cipherPool);
+
+    for (int i = 0; i < NUM_BENCH_KEYS; i++)
+    {
+        err = OS_CryptoKey_free(hKeys[i]);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    TEST_FINISH();
+}
+
 /* Private functions ---------------------------------------------------------*/
 static bool
 importExportKeyPairTest(
@@ -308,3 +624,35 @@ aesDecrypt(
 
     return err;
 }
+
+// Stores a known-answer key in the keystore and imports it from there
+static OS_CryptoKey_Handle_t
+loadKatKey(
+    OS_Keystore_Handle_t hKeystore,
+    OS_Crypto_Handle_t   hCrypto,
+    size_t               idx)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hKey;
+    size_t len;
+
+    memset(&keyData, 0, sizeof(keyData));
+    keyData.type = OS_CryptoKey_TYPE_AES;
+    keyData.attribs.keepLocal = true;
+    keyData.data.aes.len = katKeys[idx].keyLen;
+    memcpy(keyData.data.aes.bytes, katKeys[idx].key, katKeys[idx].keyLen);
+
+    err = OS_Keystore_storeKey(hKeystore, katKeys[idx].name, &keyData,
+                               sizeof(keyData));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hKeystore, katKeys[idx].name, &keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(sizeof(keyData), len);
+
+    err = OS_CryptoKey_import(&hKey, hCrypto, &keyData);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    return hKey;
+}
@@ -0,0 +1,375 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreManager.h"
+#include "OS_KeystoreFile.h"
+#include "lib_debug/Debug.h"
+#include <string.h>
+
+/* Private functions ---------------------------------------------------------*/
+static bool
+isValidName(
+    const char* name,
+    size_t      maxLen)
+{
+    return (name != NULL) && (name[0] != '\0')
+           && (strnlen(name, maxLen + 1) <= maxLen);
+}
+
+// Slot of a key in the metadata cache, which is direct mapped
+static KeyStoreManager_Meta_t*
+metaSlot(
+    KeyStoreManager_t*  self,
+    size_t              id,
+    const char*         name)
+{
+    // FNV-1a over the id and the name
+    uint32_t hash = 2166136261u ^ (uint32_t) id;
+
+    hash *= 16777619u;
+    for (; *name != '\0'; name++)
+    {
+        hash = (hash ^ (uint8_t) *name) * 16777619u;
+    }
+
+    return &self->meta[hash % KeyStoreManager_META_SLOTS];
+}
+
+static KeyStoreManager_Meta_t*
+findMeta(
+    KeyStoreManager_t*  self,
+    size_t              id,
+    const char*         name)
+{
+    KeyStoreManager_Meta_t* meta = metaSlot(self, id, name);
+
+    return (meta->valid && (meta->id == id) && !strcmp(meta->name, name)) ?
+           meta : NULL;
+}
+
+static void
+recordMeta(
+    KeyStoreManager_t*  self,
+    size_t              id,
+    const char*         name,
+    bool                exists,
+    size_t              size)
+{
+    KeyStoreManager_Meta_t* meta = metaSlot(self, id, name);
+
+    if (strlen(name) >= sizeof(meta->name))
+    {
+        return;
+    }
+
+    meta->valid  = true;
+    meta->id     = (uint16_t) id;
+    meta->exists = exists;
+    meta->size   = size;
+    strcpy(meta->name, name);
+}
+
+static OS_Error_t
+closeKeystore(
+    KeyStoreManager_t*          self,
+    KeyStoreManager_Keystore_t* ks)
+{
+    OS_Error_t err;
+
+    if ((err = OS_Keystore_free(ks->hKeystore)) != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("Closing keystore '%s' failed with %d",
+                        ks->name, err);
+        return err;
+    }
+
+    ks->hKeystore = NULL;
+    self->numOpen--;
+    self->numCloses++;
+
+    return OS_SUCCESS;
+}
+
+// Returns the handle of a keystore, opening it if needed
+static OS_Error_t
+acquire(
+    KeyStoreManager_t*      self,
+    size_t                  id,
+    OS_Keystore_Handle_t*   hKeystore)
+{
+    KeyStoreManager_Keystore_t* ks;
+    KeyStoreManager_Keystore_t* victim = NULL;
+    OS_Error_t err;
+
+    if (id >= self->numKeystores)
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    ks = &self->keystores[id];
+    if (NULL == ks->hKeystore)
+    {
+        if (self->numOpen >= self->maxOpen)
+        {
+            for (size_t i = 0; i < self->numKeystores; i++)
+            {
+                if ((self->keystores[i].hKeystore != NULL)
+                    && ((NULL == victim)
+                        || (self->keystores[i].lastUse < victim->lastUse)))
+                {
+                    victim = &self->keystores[i];
+                }
+            }
+            if ((err = closeKeystore(self, victim)) != OS_SUCCESS)
+            {
+                return err;
+            }
+        }
+
+        if ((err = OS_KeystoreFile_init(&ks->hKeystore, self->hFs,
+                                        self->hCrypto, ks->name))
+            != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("Opening keystore '%s' failed with %d",
+                            ks->name, err);
+            ks->hKeystore = NULL;
+            return err;
+        }
+        self->numOpen++;
+        self->numOpens++;
+    }
+
+    ks->lastUse = ++self->clock;
+    *hKeystore  = ks->hKeystore;
+
+    return OS_SUCCESS;
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreManager_init(
+    KeyStoreManager_t*      self,
+    OS_FileSystem_Handle_t  hFs,
+    OS_Crypto_Handle_t      hCrypto,
+    size_t                  maxOpen)
+{
+    if ((NULL == self) || (NULL == hFs) || (NULL == hCrypto)
+        || (0 == maxOpen) || (maxOpen > KeyStoreManager_MAX_OPEN))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(self, 0, sizeof(*self));
+    self->hFs     = hFs;
+    self->hCrypto = hCrypto;
+    self->maxOpen = maxOpen;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreManager_free(
+    KeyStoreManager_t*      self)
+{
+    OS_Error_t err;
+    OS_Error_t result = OS_SUCCESS;
+
+    Debug_ASSERT_SELF(self);
+
+    for (size_t i = 0; i < self->numKeystores; i++)
+    {
+        if ((self->keystores[i].hKeystore != NULL)
+            && ((err = closeKeystore(self, &self->keystores[i]))
+                != OS_SUCCESS))
+        {
+            result = err;
+        }
+    }
+
+    return result;
+}
+
+OS_Error_t
+KeyStoreManager_addKeystore(
+    KeyStoreManager_t*      self,
+    const char*             name,
+    size_t*                 id)
+{
+    KeyStoreManager_Keystore_t* ks;
+
+    Debug_ASSERT_SELF(self);
+
+    if (!isValidName(name, sizeof(ks->name) - 1) || (NULL == id))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    for (size_t i = 0; i < self->numKeystores; i++)
+    {
+        if (!strcmp(self->keystores[i].name, name))
+        {
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    if (self->numKeystores >= KeyStoreManager_MAX_KEYSTORES)
+    {
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    ks = &self->keystores[self->numKeystores];
+    strcpy(ks->name, name);
+    ks->hKeystore = NULL;
+    *id = self->numKeystores++;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreManager_storeKey(
+    KeyStoreManager_t*      self,
+    size_t                  id,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize)
+{
+    OS_Keystore_Handle_t hKeystore;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((err = acquire(self, id, &hKeystore)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    err = OS_Keystore_storeKey(hKeystore, name, keyData, keySize);
+    if (OS_SUCCESS == err)
+    {
+        recordMeta(self, id, name, true, keySize);
+    }
+
+    return err;
+}
+
+OS_Error_t
+KeyStoreManager_loadKey(
+    KeyStoreManager_t*      self,
+    size_t                  id,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize)
+{
+    KeyStoreManager_Meta_t* meta;
+    OS_Keystore_Handle_t hKeystore;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((id >= self->numKeystores) || (NULL == name) || (NULL == keyData)
+        || (NULL == keySize))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    if ((meta = findMeta(self, id, name)) != NULL)
+    {
+        if (!meta->exists)
+        {
+            self->numMetaHits++;
+            return OS_ERROR_NOT_FOUND;
+        }
+        if (*keySize < meta->size)
+        {
+            self->numMetaHits++;
+            *keySize = meta->size;
+            return OS_ERROR_BUFFER_TOO_SMALL;
+        }
+    }
+
+    if ((err = acquire(self, id, &hKeystore)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    err = OS_Keystore_loadKey(hKeystore, name, keyData, keySize);
+    if (OS_SUCCESS == err)
+    {
+        recordMeta(self, id, name, true, *keySize);
+    }
+    else if (OS_ERROR_NOT_FOUND == err)
+    {
+        recordMeta(self, id, name, false, 0);
+    }
+
+    return err;
+}
+
+OS_Error_t
+KeyStoreManager_deleteKey(
+    KeyStoreManager_t*      self,
+    size_t                  id,
+    const char*             name)
+{
+    OS_Keystore_Handle_t hKeystore;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((err = acquire(self, id, &hKeystore)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    err = OS_Keystore_deleteKey(hKeystore, name);
+    if ((OS_SUCCESS == err) || (OS_ERROR_NOT_FOUND == err))
+    {
+        recordMeta(self, id, name, false, 0);
+    }
+
+    return err;
+}
+
+OS_Error_t
+KeyStoreManager_wipeKeystore(
+    KeyStoreManager_t*      self,
+    size_t                  id)
+{
+    OS_Keystore_Handle_t hKeystore;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((err = acquire(self, id, &hKeystore)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    // Forget about the keys of this keystore even if wiping fails halfway
+    for (size_t i = 0; i < KeyStoreManager_META_SLOTS; i++)
+    {
+        if (self->meta[i].valid && (self->meta[i].id == id))
+        {
+            self->meta[i].valid = false;
+        }
+    }
+
+    return OS_Keystore_wipeKeystore(hKeystore);
+}
+
+bool
+KeyStoreManager_isOpen(
+    KeyStoreManager_t*      self,
+    size_t                  id)
+{
+    Debug_ASSERT_SELF(self);
+
+    return (id < self->numKeystores)
+           && (self->keystores[id].hKeystore != NULL);
+}
@@ -0,0 +1,348 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreManagerTests.h"
+#include "keyStoreManager.h"
+#include "keyStoreBenchmark.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define KEY_NAME            "TenantKey"
+#define KEY_SIZE            32
+
+// Keystores kept in the file system and how many of them may be open
+#define NUM_KEYSTORES       120
+#define MAX_OPEN            8
+
+// Keystores used by the benchmark
+#define NUM_BENCH_KEYSTORES 16
+
+/* Private variables ---------------------------------------------------------*/
+// Too large for the stack
+static KeyStoreManager_t manager;
+static size_t ids[NUM_KEYSTORES];
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testManagerLazyOpen(
+    void);
+static void
+testManagerMetaCache(
+    void);
+static void
+addKeystores(
+    size_t  numKeystores);
+static void
+wipeKeystores(
+    size_t  numKeystores);
+static void
+makeKey(
+    size_t  index,
+    uint8_t data[KEY_SIZE]);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreManagerTests(
+    OS_FileSystem_Handle_t  hFs,
+    OS_Crypto_Handle_t      hCrypto)
+{
+    TEST_START();
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+
+    err = KeyStoreManager_init(&manager, hFs, hCrypto,
+                               KeyStoreManager_MAX_OPEN + 1);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreManager_init(&manager, hFs, hCrypto, MAX_OPEN);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    addKeystores(NUM_KEYSTORES);
+
+    testManagerLazyOpen();
+    testManagerMetaCache();
+
+    wipeKeystores(NUM_KEYSTORES);
+    err = KeyStoreManager_free(&manager);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(0, manager.numOpen);
+
+    TEST_FINISH();
+}
+
+void keyStoreManagerBenchmark(
+    OS_FileSystem_Handle_t  hFs,
+    OS_Crypto_Handle_t      hCrypto)
+{
+    TEST_START();
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+    uint8_t data[KEY_SIZE];
+    uint8_t loaded[KEY_SIZE];
+    size_t len;
+
+    Debug_LOG_INFO("Manager takes %zu bytes for %d keystores, %zu bytes per "
+                   "keystore and %zu bytes per cached key",
+                   sizeof(KeyStoreManager_t), KeyStoreManager_MAX_KEYSTORES,
+                   sizeof(KeyStoreManager_Keystore_t),
+                   sizeof(KeyStoreManager_Meta_t));
+
+    // One keystore is open at a time, so every keystore is opened again
+    err = KeyStoreManager_init(&manager, hFs, hCrypto, 1);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    addKeystores(NUM_BENCH_KEYSTORES);
+
+    for (size_t i = 0; i < NUM_BENCH_KEYSTORES; i++)
+    {
+        makeKey(i, data);
+        err = KeyStoreManager_storeKey(&manager, ids[i], KEY_NAME, data,
+                                       sizeof(data));
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    start = KeyStoreBenchmark_getCycles();
+    for (size_t i = 0; i < NUM_BENCH_KEYSTORES; i++)
+    {
+        len = sizeof(loaded);
+        err = KeyStoreManager_loadKey(&manager, ids[i], KEY_NAME, loaded,
+                                      &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("loadKeyFirstAccess", "File", KEY_SIZE,
+                             NUM_BENCH_KEYSTORES, cycles);
+
+    // The last keystore stays open
+    start = KeyStoreBenchmark_getCycles();
+    for (size_t i = 0; i < NUM_BENCH_KEYSTORES; i++)
+    {
+        len = sizeof(loaded);
+        err = KeyStoreManager_loadKey(&manager,
+                                      ids[NUM_BENCH_KEYSTORES - 1], KEY_NAME,
+                                      loaded, &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("loadKeyOpenKeystore", "File", KEY_SIZE,
+                             NUM_BENCH_KEYSTORES, cycles);
+
+    // Missing keys of closed keystores come from the metadata cache
+    for (size_t i = 0; i < NUM_BENCH_KEYSTORES; i++)
+    {
+        len = sizeof(loaded);
+        err = KeyStoreManager_loadKey(&manager, ids[i], "Missing", loaded,
+                                      &len);
+        ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    }
+    start = KeyStoreBenchmark_getCycles();
+    for (size_t i = 0; i < NUM_BENCH_KEYSTORES; i++)
+    {
+        len = sizeof(loaded);
+        err = KeyStoreManager_loadKey(&manager, ids[i], "Missing", loaded,
+                                      &len);
+        ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("loadKeyMissingCached", "File", KEY_SIZE,
+                             NUM_BENCH_KEYSTORES, cycles);
+
+    wipeKeystores(NUM_BENCH_KEYSTORES);
+    err = KeyStoreManager_free(&manager);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void
+addKeystores(
+    size_t  numKeystores)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    char name[16];
+
+    for (size_t i = 0; i < numKeystores; i++)
+    {
+        snprintf(name, sizeof(name), "tenant%03u", (unsigned) i % 1000);
+        err = KeyStoreManager_addKeystore(&manager, name, &ids[i]);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+}
+
+static void
+wipeKeystores(
+    size_t  numKeystores)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+
+    for (size_t i = 0; i < numKeystores; i++)
+    {
+        err = KeyStoreManager_wipeKeystore(&manager, ids[i]);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+}
+
+static void
+makeKey(
+    size_t  index,
+    uint8_t data[KEY_SIZE])
+{
+    for (size_t i = 0; i < KEY_SIZE; i++)
+    {
+        data[i] = (uint8_t)(index * 7 + i);
+    }
+}
+
+static void
+testManagerLazyOpen(
+    void)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    uint8_t data[KEY_SIZE];
+    uint8_t loaded[KEY_SIZE];
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_44 ************************************/
+    // Registering opens nothing
+    ASSERT_EQ_SZ(0, manager.numOpen);
+    ASSERT_EQ_SZ(0, manager.numOpens);
+    ASSERT_TRUE(!KeyStoreManager_isOpen(&manager, ids[0]));
+
+    for (size_t i = 0; i < NUM_KEYSTORES; i++)
+    {
+        makeKey(i, data);
+        err = KeyStoreManager_storeKey(&manager, ids[i], KEY_NAME, data,
+                                       sizeof(data));
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        ASSERT_TRUE(KeyStoreManager_isOpen(&manager, ids[i]));
+        ASSERT_TRUE(manager.numOpen <= MAX_OPEN);
+    }
+    ASSERT_EQ_SZ(NUM_KEYSTORES, manager.numOpens);
+    ASSERT_EQ_SZ(MAX_OPEN, manager.numOpen);
+
+    // The least recently used keystores were closed
+    ASSERT_TRUE(!KeyStoreManager_isOpen(&manager, ids[0]));
+    ASSERT_TRUE(KeyStoreManager_isOpen(&manager, ids[NUM_KEYSTORES - 1]));
+
+    // Every keystore has its own key under the same name, also after it was
+    // closed and opened again
+    for (size_t i = 0; i < NUM_KEYSTORES; i++)
+    {
+        makeKey(i, data);
+        len = sizeof(loaded);
+        err = KeyStoreManager_loadKey(&manager, ids[i], KEY_NAME, loaded,
+                                      &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        ASSERT_EQ_SZ(sizeof(data), len);
+        ASSERT_EQ_INT(0, memcmp(data, loaded, sizeof(data)));
+    }
+    ASSERT_EQ_SZ(MAX_OPEN, manager.numOpen);
+    ASSERT_EQ_SZ(manager.numOpens - MAX_OPEN, manager.numCloses);
+
+    // Deleting a key in one keystore leaves the others alone
+    err = KeyStoreManager_deleteKey(&manager, ids[1], KEY_NAME);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    len = sizeof(loaded);
+    err = KeyStoreManager_loadKey(&manager, ids[1], KEY_NAME, loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    len = sizeof(loaded);
+    err = KeyStoreManager_loadKey(&manager, ids[2], KEY_NAME, loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testManagerMetaCache(
+    void)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    uint8_t loaded[KEY_SIZE];
+    size_t numOpens;
+    size_t numMetaHits;
+    size_t id;
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_45 ************************************/
+    // Make sure the first keystore is closed
+    for (size_t i = NUM_KEYSTORES - MAX_OPEN; i < NUM_KEYSTORES; i++)
+    {
+        len = sizeof(loaded);
+        err = KeyStoreManager_loadKey(&manager, ids[i], KEY_NAME, loaded,
+                                      &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    ASSERT_TRUE(!KeyStoreManager_isOpen(&manager, ids[0]));
+
+    // The first miss opens the keystore, the second one is served from the
+    // cache even after the keystore was closed again
+    len = sizeof(loaded);
+    err = KeyStoreManager_loadKey(&manager, ids[0], "Missing", loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    ASSERT_TRUE(KeyStoreManager_isOpen(&manager, ids[0]));
+    for (size_t i = 1; i <= MAX_OPEN; i++)
+    {
+        len = sizeof(loaded);
+        err = KeyStoreManager_loadKey(&manager, ids[i + 2], KEY_NAME, loaded,
+                                      &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    ASSERT_TRUE(!KeyStoreManager_isOpen(&manager, ids[0]));
+
+    numOpens    = manager.numOpens;
+    numMetaHits = manager.numMetaHits;
+    len = sizeof(loaded);
+    err = KeyStoreManager_loadKey(&manager, ids[0], "Missing", loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    ASSERT_EQ_SZ(numOpens, manager.numOpens);
+    ASSERT_EQ_SZ(numMetaHits + 1, manager.numMetaHits);
+
+    // So is the size of a key that does not fit the buffer
+    len = sizeof(loaded);
+    err = KeyStoreManager_loadKey(&manager, ids[3], KEY_NAME, loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    len = 1;
+    err = KeyStoreManager_loadKey(&manager, ids[3], KEY_NAME, loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_BUFFER_TOO_SMALL, err);
+    ASSERT_EQ_SZ(KEY_SIZE, len);
+    ASSERT_EQ_SZ(numMetaHits + 2, manager.numMetaHits);
+
+    // A deleted key is known to be missing without opening its keystore
+    err = KeyStoreManager_deleteKey(&manager, ids[1], KEY_NAME);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    numOpens = manager.numOpens;
+    len = sizeof(loaded);
+    err = KeyStoreManager_loadKey(&manager, ids[1], KEY_NAME, loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    ASSERT_EQ_SZ(numOpens, manager.numOpens);
+
+    // Storing the key again is seen by the cache
+    err = KeyStoreManager_storeKey(&manager, ids[0], "Missing", loaded,
+                                   sizeof(loaded));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    len = sizeof(loaded);
+    err = KeyStoreManager_loadKey(&manager, ids[0], "Missing", loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Invalid ids and names
+    len = sizeof(loaded);
+    err = KeyStoreManager_loadKey(&manager, NUM_KEYSTORES, KEY_NAME, loaded,
+                                  &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreManager_storeKey(&manager, NUM_KEYSTORES, KEY_NAME, loaded,
+                                   sizeof(loaded));
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreManager_addKeystore(&manager, "tenant000", &id);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreManager_addKeystore(&manager, "tenant_name_long", &id);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreManager_addKeystore(&manager, "", &id);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+}
@@ -0,0 +1,204 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreProvisioning.h"
+#include "lib_debug/Debug.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private functions ---------------------------------------------------------*/
+static void
+freeHandles(
+    KeyStoreProvisioning_t* self,
+    size_t                  n)
+{
+    for (size_t k = 0; k < n; k++)
+    {
+        if (self->hPrv[k] != NULL)
+        {
+            OS_CryptoKey_free(self->hPrv[k]);
+            self->hPrv[k] = NULL;
+        }
+        if (self->hPub[k] != NULL)
+        {
+            OS_CryptoKey_free(self->hPub[k]);
+            self->hPub[k] = NULL;
+        }
+    }
+}
+
+static OS_Error_t
+generateBatch(
+    KeyStoreProvisioning_t* self,
+    size_t                  n)
+{
+    OS_Crypto_Handle_t hCrypto;
+    OS_Error_t err;
+
+    for (size_t k = 0; k < n; k++)
+    {
+        hCrypto = self->workers[self->nextWorker];
+        self->nextWorker = (self->nextWorker + 1) % self->numWorkers;
+
+        if (((err = OS_CryptoKey_generate(&self->hPrv[k], hCrypto,
+                                          &self->spec)) != OS_SUCCESS)
+            || ((err = OS_CryptoKey_makePublic(&self->hPub[k], hCrypto,
+                                               self->hPrv[k],
+                                               &self->spec.key.attribs))
+                != OS_SUCCESS))
+        {
+            Debug_LOG_ERROR("Generating pair %zu of batch failed with %d",
+                            k, err);
+            return err;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+static OS_Error_t
+exportBatch(
+    KeyStoreProvisioning_t* self,
+    size_t                  n)
+{
+    OS_Error_t err;
+
+    for (size_t k = 0; k < n; k++)
+    {
+        if (((err = OS_CryptoKey_export(self->hPrv[k], &self->prv[k]))
+             != OS_SUCCESS)
+            || ((err = OS_CryptoKey_export(self->hPub[k], &self->pub[k]))
+                != OS_SUCCESS))
+        {
+            return err;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+static OS_Error_t
+storeBatch(
+    KeyStoreProvisioning_t* self,
+    const char*             prefix,
+    size_t                  first,
+    size_t                  n)
+{
+    char name[16];
+    size_t stored;
+    OS_Error_t err = OS_SUCCESS;
+
+    // Count stored halves, so they can be removed again on failure
+    for (stored = 0; stored < 2 * n; stored++)
+    {
+        KeyStoreProvisioning_getName(prefix, first + stored / 2, stored & 1,
+                                     name);
+        err = OS_Keystore_storeKey(self->hKeystore, name,
+                                   (stored & 1) ? &self->pub[stored / 2]
+                                   : &self->prv[stored / 2],
+                                   sizeof(OS_CryptoKey_Data_t));
+        if (err != OS_SUCCESS)
+        {
+            Debug_LOG_ERROR("Storing '%s' failed with %d", name, err);
+            break;
+        }
+    }
+
+    if (err != OS_SUCCESS)
+    {
+        while (stored-- > 0)
+        {
+            KeyStoreProvisioning_getName(prefix, first + stored / 2,
+                                         stored & 1, name);
+            OS_Keystore_deleteKey(self->hKeystore, name);
+        }
+    }
+
+    return err;
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreProvisioning_init(
+    KeyStoreProvisioning_t*     self,
+    OS_Keystore_Handle_t        hKeystore,
+    const OS_Crypto_Handle_t*   workers,
+    size_t                      numWorkers,
+    const OS_CryptoKey_Spec_t*  spec,
+    size_t                      batchSize)
+{
+    if ((NULL == self) || (NULL == hKeystore) || (NULL == workers)
+        || (0 == numWorkers) || (numWorkers > KeyStoreProvisioning_MAX_WORKERS)
+        || (NULL == spec) || (0 == batchSize)
+        || (batchSize > KeyStoreProvisioning_MAX_BATCH))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(self, 0, sizeof(*self));
+    self->hKeystore  = hKeystore;
+    self->numWorkers = numWorkers;
+    self->spec       = *spec;
+    self->batchSize  = batchSize;
+    memcpy(self->workers, workers, numWorkers * sizeof(workers[0]));
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreProvisioning_run(
+    KeyStoreProvisioning_t*     self,
+    const char*                 prefix,
+    size_t                      first,
+    size_t                      count)
+{
+    OS_Error_t err = OS_SUCCESS;
+    size_t n;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((NULL == prefix)
+        || (strlen(prefix) > KeyStoreProvisioning_MAX_PREFIX_LEN)
+        || (first + count > KeyStoreProvisioning_MAX_PAIRS))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    for (size_t i = 0; (i < count) && (OS_SUCCESS == err); i += n)
+    {
+        n = (count - i < self->batchSize) ? count - i : self->batchSize;
+
+        if (((err = generateBatch(self, n)) == OS_SUCCESS)
+            && ((err = exportBatch(self, n)) == OS_SUCCESS))
+        {
+            // The crypto handles are not needed for storing
+            freeHandles(self, n);
+            if ((err = storeBatch(self, prefix, first + i, n)) == OS_SUCCESS)
+            {
+                self->numPairs += n;
+            }
+        }
+
+        freeHandles(self, n);
+        memset(self->prv, 0, n * sizeof(self->prv[0]));
+        memset(self->pub, 0, n * sizeof(self->pub[0]));
+    }
+
+    return err;
+}
+
+void
+KeyStoreProvisioning_getName(
+    const char*                 prefix,
+    size_t                      index,
+    bool                        isPublic,
+    char*                       name)
+{
+    snprintf(name, 16, "%s%04zu%s", prefix, index, isPublic ? "Pub" : "Prv");
+}
@@ -0,0 +1,378 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreProvisioningTests.h"
+#include "keyStoreProvisioning.h"
+#include "keyStoreSeededEntropy.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Crypto.h"
+#include "OS_Keystore.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define KEY_PREFIX          "Dev"
+#define SEED                0x5eed0001ULL
+#define OTHER_SEED          0x5eed0002ULL
+#define NUM_WORKERS         2
+#define BATCH_SIZE          3
+// Number of pairs per run; both halves must fit into the smallest keystore
+// under test
+#define NUM_PAIRS           4
+
+/* Private variables ---------------------------------------------------------*/
+static KeyStoreProvisioning_t prov;
+static OS_Crypto_Handle_t workers[NUM_WORKERS];
+static OS_CryptoKey_Data_t loaded;
+static OS_CryptoKey_Data_t exported;
+static uint64_t digests[NUM_PAIRS];
+
+static const OS_CryptoKey_Spec_t rsa128Spec =
+{
+    .type = OS_CryptoKey_SPECTYPE_BITS,
+    .key = {
+        .type = OS_CryptoKey_TYPE_RSA_PRV,
+        .attribs.keepLocal = true,
+        .params.bits = 128
+    }
+};
+static const OS_CryptoKey_Spec_t dh64Spec =
+{
+    .type = OS_CryptoKey_SPECTYPE_BITS,
+    .key = {
+        .type = OS_CryptoKey_TYPE_DH_PRV,
+        .attribs.keepLocal = true,
+        .params.bits = 64
+    }
+};
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testProvisionPairs(
+    OS_Keystore_Handle_t hKeystore);
+static void
+testDeterminism(
+    OS_Keystore_Handle_t hKeystore);
+static void
+initWorkers(
+    uint64_t seed,
+    size_t   numWorkers);
+static void
+freeWorkers(
+    size_t   numWorkers);
+static void
+provision(
+    OS_Keystore_Handle_t       hKeystore,
+    const OS_CryptoKey_Spec_t* spec,
+    uint64_t                   seed);
+static void
+checkPair(
+    OS_Keystore_Handle_t hKeystore,
+    size_t               index);
+static uint64_t
+digestKey(
+    OS_Keystore_Handle_t hKeystore,
+    size_t               index);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreProvisioningTests(
+    OS_Keystore_Handle_t hKeystore)
+{
+    TEST_START();
+
+    testProvisionPairs(hKeystore);
+    testDeterminism(hKeystore);
+
+    TEST_FINISH();
+}
+
+void keyStoreProvisioningBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    const char*          backend)
+{
+    TEST_START("backend", backend);
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+
+    // The workers are called one after the other, so more of them would not
+    // generate any faster; one worker gives the cost per pair
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    initWorkers(SEED, 1);
+    err = KeyStoreProvisioning_init(&prov, hKeystore, workers, 1,
+                                    &rsa128Spec, BATCH_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    start = KeyStoreBenchmark_getCycles();
+    err = KeyStoreProvisioning_run(&prov, KEY_PREFIX, 0, NUM_PAIRS);
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    KeyStoreBenchmark_report("provisionPair", backend,
+                             rsa128Spec.key.params.bits / 8, NUM_PAIRS,
+                             cycles);
+    freeWorkers(1);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void
+testProvisionPairs(
+    OS_Keystore_Handle_t hKeystore)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    char name[16];
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_35 ************************************/
+    provision(hKeystore, &rsa128Spec, SEED);
+    for (size_t i = 0; i < NUM_PAIRS; i++)
+    {
+        checkPair(hKeystore, i);
+    }
+    ASSERT_EQ_SZ(NUM_PAIRS, prov.numPairs);
+
+    // Nothing beyond the requested pairs
+    KeyStoreProvisioning_getName(KEY_PREFIX, NUM_PAIRS, false, name);
+    len = sizeof(loaded);
+    err = OS_Keystore_loadKey(hKeystore, name, &loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    // A batch which cannot be stored completely leaves no half pair behind
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    KeyStoreProvisioning_getName(KEY_PREFIX, 1, true, name);
+    err = OS_Keystore_storeKey(hKeystore, name, KEY_PREFIX,
+                               sizeof(KEY_PREFIX));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    initWorkers(SEED, NUM_WORKERS);
+    err = KeyStoreProvisioning_init(&prov, hKeystore, workers, NUM_WORKERS,
+                                    &rsa128Spec, BATCH_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreProvisioning_run(&prov, KEY_PREFIX, 0, 2);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    ASSERT_EQ_SZ(0, prov.numPairs);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        KeyStoreProvisioning_getName(KEY_PREFIX, i / 2, i & 1, name);
+        len = sizeof(loaded);
+        err = OS_Keystore_loadKey(hKeystore, name, &loaded, &len);
+        ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    }
+
+    // Parameter checks
+    err = KeyStoreProvisioning_run(&prov, "PrefixTooLong", 0, 1);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreProvisioning_run(&prov, KEY_PREFIX,
+                                   KeyStoreProvisioning_MAX_PAIRS, 1);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreProvisioning_init(&prov, hKeystore, workers, 0,
+                                    &rsa128Spec, BATCH_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreProvisioning_init(&prov, hKeystore, workers, NUM_WORKERS,
+                                    &rsa128Spec,
+                                    KeyStoreProvisioning_MAX_BATCH + 1);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    freeWorkers(NUM_WORKERS);
+
+    // DH pairs go the same way
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    provision(hKeystore, &dh64Spec, SEED);
+    for (size_t i = 0; i < NUM_PAIRS; i++)
+    {
+        checkPair(hKeystore, i);
+    }
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testDeterminism(
+    OS_Keystore_Handle_t hKeystore)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    size_t same = 0;
+
+    /********************************** TestKeyStore_testCase_36 ************************************/
+    provision(hKeystore, &rsa128Spec, SEED);
+    for (size_t i = 0; i < NUM_PAIRS; i++)
+    {
+        digests[i] = digestKey(hKeystore, i);
+    }
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    provision(hKeystore, &rsa128Spec, SEED);
+    for (size_t i = 0; i < NUM_PAIRS; i++)
+    {
+        ASSERT_TRUE(digests[i] == digestKey(hKeystore, i));
+    }
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    provision(hKeystore, &rsa128Spec, OTHER_SEED);
+    for (size_t i = 0; i < NUM_PAIRS; i++)
+    {
+        same += (digests[i] == digestKey(hKeystore, i));
+    }
+    ASSERT_EQ_SZ(0, same);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+initWorkers(
+    uint64_t seed,
+    size_t   numWorkers)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_Crypto_Config_t cfg =
+    {
+        .mode = OS_Crypto_MODE_LIBRARY,
+    };
+
+    KeyStoreSeededEntropy_init(seed);
+    cfg.entropy = *KeyStoreSeededEntropy_getInterface();
+
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        err = OS_Crypto_init(&workers[i], &cfg);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+}
+
+static void
+freeWorkers(
+    size_t   numWorkers)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        err = OS_Crypto_free(workers[i]);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+}
+
+static void
+provision(
+    OS_Keystore_Handle_t       hKeystore,
+    const OS_CryptoKey_Spec_t* spec,
+    uint64_t                   seed)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+
+    initWorkers(seed, NUM_WORKERS);
+
+    err = KeyStoreProvisioning_init(&prov, hKeystore, workers, NUM_WORKERS,
+                                    spec, BATCH_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreProvisioning_run(&prov, KEY_PREFIX, 0, NUM_PAIRS);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    freeWorkers(NUM_WORKERS);
+}
+
+// Imports the private key of a pair and checks that exporting it and making
+// it public gives what is stored in the keystore
+static void
+checkPair(
+    OS_Keystore_Handle_t hKeystore,
+    size_t               index)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_CryptoKey_Handle_t hPrv;
+    OS_CryptoKey_Handle_t hPub;
+    char name[16];
+    size_t len;
+
+    initWorkers(SEED, 1);
+
+    KeyStoreProvisioning_getName(KEY_PREFIX, index, false, name);
+    len = sizeof(loaded);
+    err = OS_Keystore_loadKey(hKeystore, name, &loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(sizeof(loaded), len);
+
+    err = OS_CryptoKey_import(&hPrv, workers[0], &loaded);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    memset(&exported, 0, sizeof(exported));
+    err = OS_CryptoKey_export(hPrv, &exported);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(0, memcmp(&loaded, &exported, sizeof(loaded)));
+
+    err = OS_CryptoKey_makePublic(&hPub, workers[0], hPrv, &loaded.attribs);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    KeyStoreProvisioning_getName(KEY_PREFIX, index, true, name);
+    len = sizeof(loaded);
+    err = OS_Keystore_loadKey(hKeystore, name, &loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    memset(&exported, 0, sizeof(exported));
+    err = OS_CryptoKey_export(hPub, &exported);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(0, memcmp(&loaded, &exported, sizeof(loaded)));
+
+    err = OS_CryptoKey_free(hPub);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = OS_CryptoKey_free(hPrv);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    freeWorkers(1);
+}
+
+// FNV-1a over the stored private key of a pair
+static uint64_t
+digestKey(
+    OS_Keystore_Handle_t hKeystore,
+    size_t               index)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    const uint8_t* p = (const uint8_t*) &loaded;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    char name[16];
+    size_t len;
+
+    KeyStoreProvisioning_getName(KEY_PREFIX, index, false, name);
+    len = sizeof(loaded);
+    err = OS_Keystore_loadKey(hKeystore, name, &loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (size_t i = 0; i < len; i++)
+    {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+
+    return h;
+}
@@ -0,0 +1,182 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreRamFVImage.h"
+#include "keyStoreCrc32c.h"
+#include "lib_debug/Debug.h"
+#include <stddef.h>
+#include <string.h>
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t
+headerCrc(
+    const KeyStoreRamFVImage_Header_t* header)
+{
+    return KeyStoreCrc32c_compute(
+               header, offsetof(KeyStoreRamFVImage_Header_t, headerCrc));
+}
+
+// Size of the buffer up to its last non-zero byte
+static size_t
+occupiedSize(
+    const uint8_t*  buf,
+    size_t          bufSize)
+{
+    while ((bufSize > 0) && (0 == buf[bufSize - 1]))
+    {
+        bufSize--;
+    }
+
+    return bufSize;
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreRamFVImage_serialize(
+    const void*             buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs,
+    const char*             fileName,
+    size_t*                 imageSize)
+{
+    KeyStoreRamFVImage_Header_t header;
+    OS_FileSystemFile_Handle_t hFile;
+    OS_Error_t err;
+    OS_Error_t errClose;
+
+    if ((NULL == buf) || (0 == bufSize) || (bufSize > UINT32_MAX)
+        || (NULL == hFs) || (NULL == fileName))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic     = KeyStoreRamFVImage_MAGIC;
+    header.version   = KeyStoreRamFVImage_VERSION;
+    header.bufSize   = (uint32_t) bufSize;
+    header.dataSize  = (uint32_t) occupiedSize(buf, bufSize);
+    header.dataCrc   = KeyStoreCrc32c_compute(buf, header.dataSize);
+    header.headerCrc = headerCrc(&header);
+
+    if ((err = OS_FileSystemFile_open(hFs, &hFile, fileName,
+                                      OS_FileSystem_OpenMode_WRONLY,
+                                      OS_FileSystem_OpenFlags_CREATE
+                                      | OS_FileSystem_OpenFlags_TRUNCATE))
+        != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("Opening '%s' failed with %d", fileName, err);
+        return err;
+    }
+
+    // Header and data are written back to back, in one pass over the file
+    err = OS_FileSystemFile_write(hFs, hFile, 0, sizeof(header), &header);
+    if ((OS_SUCCESS == err) && (header.dataSize > 0))
+    {
+        err = OS_FileSystemFile_write(hFs, hFile, sizeof(header),
+                                      header.dataSize, buf);
+    }
+    errClose = OS_FileSystemFile_close(hFs, hFile);
+    if (OS_SUCCESS == err)
+    {
+        err = errClose;
+    }
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("Writing the image to '%s' failed with %d",
+                        fileName, err);
+        return err;
+    }
+
+    if (imageSize != NULL)
+    {
+        *imageSize = sizeof(header) + header.dataSize;
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreRamFVImage_deserialize(
+    void*                   buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs,
+    const char*             fileName)
+{
+    KeyStoreRamFVImage_Header_t header;
+    OS_FileSystemFile_Handle_t hFile;
+    off_t fileSize;
+    OS_Error_t err;
+
+    if ((NULL == buf) || (0 == bufSize) || (NULL == hFs)
+        || (NULL == fileName))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    if ((err = OS_FileSystemFile_getSize(hFs, fileName, &fileSize))
+        != OS_SUCCESS)
+    {
+        return err;
+    }
+    if (fileSize < (off_t) sizeof(header))
+    {
+        Debug_LOG_ERROR("Image '%s' is truncated", fileName);
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    if ((err = OS_FileSystemFile_open(hFs, &hFile, fileName,
+                                      OS_FileSystem_OpenMode_RDONLY,
+                                      OS_FileSystem_OpenFlags_NONE))
+        != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    err = OS_FileSystemFile_read(hFs, hFile, 0, sizeof(header), &header);
+    if (err != OS_SUCCESS)
+    {
+        goto out;
+    }
+
+    // Nothing is written to the buffer unless the image fits it
+    if ((header.magic != KeyStoreRamFVImage_MAGIC)
+        || (header.version != KeyStoreRamFVImage_VERSION)
+        || (header.headerCrc != headerCrc(&header))
+        || (header.bufSize != bufSize)
+        || (header.dataSize > header.bufSize)
+        || (fileSize != (off_t)(sizeof(header) + header.dataSize)))
+    {
+        Debug_LOG_ERROR("Image '%s' is invalid or does not fit the buffer",
+                        fileName);
+        err = OS_ERROR_INVALID_STATE;
+        goto out;
+    }
+
+    if (header.dataSize > 0)
+    {
+        err = OS_FileSystemFile_read(hFs, hFile, sizeof(header),
+                                     header.dataSize, buf);
+        if (err != OS_SUCCESS)
+        {
+            goto out;
+        }
+    }
+    memset((uint8_t*) buf + header.dataSize, 0, bufSize - header.dataSize);
+
+    if (KeyStoreCrc32c_compute(buf, header.dataSize) != header.dataCrc)
+    {
+        Debug_LOG_ERROR("Image '%s' does not match its checksum", fileName);
+        err = OS_ERROR_INVALID_STATE;
+    }
+
+out:
+    OS_FileSystemFile_close(hFs, hFile);
+
+    return err;
+}
@@ -0,0 +1,301 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreRamFVImageTests.h"
+#include "keyStoreRamFVImage.h"
+#include "keyStoreCrc32c.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Keystore.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define IMAGE_FILE_NAME     "ramfv.img"
+#define KEY_SIZE            32
+
+// Keys stored for the tests and for the benchmark, the RamFV keystore must
+// fit them all
+#define NUM_KEYS            6
+#define NUM_BOOT_KEYS       8
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t keyData[KEY_SIZE];
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testImageRoundTrip(
+    OS_Keystore_Handle_t    hKeystore,
+    void*                   buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs);
+static void
+testImageRejected(
+    OS_Keystore_Handle_t    hKeystore,
+    void*                   buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs);
+static void
+makeKey(
+    size_t  index,
+    char*   name,
+    size_t  nameSize,
+    uint8_t data[KEY_SIZE]);
+static void
+checkKeys(
+    OS_Keystore_Handle_t    hKeystore,
+    size_t                  numKeys);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreRamFVImageTests(
+    OS_Keystore_Handle_t    hKeystore,
+    void*                   buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs)
+{
+    TEST_START();
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+
+    testImageRoundTrip(hKeystore, buf, bufSize, hFs);
+    testImageRejected(hKeystore, buf, bufSize, hFs);
+
+    err = OS_FileSystemFile_delete(hFs, IMAGE_FILE_NAME);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+void keyStoreRamFVImageBenchmark(
+    OS_Keystore_Handle_t    hKeystore,
+    void*                   buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs,
+    OS_Keystore_Handle_t    hPersistent)
+{
+    TEST_START();
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+    uint8_t data[KEY_SIZE];
+    char name[16];
+    size_t imageSize;
+    size_t len;
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = OS_Keystore_wipeKeystore(hPersistent);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (size_t i = 0; i < NUM_BOOT_KEYS; i++)
+    {
+        makeKey(i, name, sizeof(name), data);
+        err = OS_Keystore_storeKey(hPersistent, name, data, sizeof(data));
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        err = OS_Keystore_storeKey(hKeystore, name, data, sizeof(data));
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    start = KeyStoreBenchmark_getCycles();
+    err = KeyStoreRamFVImage_serialize(buf, bufSize, hFs, IMAGE_FILE_NAME,
+                                       &imageSize);
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    KeyStoreBenchmark_report("serializeImage", "RamFV", KEY_SIZE,
+                             NUM_BOOT_KEYS, cycles);
+    Debug_LOG_INFO("Image of %d keys takes %zu of %zu bytes",
+                   NUM_BOOT_KEYS, imageSize,
+                   sizeof(KeyStoreRamFVImage_Header_t) + bufSize);
+
+    // Boot as it is done without images
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    start = KeyStoreBenchmark_getCycles();
+    for (size_t i = 0; i < NUM_BOOT_KEYS; i++)
+    {
+        makeKey(i, name, sizeof(name), data);
+        len = sizeof(data);
+        err = OS_Keystore_loadKey(hPersistent, name, data, &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        err = OS_Keystore_storeKey(hKeystore, name, data, len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("bootReimport", "RamFV", KEY_SIZE,
+                             NUM_BOOT_KEYS, cycles);
+    checkKeys(hKeystore, NUM_BOOT_KEYS);
+
+    // Boot from the image
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    start = KeyStoreBenchmark_getCycles();
+    err = KeyStoreRamFVImage_deserialize(buf, bufSize, hFs, IMAGE_FILE_NAME);
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    KeyStoreBenchmark_report("bootImage", "RamFV", KEY_SIZE, NUM_BOOT_KEYS,
+                             cycles);
+    checkKeys(hKeystore, NUM_BOOT_KEYS);
+
+    err = OS_FileSystemFile_delete(hFs, IMAGE_FILE_NAME);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = OS_Keystore_wipeKeystore(hPersistent);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void
+makeKey(
+    size_t  index,
+    char*   name,
+    size_t  nameSize,
+    uint8_t data[KEY_SIZE])
+{
+    snprintf(name, nameSize, "Image%zu", index);
+    for (size_t i = 0; i < KEY_SIZE; i++)
+    {
+        data[i] = (uint8_t)(0x11 * (index + 1) + i);
+    }
+}
+
+static void
+checkKeys(
+    OS_Keystore_Handle_t    hKeystore,
+    size_t                  numKeys)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    uint8_t data[KEY_SIZE];
+    char name[16];
+    size_t len;
+
+    for (size_t i = 0; i < numKeys; i++)
+    {
+        makeKey(i, name, sizeof(name), data);
+        len = sizeof(keyData);
+        err = OS_Keystore_loadKey(hKeystore, name, keyData, &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        ASSERT_EQ_SZ(sizeof(data), len);
+        ASSERT_EQ_INT(0, memcmp(data, keyData, sizeof(data)));
+    }
+}
+
+static void
+testImageRoundTrip(
+    OS_Keystore_Handle_t    hKeystore,
+    void*                   buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    uint8_t data[KEY_SIZE];
+    char name[16];
+    uint32_t crcBefore;
+    size_t imageSize;
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_42 ************************************/
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (size_t i = 0; i < NUM_KEYS; i++)
+    {
+        makeKey(i, name, sizeof(name), data);
+        err = OS_Keystore_storeKey(hKeystore, name, data, sizeof(data));
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    crcBefore = KeyStoreCrc32c_compute(buf, bufSize);
+
+    err = KeyStoreRamFVImage_serialize(buf, bufSize, hFs, IMAGE_FILE_NAME,
+                                       &imageSize);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_TRUE(imageSize <= sizeof(KeyStoreRamFVImage_Header_t) + bufSize);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    makeKey(0, name, sizeof(name), data);
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hKeystore, name, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    err = KeyStoreRamFVImage_deserialize(buf, bufSize, hFs, IMAGE_FILE_NAME);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // The buffer and thus every key is back
+    ASSERT_TRUE(crcBefore == KeyStoreCrc32c_compute(buf, bufSize));
+    checkKeys(hKeystore, NUM_KEYS);
+
+    // The restored keystore keeps working
+    makeKey(NUM_KEYS, name, sizeof(name), data);
+    err = OS_Keystore_storeKey(hKeystore, name, data, sizeof(data));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    checkKeys(hKeystore, NUM_KEYS + 1);
+}
+
+static void
+testImageRejected(
+    OS_Keystore_Handle_t    hKeystore,
+    void*                   buf,
+    size_t                  bufSize,
+    OS_FileSystem_Handle_t  hFs)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_FileSystemFile_Handle_t hFile;
+    uint32_t crcBefore;
+    uint8_t byte;
+
+    /********************************** TestKeyStore_testCase_43 ************************************/
+    err = KeyStoreRamFVImage_serialize(buf, bufSize, hFs, IMAGE_FILE_NAME,
+                                       NULL);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    crcBefore = KeyStoreCrc32c_compute(buf, bufSize);
+
+    // An image of a buffer of another size leaves the buffer alone
+    err = KeyStoreRamFVImage_deserialize(buf, bufSize - 1, hFs,
+                                         IMAGE_FILE_NAME);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_STATE, err);
+    ASSERT_TRUE(crcBefore == KeyStoreCrc32c_compute(buf, bufSize));
+
+    err = KeyStoreRamFVImage_deserialize(buf, bufSize, hFs, "noimage.img");
+    ASSERT_TRUE(err != OS_SUCCESS);
+    ASSERT_TRUE(crcBefore == KeyStoreCrc32c_compute(buf, bufSize));
+
+    // Flip a bit of the first byte of the data
+    err = OS_FileSystemFile_open(hFs, &hFile, IMAGE_FILE_NAME,
+                                 OS_FileSystem_OpenMode_RDWR,
+                                 OS_FileSystem_OpenFlags_NONE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = OS_FileSystemFile_read(hFs, hFile,
+                                 sizeof(KeyStoreRamFVImage_Header_t),
+                                 sizeof(byte), &byte);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    byte ^= 0x01;
+    err = OS_FileSystemFile_write(hFs, hFile,
+                                  sizeof(KeyStoreRamFVImage_Header_t),
+                                  sizeof(byte), &byte);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = OS_FileSystemFile_close(hFs, hFile);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreRamFVImage_deserialize(buf, bufSize, hFs, IMAGE_FILE_NAME);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_STATE, err);
+
+    // The buffer is undefined after that, so the keystore is wiped
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
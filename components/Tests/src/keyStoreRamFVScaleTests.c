@@ -0,0 +1,501 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "system_config.h"
+
+#include "keyStoreRamFVScaleTests.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Keystore.h"
+#include "OS_KeystoreRamFV.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define SCALE_NUM_ELEMENTS  KeyStore_Config_SCALE_NUM_ELEMENTS
+
+// Every phase of the benchmark is measured in this many rounds
+#define NUM_ROUNDS          8
+// Rounds of fewer operations are reported, but too short to bound their cost
+#define MIN_ROUND_OPS       16
+// Operations per round of the churn, which keeps the fill level constant and
+// so is not limited by the capacity
+#define CHURN_ROUND_OPS(capacity)   ((capacity) / 4)
+
+#if SCALE_NUM_ELEMENTS < 16 * NUM_ROUNDS
+#error "KeyStore_Config_SCALE_NUM_ELEMENTS is too small for the scaling test"
+#endif
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+    size_t  capacity;
+    size_t  keySize;
+} ScaleConfig_t;
+
+/* Private variables ---------------------------------------------------------*/
+// The benchmark compares the first and the third configuration
+static const ScaleConfig_t configs[] =
+{
+    { SCALE_NUM_ELEMENTS / 16,  32 },
+    { SCALE_NUM_ELEMENTS / 4,   32 },
+    { SCALE_NUM_ELEMENTS,       32 },
+    { SCALE_NUM_ELEMENTS / 4,   1024 },
+    { SCALE_NUM_ELEMENTS / 16,  KeyStore_Config_MAX_KEY_SIZE },
+};
+#define NUM_CONFIGS     (sizeof(configs) / sizeof(configs[0]))
+
+static char keystoreBuf[OS_KeystoreRamFV_SIZE_OF_BUFFER(SCALE_NUM_ELEMENTS)];
+
+// Ids of the keys in the keystore, in no particular order
+static uint32_t live[SCALE_NUM_ELEMENTS];
+static size_t numLive;
+static uint32_t nextId;
+static uint32_t rngState;
+
+static uint8_t keyData[KeyStore_Config_MAX_KEY_SIZE];
+static uint8_t loadedData[KeyStore_Config_MAX_KEY_SIZE];
+
+// Cycles of every operation of a round, a single interrupt must not decide
+// the outcome of the benchmark
+static KeyStoreBenchmark_Cycles_t samples[CHURN_ROUND_OPS(SCALE_NUM_ELEMENTS)];
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testScaleFillDrain(
+    const ScaleConfig_t* config);
+static void
+testScaleChurn(
+    const ScaleConfig_t* config);
+static KeyStoreBenchmark_Cycles_t
+benchmarkScale(
+    const ScaleConfig_t* config);
+static OS_Keystore_Handle_t
+openKeystore(
+    size_t capacity);
+static OS_Error_t
+storeNewKey(
+    OS_Keystore_Handle_t    hKeystore,
+    size_t                  keySize);
+static OS_Error_t
+deleteRandomKey(
+    OS_Keystore_Handle_t    hKeystore);
+static void
+checkLiveKeys(
+    OS_Keystore_Handle_t    hKeystore,
+    size_t                  keySize);
+static void
+fillUp(
+    OS_Keystore_Handle_t    hKeystore,
+    const ScaleConfig_t*    config);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreRamFVScaleTests(void)
+{
+    TEST_START();
+
+    for (size_t i = 0; i < NUM_CONFIGS; i++)
+    {
+        testScaleFillDrain(&configs[i]);
+        testScaleChurn(&configs[i]);
+    }
+
+    TEST_FINISH();
+}
+
+void keyStoreRamFVScaleBenchmark(void)
+{
+    TEST_START();
+
+    KeyStoreBenchmark_Cycles_t storeFull[NUM_CONFIGS];
+
+    for (size_t i = 0; i < NUM_CONFIGS; i++)
+    {
+        storeFull[i] = benchmarkScale(&configs[i]);
+    }
+
+    // Storing into an almost full keystore of 16 times the capacity, with the
+    // same key size, gets 16 times more expensive if the keystore searches
+    // its keys or slots linearly; only a part of that growth is allowed
+    Debug_LOG_INFO("Storing into an almost full keystore costs %llu cycles "
+                   "per key with capacity %zu, %llu with capacity %zu",
+                   (unsigned long long) storeFull[2], configs[2].capacity,
+                   (unsigned long long) storeFull[0], configs[0].capacity);
+    if (configs[0].capacity / NUM_ROUNDS >= MIN_ROUND_OPS)
+    {
+        ASSERT_TRUE(100 * storeFull[2] <= 100 * storeFull[0]
+                    + KeyStore_Config_SCALE_MAX_GROWTH_PERCENT * 15
+                    * storeFull[0]);
+    }
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t
+nextRandom(void)
+{
+    // xorshift32, seeded in openKeystore() so every run does the same
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+
+    return rngState;
+}
+
+static int
+compareCycles(
+    const void* a,
+    const void* b)
+{
+    KeyStoreBenchmark_Cycles_t x = *(const KeyStoreBenchmark_Cycles_t*) a;
+    KeyStoreBenchmark_Cycles_t y = *(const KeyStoreBenchmark_Cycles_t*) b;
+
+    return (x > y) - (x < y);
+}
+
+// Returns the total of the samples of a round and sorts them to get their
+// median
+static KeyStoreBenchmark_Cycles_t
+sumAndMedian(
+    size_t                      count,
+    KeyStoreBenchmark_Cycles_t* median)
+{
+    KeyStoreBenchmark_Cycles_t sum = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        sum += samples[i];
+    }
+
+    qsort(samples, count, sizeof(samples[0]), compareCycles);
+    *median = samples[count / 2];
+
+    return sum;
+}
+
+static void
+makeKey(
+    uint32_t    id,
+    size_t      keySize,
+    char        name[16])
+{
+    snprintf(name, 16, "s%u", (unsigned) id);
+    for (size_t i = 0; i < keySize; i++)
+    {
+        keyData[i] = (uint8_t)(id * 31 + i);
+    }
+}
+
+static OS_Keystore_Handle_t
+openKeystore(
+    size_t capacity)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_Keystore_Handle_t hKeystore;
+    size_t bufSize = OS_KeystoreRamFV_SIZE_OF_BUFFER(capacity);
+
+    // Also touches the buffer, so no page faults end up in the timings
+    memset(keystoreBuf, 0, bufSize);
+
+    err = OS_KeystoreRamFV_init(&hKeystore, keystoreBuf, bufSize);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    numLive  = 0;
+    nextId   = 0;
+    rngState = 0x2545F491u;
+
+    return hKeystore;
+}
+
+static void
+closeKeystore(
+    OS_Keystore_Handle_t hKeystore)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = OS_Keystore_free(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static OS_Error_t
+storeNewKey(
+    OS_Keystore_Handle_t    hKeystore,
+    size_t                  keySize)
+{
+    OS_Error_t err;
+    char name[16];
+
+    makeKey(nextId, keySize, name);
+    if ((err = OS_Keystore_storeKey(hKeystore, name, keyData, keySize))
+        == OS_SUCCESS)
+    {
+        live[numLive++] = nextId++;
+    }
+
+    return err;
+}
+
+static OS_Error_t
+deleteRandomKey(
+    OS_Keystore_Handle_t    hKeystore)
+{
+    OS_Error_t err;
+    size_t i = nextRandom() % numLive;
+    char name[16];
+
+    snprintf(name, sizeof(name), "s%u", (unsigned) live[i]);
+    if ((err = OS_Keystore_deleteKey(hKeystore, name)) == OS_SUCCESS)
+    {
+        live[i] = live[--numLive];
+    }
+
+    return err;
+}
+
+static void
+checkLiveKeys(
+    OS_Keystore_Handle_t    hKeystore,
+    size_t                  keySize)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    char name[16];
+    size_t len;
+
+    for (size_t i = 0; i < numLive; i++)
+    {
+        makeKey(live[i], keySize, name);
+        len = sizeof(loadedData);
+        err = OS_Keystore_loadKey(hKeystore, name, loadedData, &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        ASSERT_EQ_SZ(keySize, len);
+        ASSERT_EQ_INT(0, memcmp(keyData, loadedData, keySize));
+    }
+}
+
+// Stores keys until the keystore is full and checks that it takes no more
+static void
+fillUp(
+    OS_Keystore_Handle_t    hKeystore,
+    const ScaleConfig_t*    config)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+
+    while (numLive < config->capacity)
+    {
+        err = storeNewKey(hKeystore, config->keySize);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    err = storeNewKey(hKeystore, config->keySize);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INSUFFICIENT_SPACE, err);
+    ASSERT_EQ_SZ(config->capacity, numLive);
+}
+
+static void
+testScaleFillDrain(
+    const ScaleConfig_t* config)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_Keystore_Handle_t hKeystore;
+    char name[16];
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_46 ************************************/
+    hKeystore = openKeystore(config->capacity);
+
+    fillUp(hKeystore, config);
+    checkLiveKeys(hKeystore, config->keySize);
+
+    snprintf(name, sizeof(name), "s%u", (unsigned) nextId);
+    len = sizeof(loadedData);
+    err = OS_Keystore_loadKey(hKeystore, name, loadedData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    while (numLive > 0)
+    {
+        err = deleteRandomKey(hKeystore);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    // The first key is gone like all others
+    len = sizeof(loadedData);
+    err = OS_Keystore_loadKey(hKeystore, "s0", loadedData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    closeKeystore(hKeystore);
+}
+
+static void
+testScaleChurn(
+    const ScaleConfig_t* config)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_Keystore_Handle_t hKeystore;
+    size_t fillLevel = config->capacity * 3 / 4;
+
+    /********************************** TestKeyStore_testCase_47 ************************************/
+    hKeystore = openKeystore(config->capacity);
+
+    while (numLive < fillLevel)
+    {
+        err = storeNewKey(hKeystore, config->keySize);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    for (size_t i = 0; i < config->capacity; i++)
+    {
+        err = deleteRandomKey(hKeystore);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        err = storeNewKey(hKeystore, config->keySize);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    ASSERT_EQ_SZ(fillLevel, numLive);
+    checkLiveKeys(hKeystore, config->keySize);
+
+    // No slot got lost to the churn
+    fillUp(hKeystore, config);
+    checkLiveKeys(hKeystore, config->keySize);
+
+    closeKeystore(hKeystore);
+}
+
+// Returns the median cost of storing a key in the last round of filling up
+static KeyStoreBenchmark_Cycles_t
+benchmarkScale(
+    const ScaleConfig_t* config)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_Keystore_Handle_t hKeystore;
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+    KeyStoreBenchmark_Cycles_t median;
+    KeyStoreBenchmark_Cycles_t firstMedian = 0;
+    KeyStoreBenchmark_Cycles_t lastMedian  = 0;
+    KeyStoreBenchmark_Cycles_t storeFull;
+    size_t roundSize = config->capacity / NUM_ROUNDS;
+    size_t churnSize = CHURN_ROUND_OPS(config->capacity);
+    char name[16];
+    char op[64];
+    size_t len;
+
+    hKeystore = openKeystore(config->capacity);
+
+    // Filling up
+    for (size_t r = 0; r < NUM_ROUNDS; r++)
+    {
+        for (size_t i = 0; i < roundSize; i++)
+        {
+            start = KeyStoreBenchmark_getCycles();
+            err = storeNewKey(hKeystore, config->keySize);
+            samples[i] = KeyStoreBenchmark_getCycles() - start;
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        }
+        cycles = sumAndMedian(roundSize, &median);
+        snprintf(op, sizeof(op), "scaleStore_%zu_r%zu", config->capacity, r);
+        KeyStoreBenchmark_report(op, "RamFV", config->keySize, roundSize,
+                                 cycles);
+        firstMedian = (0 == r) ? median : firstMedian;
+        lastMedian  = median;
+    }
+    Debug_LOG_INFO("Storing into %zu keys with capacity %zu costs %llu "
+                   "cycles per key (median), %llu into an empty keystore",
+                   numLive, config->capacity,
+                   (unsigned long long) lastMedian,
+                   (unsigned long long) firstMedian);
+    // The last round fills the keystore from 7/8 on, the first one from 0,
+    // so an operation whose cost is linear in the number of keys gets 15
+    // times more expensive on average; only a part of that growth is allowed
+    firstMedian = firstMedian ? firstMedian : 1;
+    storeFull   = lastMedian;
+    if (roundSize >= MIN_ROUND_OPS)
+    {
+        ASSERT_TRUE(100 * lastMedian <= 100 * firstMedian
+                    + KeyStore_Config_SCALE_MAX_GROWTH_PERCENT
+                    * (2 * NUM_ROUNDS - 2) * firstMedian);
+    }
+
+    while (numLive < config->capacity)
+    {
+        err = storeNewKey(hKeystore, config->keySize);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    // Lookups in the full keystore
+    start = KeyStoreBenchmark_getCycles();
+    for (size_t i = 0; i < numLive; i++)
+    {
+        snprintf(name, sizeof(name), "s%u", (unsigned) live[i]);
+        len = sizeof(loadedData);
+        err = OS_Keystore_loadKey(hKeystore, name, loadedData, &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    snprintf(op, sizeof(op), "scaleLoadFull_%zu", config->capacity);
+    KeyStoreBenchmark_report(op, "RamFV", config->keySize, numLive, cycles);
+
+    // Draining in random order
+    for (size_t r = 0; r < NUM_ROUNDS; r++)
+    {
+        start = KeyStoreBenchmark_getCycles();
+        for (size_t i = 0; i < roundSize; i++)
+        {
+            err = deleteRandomKey(hKeystore);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        }
+        cycles = KeyStoreBenchmark_getCycles() - start;
+        snprintf(op, sizeof(op), "scaleDelete_%zu_r%zu", config->capacity,
+                 r);
+        KeyStoreBenchmark_report(op, "RamFV", config->keySize, roundSize,
+                                 cycles);
+    }
+
+    // Replacing keys at a constant fill level, which scatters the free slots
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    numLive = 0;
+    while (numLive < config->capacity * 3 / 4)
+    {
+        err = storeNewKey(hKeystore, config->keySize);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    for (size_t r = 0; r < NUM_ROUNDS; r++)
+    {
+        for (size_t i = 0; i < churnSize; i++)
+        {
+            start = KeyStoreBenchmark_getCycles();
+            err = deleteRandomKey(hKeystore);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+            err = storeNewKey(hKeystore, config->keySize);
+            samples[i] = KeyStoreBenchmark_getCycles() - start;
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        }
+        cycles = sumAndMedian(churnSize, &median);
+        snprintf(op, sizeof(op), "scaleChurn_%zu_r%zu", config->capacity, r);
+        KeyStoreBenchmark_report(op, "RamFV", config->keySize,
+                                 2 * churnSize, cycles);
+        firstMedian = (0 == r) ? median : firstMedian;
+        lastMedian  = median;
+    }
+    if (churnSize >= MIN_ROUND_OPS)
+    {
+        ASSERT_TRUE(lastMedian <= KeyStore_Config_SCALE_MAX_CHURN_GROWTH
+                    * (firstMedian ? firstMedian : 1));
+    }
+
+    closeKeystore(hKeystore);
+
+    return storeFull;
+}
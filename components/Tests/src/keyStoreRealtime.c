@@ -0,0 +1,363 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreRealtime.h"
+#include "lib_debug/Debug.h"
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define SLOT_MASK       (KeyStore_Config_RT_NUM_KEYS - 1)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+    KeyStoreRealtime_Slot_t*    match;  ///< slot of the name, also if deleted
+    KeyStoreRealtime_Slot_t*    free;   ///< first free slot of the window
+} Probe_t;
+
+/* Private functions ---------------------------------------------------------*/
+// Computes the FNV-1a hash of a name and checks its length on the way
+static bool
+hashName(
+    const char* name,
+    uint32_t*   hash)
+{
+    uint32_t h = 2166136261u;
+    size_t len;
+
+    if (NULL == name)
+    {
+        return false;
+    }
+
+    for (len = 0; (len <= KeyStore_Config_MAX_NAME_LEN) && (name[len] != '\0');
+         len++)
+    {
+        h = (h ^ (uint8_t) name[len]) * 16777619u;
+    }
+    *hash = h;
+
+    return (len > 0) && (len <= KeyStore_Config_MAX_NAME_LEN);
+}
+
+static void
+probe(
+    KeyStoreRealtime_t* self,
+    const char*         name,
+    uint32_t            hash,
+    Probe_t*            p)
+{
+    KeyStoreRealtime_Slot_t* slot;
+    size_t pos = hash & SLOT_MASK;
+
+    p->match = NULL;
+    p->free  = NULL;
+
+    // Always the whole window, so the cost does not depend on the contents;
+    // a name is never in more than one slot of it
+    for (size_t i = 0; i < KeyStore_Config_RT_MAX_PROBES; i++)
+    {
+        slot = &self->slots[(pos + i) & SLOT_MASK];
+        if (KeyStoreRealtime_SLOT_FREE == slot->state)
+        {
+            if (NULL == p->free)
+            {
+                p->free = slot;
+            }
+        }
+        else if ((slot->hash == hash) && !strcmp(slot->name, name))
+        {
+            p->match = slot;
+        }
+    }
+}
+
+static bool
+isLoadable(
+    const KeyStoreRealtime_Slot_t* slot)
+{
+    return (slot != NULL) && (slot->state != KeyStoreRealtime_SLOT_DELETED);
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreRealtime_init(
+    KeyStoreRealtime_t*     self,
+    OS_Keystore_Handle_t    hBackend)
+{
+    if (NULL == self)
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(self, 0, sizeof(*self));
+    self->hBackend = hBackend;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreRealtime_storeKey(
+    KeyStoreRealtime_t*     self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize)
+{
+    KeyStoreRealtime_Slot_t* slot;
+    uint32_t hash;
+    Probe_t p;
+
+    Debug_ASSERT_SELF(self);
+
+    if (!hashName(name, &hash) || (NULL == keyData) || (0 == keySize)
+        || (keySize > KeyStore_Config_RT_MAX_KEY_SIZE))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    probe(self, name, hash, &p);
+    if (isLoadable(p.match))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    // A key stored again before its deletion was flushed takes its old slot
+    if ((slot = p.match) == NULL)
+    {
+        if ((slot = p.free) == NULL)
+        {
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+        slot->hash      = hash;
+        slot->inBackend = false;
+        strcpy(slot->name, name);
+        if (self->hBackend != NULL)
+        {
+            self->numPending++;
+        }
+    }
+
+    memcpy(slot->data, keyData, keySize);
+    slot->size  = keySize;
+    slot->state = (NULL == self->hBackend) ? KeyStoreRealtime_SLOT_CLEAN
+                  : KeyStoreRealtime_SLOT_DIRTY;
+    self->numKeys++;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreRealtime_loadKey(
+    KeyStoreRealtime_t*     self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize)
+{
+    uint32_t hash;
+    Probe_t p;
+
+    Debug_ASSERT_SELF(self);
+
+    if (!hashName(name, &hash) || (NULL == keySize))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    probe(self, name, hash, &p);
+    if (!isLoadable(p.match))
+    {
+        return OS_ERROR_NOT_FOUND;
+    }
+    if (*keySize < p.match->size)
+    {
+        *keySize = p.match->size;
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+    if (NULL == keyData)
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memcpy(keyData, p.match->data, p.match->size);
+    *keySize = p.match->size;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreRealtime_deleteKey(
+    KeyStoreRealtime_t*     self,
+    const char*             name)
+{
+    KeyStoreRealtime_Slot_t* slot;
+    uint32_t hash;
+    Probe_t p;
+
+    Debug_ASSERT_SELF(self);
+
+    if (!hashName(name, &hash))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    probe(self, name, hash, &p);
+    if (!isLoadable(slot = p.match))
+    {
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    memset(slot->data, 0, slot->size);
+    if (slot->inBackend)
+    {
+        if (KeyStoreRealtime_SLOT_CLEAN == slot->state)
+        {
+            self->numPending++;
+        }
+        slot->state = KeyStoreRealtime_SLOT_DELETED;
+    }
+    else
+    {
+        if (KeyStoreRealtime_SLOT_DIRTY == slot->state)
+        {
+            self->numPending--;
+        }
+        slot->state = KeyStoreRealtime_SLOT_FREE;
+    }
+    self->numKeys--;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreRealtime_flush(
+    KeyStoreRealtime_t*     self,
+    size_t                  maxKeys)
+{
+    KeyStoreRealtime_Slot_t* slot;
+    OS_Error_t err;
+    size_t done = 0;
+
+    Debug_ASSERT_SELF(self);
+
+    if (NULL == self->hBackend)
+    {
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    for (size_t i = 0; (i < KeyStore_Config_RT_NUM_KEYS) && (done < maxKeys)
+         && (self->numPending > 0); i++)
+    {
+        slot = &self->slots[self->flushPos];
+
+        if ((KeyStoreRealtime_SLOT_DIRTY == slot->state)
+            || (KeyStoreRealtime_SLOT_DELETED == slot->state))
+        {
+            if (slot->inBackend)
+            {
+                err = OS_Keystore_deleteKey(self->hBackend, slot->name);
+                if ((err != OS_SUCCESS) && (err != OS_ERROR_NOT_FOUND))
+                {
+                    Debug_LOG_ERROR("Deleting '%s' from the backend failed "
+                                    "with %d", slot->name, err);
+                    return err;
+                }
+                slot->inBackend = false;
+            }
+
+            if (KeyStoreRealtime_SLOT_DIRTY == slot->state)
+            {
+                err = OS_Keystore_storeKey(self->hBackend, slot->name,
+                                           slot->data, slot->size);
+                if (err != OS_SUCCESS)
+                {
+                    Debug_LOG_ERROR("Writing '%s' to the backend failed "
+                                    "with %d", slot->name, err);
+                    return err;
+                }
+                slot->inBackend = true;
+                slot->state     = KeyStoreRealtime_SLOT_CLEAN;
+            }
+            else
+            {
+                slot->state = KeyStoreRealtime_SLOT_FREE;
+            }
+
+            self->numPending--;
+            done++;
+        }
+
+        self->flushPos = (self->flushPos + 1) & SLOT_MASK;
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreRealtime_preload(
+    KeyStoreRealtime_t*     self,
+    const char*             name)
+{
+    KeyStoreRealtime_Slot_t* slot;
+    OS_Error_t err;
+    uint32_t hash;
+    size_t size;
+    Probe_t p;
+
+    Debug_ASSERT_SELF(self);
+
+    if (NULL == self->hBackend)
+    {
+        return OS_ERROR_INVALID_STATE;
+    }
+    if (!hashName(name, &hash))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    probe(self, name, hash, &p);
+    if (p.match != NULL)
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+    if ((slot = p.free) == NULL)
+    {
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    size = sizeof(slot->data);
+    if ((err = OS_Keystore_loadKey(self->hBackend, name, slot->data, &size))
+        != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    slot->hash      = hash;
+    slot->size      = size;
+    slot->inBackend = true;
+    slot->state     = KeyStoreRealtime_SLOT_CLEAN;
+    strcpy(slot->name, name);
+    self->numKeys++;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreRealtime_wipeKeystore(
+    KeyStoreRealtime_t*     self)
+{
+    Debug_ASSERT_SELF(self);
+
+    memset(self->slots, 0, sizeof(self->slots));
+    self->numKeys    = 0;
+    self->numPending = 0;
+    self->flushPos   = 0;
+
+    return (NULL == self->hBackend) ? OS_SUCCESS
+           : OS_Keystore_wipeKeystore(self->hBackend);
+}
@@ -0,0 +1,804 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreRealtimeTests.h"
+#include "keyStoreRealtime.h"
+#include "keyStoreAlloc.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Keystore.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define KEY_SIZE            32
+#define KEY_NAME_MAX_LEN    "RealtimeKey-max"
+
+// Keys of the mixed workload; half the slots, so some windows fill up
+#define NUM_MIX_KEYS        (KeyStore_Config_RT_NUM_KEYS / 2)
+// Operations between two flushes of the real-time keystore with a backend
+#define FLUSH_INTERVAL      1024
+// The runs on the KeystoreFile do fewer operations by these factors
+#define FILE_RT_OPS_DIV     64
+#define FILE_OPS_DIV        1000
+// Operations of the allocation test
+#define NUM_ALLOC_OPS       1000
+#define PRNG_SEED           0x2545f491
+
+/* Private types -------------------------------------------------------------*/
+typedef enum
+{
+    OP_STORE,
+    OP_LOAD,
+    OP_DELETE,
+    NUM_OP_TYPES
+} OpType_t;
+
+typedef struct
+{
+    size_t                      count;
+    KeyStoreBenchmark_Cycles_t  total;
+    KeyStoreBenchmark_Cycles_t  max;
+    // Number of operations by the bit length of their cycles
+    size_t                      hist[65];
+} Latency_t;
+
+// Keystore a workload runs on, either a handle or a real-time keystore
+typedef struct
+{
+    const char*             backend;
+    OS_Keystore_Handle_t    hKeystore;
+    KeyStoreRealtime_t*     rt;
+} Target_t;
+
+/* Private variables ---------------------------------------------------------*/
+static KeyStoreRealtime_t rt;
+static uint32_t prngState;
+
+static char mixNames[NUM_MIX_KEYS][16];
+static bool present[NUM_MIX_KEYS];
+static Latency_t latencies[NUM_OP_TYPES];
+static Latency_t flushLatency;
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testSemantics(
+    void);
+static void
+testCapacity(
+    void);
+static void
+testBackend(
+    OS_Keystore_Handle_t hBackend);
+#if defined(KeyStoreAlloc_Config_ENABLED)
+static void
+testNoAllocation(
+    OS_Keystore_Handle_t hBackend);
+#endif
+static void
+runMix(
+    const Target_t* target,
+    size_t          numKeys,
+    size_t          numOps);
+static void
+getKeyData(
+    size_t   i,
+    uint8_t* data);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreRealtimeTests(
+    OS_Keystore_Handle_t hBackend)
+{
+    TEST_START();
+
+    testSemantics();
+    testCapacity();
+    if (hBackend != NULL)
+    {
+        testBackend(hBackend);
+    }
+#if defined(KeyStoreAlloc_Config_ENABLED)
+    testNoAllocation(NULL);
+    if (hBackend != NULL)
+    {
+        testNoAllocation(hBackend);
+    }
+#else
+    Debug_LOG_INFO("Allocations are not counted, skipping the allocation "
+                   "test");
+#endif
+
+    TEST_FINISH();
+}
+
+void keyStoreRealtimeBenchmark(
+    OS_Keystore_Handle_t hRamFV,
+    size_t               ramFVCapacity,
+    OS_Keystore_Handle_t hFile)
+{
+    TEST_START();
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    Target_t target;
+    size_t numKeys;
+
+    // In memory only
+    err = KeyStoreRealtime_init(&rt, NULL);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    target = (Target_t) { .backend = "Realtime", .rt = &rt };
+    runMix(&target, NUM_MIX_KEYS, KeyStore_Config_RT_NUM_OPS);
+
+    if (hRamFV != NULL)
+    {
+        err = OS_Keystore_wipeKeystore(hRamFV);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        numKeys = (ramFVCapacity < NUM_MIX_KEYS) ? ramFVCapacity
+                  : NUM_MIX_KEYS;
+        target = (Target_t) { .backend = "RamFV", .hKeystore = hRamFV };
+        runMix(&target, numKeys, KeyStore_Config_RT_NUM_OPS);
+        err = OS_Keystore_wipeKeystore(hRamFV);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    if (hFile != NULL)
+    {
+        // In front of the KeystoreFile, flushed between the operations
+        err = KeyStoreRealtime_init(&rt, hFile);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        err = KeyStoreRealtime_wipeKeystore(&rt);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        target = (Target_t) { .backend = "RealtimeFile", .rt = &rt };
+        runMix(&target, NUM_MIX_KEYS,
+               KeyStore_Config_RT_NUM_OPS / FILE_RT_OPS_DIV);
+
+        err = KeyStoreRealtime_wipeKeystore(&rt);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        target = (Target_t) { .backend = "File", .hKeystore = hFile };
+        runMix(&target, NUM_MIX_KEYS,
+               KeyStore_Config_RT_NUM_OPS / FILE_OPS_DIV);
+        err = OS_Keystore_wipeKeystore(hFile);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static uint32_t
+nextRandom(void)
+{
+    // xorshift32, seeded per run so every run does the same
+    prngState ^= prngState << 13;
+    prngState ^= prngState >> 17;
+    prngState ^= prngState << 5;
+
+    return prngState;
+}
+
+static void
+getKeyData(
+    size_t   i,
+    uint8_t* data)
+{
+    for (size_t j = 0; j < KEY_SIZE; j++)
+    {
+        data[j] = (uint8_t)(i * 31 + j);
+    }
+}
+
+static void
+checkKey(
+    size_t          i,
+    const uint8_t*  data,
+    size_t          len)
+{
+    uint8_t expected[KEY_SIZE];
+
+    getKeyData(i, expected);
+    ASSERT_EQ_SZ(KEY_SIZE, len);
+    ASSERT_EQ_INT(0, memcmp(expected, data, KEY_SIZE));
+}
+
+static void
+record(
+    Latency_t*                  latency,
+    KeyStoreBenchmark_Cycles_t  cycles)
+{
+    size_t bits = 0;
+
+    while ((bits < 64) && ((cycles >> bits) != 0))
+    {
+        bits++;
+    }
+
+    latency->count++;
+    latency->total += cycles;
+    latency->max    = (cycles > latency->max) ? cycles : latency->max;
+    latency->hist[bits]++;
+}
+
+// Returns a bound that 99.99% of the operations stay below
+static unsigned long long
+getP9999(
+    const Latency_t* latency)
+{
+    size_t below = 0;
+    size_t bits;
+
+    for (bits = 0; bits < 64; bits++)
+    {
+        below += latency->hist[bits];
+        if (below * 10000 >= latency->count * 9999)
+        {
+            break;
+        }
+    }
+
+    return (bits < 64) ? (1ull << bits) : latency->max;
+}
+
+static void
+reportLatency(
+    const char*         op,
+    const char*         backend,
+    const Latency_t*    latency)
+{
+    char opMax[32];
+
+    if (0 == latency->count)
+    {
+        return;
+    }
+
+    snprintf(opMax, sizeof(opMax), "%sMax", op);
+    KeyStoreBenchmark_report(op, backend, KEY_SIZE, latency->count,
+                             latency->total);
+    KeyStoreBenchmark_report(opMax, backend, KEY_SIZE, 1, latency->max);
+    Debug_LOG_INFO("%s %s: %zu calls, %llu cycles on average, %llu at most, "
+                   "99.99%% below %llu", backend, op, latency->count,
+                   (unsigned long long)(latency->total / latency->count),
+                   (unsigned long long) latency->max, getP9999(latency));
+}
+
+static OS_Error_t
+doOp(
+    const Target_t* target,
+    OpType_t        op,
+    const char*     name,
+    uint8_t*        data,
+    size_t*         len)
+{
+    if (target->rt != NULL)
+    {
+        switch (op)
+        {
+        case OP_STORE:
+            return KeyStoreRealtime_storeKey(target->rt, name, data, *len);
+        case OP_LOAD:
+            return KeyStoreRealtime_loadKey(target->rt, name, data, len);
+        default:
+            return KeyStoreRealtime_deleteKey(target->rt, name);
+        }
+    }
+
+    switch (op)
+    {
+    case OP_STORE:
+        return OS_Keystore_storeKey(target->hKeystore, name, data, *len);
+    case OP_LOAD:
+        return OS_Keystore_loadKey(target->hKeystore, name, data, len);
+    default:
+        return OS_Keystore_deleteKey(target->hKeystore, name);
+    }
+}
+
+static void
+runMix(
+    const Target_t* target,
+    size_t          numKeys,
+    size_t          numOps)
+{
+    static const char* const opNames[NUM_OP_TYPES] =
+    {
+        "mixStoreKey", "mixLoadKey", "mixDeleteKey"
+    };
+    OS_Error_t err = OS_ERROR_GENERIC;
+    OS_Keystore_Handle_t hBackend = (target->rt != NULL) ?
+                                    target->rt->hBackend : NULL;
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+    uint8_t data[KEY_SIZE];
+#if defined(KeyStoreAlloc_Config_ENABLED)
+    size_t numAllocs = 0;
+    size_t allocs;
+#endif
+    size_t numFull = 0;
+    size_t len;
+    size_t k;
+    OpType_t op;
+
+    memset(present, 0, sizeof(present));
+    memset(latencies, 0, sizeof(latencies));
+    memset(&flushLatency, 0, sizeof(flushLatency));
+    for (k = 0; k < numKeys; k++)
+    {
+        snprintf(mixNames[k], sizeof(mixNames[k]), "mix%03u",
+                 (unsigned)(k % 1000));
+    }
+    prngState = PRNG_SEED;
+
+    for (size_t i = 0; i < numOps; i++)
+    {
+        if ((hBackend != NULL) && (i > 0) && (0 == i % FLUSH_INTERVAL))
+        {
+            start  = KeyStoreBenchmark_getCycles();
+            err    = KeyStoreRealtime_flush(target->rt, SIZE_MAX);
+            cycles = KeyStoreBenchmark_getCycles() - start;
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+            record(&flushLatency, cycles);
+        }
+
+        // Keys are stored if missing, loaded three times as often as deleted
+        // otherwise
+        k  = nextRandom() % numKeys;
+        op = !present[k] ? OP_STORE
+             : (nextRandom() % 4) ? OP_LOAD : OP_DELETE;
+        if (OP_STORE == op)
+        {
+            getKeyData(k, data);
+        }
+        len = (OP_STORE == op) ? KEY_SIZE : sizeof(data);
+
+#if defined(KeyStoreAlloc_Config_ENABLED)
+        allocs = KeyStoreAlloc_getCount();
+#endif
+        start  = KeyStoreBenchmark_getCycles();
+        err    = doOp(target, op, mixNames[k], data, &len);
+        cycles = KeyStoreBenchmark_getCycles() - start;
+#if defined(KeyStoreAlloc_Config_ENABLED)
+        numAllocs += KeyStoreAlloc_getCount() - allocs;
+#endif
+
+        record(&latencies[op], cycles);
+        if ((OP_STORE == op) && (OS_ERROR_INSUFFICIENT_SPACE == err))
+        {
+            // The window of the key is full, it is tried again later
+            numFull++;
+            continue;
+        }
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        if (OP_LOAD == op)
+        {
+            checkKey(k, data, len);
+        }
+        present[k] = (op != OP_DELETE);
+    }
+
+    for (size_t o = 0; o < NUM_OP_TYPES; o++)
+    {
+        reportLatency(opNames[o], target->backend, &latencies[o]);
+    }
+    reportLatency("mixFlush", target->backend, &flushLatency);
+    Debug_LOG_INFO("%s: %zu keys, %zu stores rejected for a full window",
+                   target->backend, numKeys, numFull);
+#if defined(KeyStoreAlloc_Config_ENABLED)
+    Debug_LOG_INFO("%s: %zu allocations", target->backend, numAllocs);
+#endif
+
+    if (target->rt != NULL)
+    {
+#if defined(KeyStoreAlloc_Config_ENABLED)
+        ASSERT_EQ_SZ(0, numAllocs);
+#endif
+#if defined(KeyStore_Config_RT_MAX_CYCLES)
+        for (size_t o = 0; o < NUM_OP_TYPES; o++)
+        {
+            ASSERT_TRUE(latencies[o].max <= KeyStore_Config_RT_MAX_CYCLES);
+        }
+#endif
+    }
+
+    // After a final flush, the backend holds exactly the keys left
+    if (hBackend != NULL)
+    {
+        err = KeyStoreRealtime_flush(target->rt, SIZE_MAX);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        ASSERT_EQ_SZ(0, target->rt->numPending);
+        for (k = 0; k < numKeys; k++)
+        {
+            len = sizeof(data);
+            err = OS_Keystore_loadKey(hBackend, mixNames[k], data, &len);
+            if (present[k])
+            {
+                ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+                checkKey(k, data, len);
+            }
+            else
+            {
+                ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+            }
+        }
+    }
+}
+
+static void
+testSemantics(
+    void)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    uint8_t keyData[KeyStore_Config_RT_MAX_KEY_SIZE + 1];
+    uint8_t loaded[KeyStore_Config_RT_MAX_KEY_SIZE + 1];
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_48 ************************************/
+    err = KeyStoreRealtime_init(NULL, NULL);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreRealtime_init(&rt, NULL);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    getKeyData(0, keyData);
+    err = KeyStoreRealtime_storeKey(&rt, "rtKey", keyData, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Test storage of a key which is already stored
+    err = KeyStoreRealtime_storeKey(&rt, "rtKey", keyData, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    len = sizeof(loaded);
+    err = KeyStoreRealtime_loadKey(&rt, "rtKey", loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    checkKey(0, loaded, len);
+
+    // Same behavior as OS_Keystore_loadKey() for small buffers
+    len = KEY_SIZE - 1;
+    err = KeyStoreRealtime_loadKey(&rt, "rtKey", loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_BUFFER_TOO_SMALL, err);
+    ASSERT_EQ_SZ(KEY_SIZE, len);
+
+    len = sizeof(loaded);
+    err = KeyStoreRealtime_loadKey(&rt, "rtKey", NULL, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreRealtime_loadKey(&rt, "rtKey", loaded, NULL);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    len = sizeof(loaded);
+    err = KeyStoreRealtime_loadKey(&rt, "rtMissing", loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    // Names of maximum length work, longer and empty ones do not
+    err = KeyStoreRealtime_storeKey(&rt, KEY_NAME_MAX_LEN, keyData, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreRealtime_storeKey(&rt, KEY_NAME_MAX_LEN "X", keyData,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreRealtime_storeKey(&rt, "", keyData, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreRealtime_storeKey(&rt, NULL, keyData, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    len = sizeof(loaded);
+    err = KeyStoreRealtime_loadKey(&rt, KEY_NAME_MAX_LEN "X", loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreRealtime_deleteKey(&rt, KEY_NAME_MAX_LEN "X");
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    // Keys of maximum size work, larger and empty ones do not
+    memset(keyData, 0xa5, sizeof(keyData));
+    err = KeyStoreRealtime_storeKey(&rt, "rtMaxSize", keyData,
+                                    KeyStore_Config_RT_MAX_KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    len = sizeof(loaded);
+    err = KeyStoreRealtime_loadKey(&rt, "rtMaxSize", loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(KeyStore_Config_RT_MAX_KEY_SIZE, len);
+    ASSERT_EQ_INT(0, memcmp(keyData, loaded, len));
+    err = KeyStoreRealtime_storeKey(&rt, "rtTooLarge", keyData,
+                                    KeyStore_Config_RT_MAX_KEY_SIZE + 1);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreRealtime_storeKey(&rt, "rtEmpty", keyData, 0);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreRealtime_storeKey(&rt, "rtEmpty", NULL, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    ASSERT_EQ_SZ(3, rt.numKeys);
+
+    err = KeyStoreRealtime_deleteKey(&rt, "rtKey");
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreRealtime_deleteKey(&rt, "rtKey");
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    len = sizeof(loaded);
+    err = KeyStoreRealtime_loadKey(&rt, "rtKey", loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    // Without a backend, nothing is pending and there is nothing to flush
+    ASSERT_EQ_SZ(0, rt.numPending);
+    err = KeyStoreRealtime_flush(&rt, SIZE_MAX);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_STATE, err);
+    err = KeyStoreRealtime_preload(&rt, "rtKey");
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_STATE, err);
+
+    err = KeyStoreRealtime_wipeKeystore(&rt);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(0, rt.numKeys);
+    len = sizeof(loaded);
+    err = KeyStoreRealtime_loadKey(&rt, "rtMaxSize", loaded, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+}
+
+static void
+testCapacity(
+    void)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    bool stored[2 * KeyStore_Config_RT_NUM_KEYS];
+    uint8_t keyData[KEY_SIZE];
+    char name[16];
+    size_t numStored = 0;
+    size_t rejected = SIZE_MAX;
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_49 ************************************/
+    err = KeyStoreRealtime_init(&rt, NULL);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // More keys than there are slots, so windows fill up
+    for (size_t i = 0; i < 2 * KeyStore_Config_RT_NUM_KEYS; i++)
+    {
+        snprintf(name, sizeof(name), "cap%03u",
+                 (unsigned)(i % 1000));
+        getKeyData(i, keyData);
+        err = KeyStoreRealtime_storeKey(&rt, name, keyData, KEY_SIZE);
+        if (OS_ERROR_INSUFFICIENT_SPACE == err)
+        {
+            rejected = (SIZE_MAX == rejected) ? i : rejected;
+        }
+        else
+        {
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        }
+        stored[i] = (OS_SUCCESS == err);
+        numStored += stored[i] ? 1 : 0;
+    }
+    ASSERT_TRUE(numStored >= KeyStore_Config_RT_MAX_PROBES);
+    ASSERT_TRUE(numStored <= KeyStore_Config_RT_NUM_KEYS);
+    ASSERT_EQ_SZ(numStored, rt.numKeys);
+    ASSERT_TRUE(rejected != SIZE_MAX);
+    Debug_LOG_INFO("Realtime: %zu keys fit into %d slots with windows of %d",
+                   numStored, KeyStore_Config_RT_NUM_KEYS,
+                   KeyStore_Config_RT_MAX_PROBES);
+
+    for (size_t i = 0; i < 2 * KeyStore_Config_RT_NUM_KEYS; i++)
+    {
+        snprintf(name, sizeof(name), "cap%03u",
+                 (unsigned)(i % 1000));
+        len = sizeof(keyData);
+        err = KeyStoreRealtime_loadKey(&rt, name, keyData, &len);
+        if (stored[i])
+        {
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+            checkKey(i, keyData, len);
+        }
+        else
+        {
+            ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+        }
+    }
+
+    // Deleting keys frees up the window of the rejected key at some point
+    getKeyData(rejected, keyData);
+    err = OS_ERROR_INSUFFICIENT_SPACE;
+    for (size_t i = 0; (i < 2 * KeyStore_Config_RT_NUM_KEYS)
+         && (OS_ERROR_INSUFFICIENT_SPACE == err); i++)
+    {
+        if (stored[i])
+        {
+            snprintf(name, sizeof(name), "cap%03u",
+                     (unsigned)(i % 1000));
+            err = KeyStoreRealtime_deleteKey(&rt, name);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+            snprintf(name, sizeof(name), "cap%03u",
+                     (unsigned)(rejected % 1000));
+            err = KeyStoreRealtime_storeKey(&rt, name, keyData, KEY_SIZE);
+        }
+    }
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreRealtime_loadKey(&rt, name, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    checkKey(rejected, keyData, len);
+
+    err = KeyStoreRealtime_wipeKeystore(&rt);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testBackend(
+    OS_Keystore_Handle_t hBackend)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    uint8_t keyData[KeyStore_Config_RT_MAX_KEY_SIZE + 1];
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_50 ************************************/
+    err = KeyStoreRealtime_init(&rt, hBackend);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreRealtime_wipeKeystore(&rt);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Stored keys reach the backend with the flush only
+    getKeyData(1, keyData);
+    err = KeyStoreRealtime_storeKey(&rt, "rtKey1", keyData, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    getKeyData(2, keyData);
+    err = KeyStoreRealtime_storeKey(&rt, "rtKey2", keyData, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(2, rt.numPending);
+
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hBackend, "rtKey1", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    err = KeyStoreRealtime_flush(&rt, 1);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(1, rt.numPending);
+    err = KeyStoreRealtime_flush(&rt, SIZE_MAX);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(0, rt.numPending);
+
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hBackend, "rtKey1", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    checkKey(1, keyData, len);
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hBackend, "rtKey2", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    checkKey(2, keyData, len);
+
+    // So do deleted keys
+    err = KeyStoreRealtime_deleteKey(&rt, "rtKey1");
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(1, rt.numPending);
+    len = sizeof(keyData);
+    err = KeyStoreRealtime_loadKey(&rt, "rtKey1", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hBackend, "rtKey1", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreRealtime_flush(&rt, SIZE_MAX);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hBackend, "rtKey1", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    // A key deleted and stored again between two flushes is replaced
+    err = KeyStoreRealtime_deleteKey(&rt, "rtKey2");
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    getKeyData(3, keyData);
+    err = KeyStoreRealtime_storeKey(&rt, "rtKey2", keyData, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(1, rt.numPending);
+    err = KeyStoreRealtime_flush(&rt, SIZE_MAX);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hBackend, "rtKey2", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    checkKey(3, keyData, len);
+
+    // A key stored and deleted between two flushes never reaches it
+    err = KeyStoreRealtime_storeKey(&rt, "rtKey4", keyData, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreRealtime_deleteKey(&rt, "rtKey4");
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(0, rt.numPending);
+
+    // Keys of the backend can be loaded once they are preloaded
+    getKeyData(5, keyData);
+    err = OS_Keystore_storeKey(hBackend, "rtKey5", keyData, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    len = sizeof(keyData);
+    err = KeyStoreRealtime_loadKey(&rt, "rtKey5", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    err = KeyStoreRealtime_preload(&rt, "rtKey5");
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(0, rt.numPending);
+    len = sizeof(keyData);
+    err = KeyStoreRealtime_loadKey(&rt, "rtKey5", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    checkKey(5, keyData, len);
+
+    err = KeyStoreRealtime_preload(&rt, "rtKey5");
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreRealtime_preload(&rt, "rtMissing");
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    memset(keyData, 0xa5, sizeof(keyData));
+    err = OS_Keystore_storeKey(hBackend, "rtTooLarge", keyData,
+                               sizeof(keyData));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreRealtime_preload(&rt, "rtTooLarge");
+    ASSERT_EQ_OS_ERR(OS_ERROR_BUFFER_TOO_SMALL, err);
+
+    // Deleting a preloaded key deletes it in the backend
+    err = KeyStoreRealtime_deleteKey(&rt, "rtKey5");
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreRealtime_flush(&rt, SIZE_MAX);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hBackend, "rtKey5", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    err = KeyStoreRealtime_wipeKeystore(&rt);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hBackend, "rtKey2", keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+}
+
+#if defined(KeyStoreAlloc_Config_ENABLED)
+static void
+testNoAllocation(
+    OS_Keystore_Handle_t hBackend)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    void* volatile mem;
+    uint8_t keyData[KEY_SIZE];
+    const char* name;
+    size_t allocs;
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_51 ************************************/
+    // Make sure the allocator is really counted
+    allocs = KeyStoreAlloc_getCount();
+    mem    = malloc(KEY_SIZE);
+    ASSERT_TRUE(mem != NULL);
+    ASSERT_EQ_SZ(allocs + 1, KeyStoreAlloc_getCount());
+    free(mem);
+
+    err = KeyStoreRealtime_init(&rt, hBackend);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreRealtime_wipeKeystore(&rt);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (size_t k = 0; k < NUM_MIX_KEYS; k++)
+    {
+        snprintf(mixNames[k], sizeof(mixNames[k]), "alloc%03u",
+                 (unsigned)(k % 1000));
+    }
+
+    allocs = KeyStoreAlloc_getCount();
+    for (size_t i = 0; i < NUM_ALLOC_OPS; i++)
+    {
+        name = mixNames[i % NUM_MIX_KEYS];
+        getKeyData(i, keyData);
+        err = KeyStoreRealtime_storeKey(&rt, name, keyData, KEY_SIZE);
+        ASSERT_TRUE((OS_SUCCESS == err)
+                    || (OS_ERROR_INSUFFICIENT_SPACE == err));
+        if (OS_SUCCESS == err)
+        {
+            len = sizeof(keyData);
+            err = KeyStoreRealtime_loadKey(&rt, name, keyData, &len);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+            checkKey(i, keyData, len);
+            err = KeyStoreRealtime_deleteKey(&rt, name);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        }
+    }
+    ASSERT_EQ_SZ(allocs, KeyStoreAlloc_getCount());
+
+    err = KeyStoreRealtime_wipeKeystore(&rt);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+#endif /* KeyStoreAlloc_Config_ENABLED */
@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreSeededEntropy.h"
+#include <string.h>
+
+/* Private functions prototypes ----------------------------------------------*/
+static size_t
+seededRead(
+    const size_t len);
+
+/* Private variables ---------------------------------------------------------*/
+static uint64_t state;
+
+static uint8_t portBuf[OS_DATAPORT_DEFAULT_SIZE];
+static void* portPtr = portBuf;
+
+static const if_OS_Entropy_t seededIf =
+{
+    .read     = seededRead,
+    .dataport = OS_DATAPORT_ASSIGN(portPtr),
+};
+
+/* Private functions ---------------------------------------------------------*/
+// SplitMix64, see Steele et al., "Fast splittable pseudorandom number
+// generators"
+static uint64_t
+nextWord(
+    void)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+static size_t
+seededRead(
+    const size_t len)
+{
+    size_t n = (len < sizeof(portBuf)) ? len : sizeof(portBuf);
+    uint64_t w;
+
+    for (size_t i = 0; i < n; i += sizeof(w))
+    {
+        w = nextWord();
+        memcpy(&portBuf[i], &w, (n - i < sizeof(w)) ? n - i : sizeof(w));
+    }
+
+    return n;
+}
+
+/* Public functions -----------------------------------------------------------*/
+void
+KeyStoreSeededEntropy_init(
+    uint64_t    seed)
+{
+    state = seed;
+}
+
+const if_OS_Entropy_t*
+KeyStoreSeededEntropy_getInterface(
+    void)
+{
+    return &seededIf;
+}
@@ -0,0 +1,322 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreSnapshot.h"
+#include "lib_debug/Debug.h"
+#include <string.h>
+
+/* Private functions ---------------------------------------------------------*/
+static KeyStoreSnapshot_Change_t*
+findChange(
+    KeyStoreSnapshot_t* self,
+    const char*         name)
+{
+    for (size_t i = 0; i < KeyStoreSnapshot_MAX_CHANGED_KEYS; i++)
+    {
+        if (self->changes[i].valid && !strcmp(self->changes[i].name, name))
+        {
+            return &self->changes[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Returns a free entry to record the change of a key in, names that do not
+// fit are rejected by the keystore anyway
+static KeyStoreSnapshot_Change_t*
+findFree(
+    KeyStoreSnapshot_t* self,
+    const char*         name)
+{
+    if (strlen(name) >= sizeof(self->changes[0].name))
+    {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < KeyStoreSnapshot_MAX_CHANGED_KEYS; i++)
+    {
+        if (!self->changes[i].valid)
+        {
+            return &self->changes[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Tells if a key exists without loading its data; returns OS_SUCCESS if it
+// does, otherwise the error of the keystore, e.g. for an invalid name
+static OS_Error_t
+probeKey(
+    OS_Keystore_Handle_t    hKeystore,
+    const char*             name)
+{
+    uint8_t data;
+    size_t len = 0;
+    OS_Error_t err;
+
+    err = OS_Keystore_loadKey(hKeystore, name, &data, &len);
+
+    return (OS_ERROR_BUFFER_TOO_SMALL == err) ? OS_SUCCESS : err;
+}
+
+static void
+recordChange(
+    KeyStoreSnapshot_Change_t*  change,
+    const char*                 name,
+    bool                        existed)
+{
+    strcpy(change->name, name);
+    change->existed = existed;
+    change->valid   = true;
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreSnapshot_init(
+    KeyStoreSnapshot_t*     self,
+    OS_Keystore_Handle_t    hLive,
+    OS_Keystore_Handle_t    hShadow)
+{
+    if ((NULL == self) || (NULL == hLive) || (NULL == hShadow)
+        || (hLive == hShadow))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(self, 0, sizeof(*self));
+    self->hLive   = hLive;
+    self->hShadow = hShadow;
+
+    return OS_Keystore_wipeKeystore(hShadow);
+}
+
+OS_Error_t
+KeyStoreSnapshot_take(
+    KeyStoreSnapshot_t*     self)
+{
+    Debug_ASSERT_SELF(self);
+
+    if (self->taken)
+    {
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    // The change log and the shadow keystore are empty at this point, they
+    // are cleared when a snapshot is released
+    self->taken = true;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreSnapshot_loadSnapshotKey(
+    KeyStoreSnapshot_t*     self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize)
+{
+    KeyStoreSnapshot_Change_t* change;
+
+    Debug_ASSERT_SELF(self);
+
+    if (!self->taken)
+    {
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    if ((name != NULL) && ((change = findChange(self, name)) != NULL))
+    {
+        return change->existed ?
+               OS_Keystore_loadKey(self->hShadow, name, keyData, keySize) :
+               OS_ERROR_NOT_FOUND;
+    }
+
+    return OS_Keystore_loadKey(self->hLive, name, keyData, keySize);
+}
+
+OS_Error_t
+KeyStoreSnapshot_rollback(
+    KeyStoreSnapshot_t*     self)
+{
+    KeyStoreSnapshot_Change_t* change;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if (!self->taken)
+    {
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    for (size_t i = 0; i < KeyStoreSnapshot_MAX_CHANGED_KEYS; i++)
+    {
+        change = &self->changes[i];
+        if (!change->valid)
+        {
+            continue;
+        }
+
+        err = OS_Keystore_deleteKey(self->hLive, change->name);
+        if ((err != OS_SUCCESS) && (err != OS_ERROR_NOT_FOUND))
+        {
+            Debug_LOG_ERROR("Removing '%s' from the live keystore failed "
+                            "with %d", change->name, err);
+            return err;
+        }
+
+        if (change->existed)
+        {
+            err = OS_Keystore_moveKey(self->hShadow, change->name,
+                                      self->hLive);
+            if (err != OS_SUCCESS)
+            {
+                Debug_LOG_ERROR("Restoring '%s' failed with %d",
+                                change->name, err);
+                return err;
+            }
+        }
+
+        // Done with this key, a retry must not remove it again
+        change->valid = false;
+    }
+
+    return KeyStoreSnapshot_release(self);
+}
+
+OS_Error_t
+KeyStoreSnapshot_release(
+    KeyStoreSnapshot_t*     self)
+{
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if (!self->taken)
+    {
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    if ((err = OS_Keystore_wipeKeystore(self->hShadow)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    memset(self->changes, 0, sizeof(self->changes));
+    self->numPreserved = 0;
+    self->taken        = false;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreSnapshot_storeKey(
+    KeyStoreSnapshot_t*     self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize)
+{
+    KeyStoreSnapshot_Change_t* change = NULL;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    // Keys are never overwritten, so storing only succeeds for keys that do
+    // not exist; if the snapshot knows nothing of the key yet, it did not
+    // exist when the snapshot was taken
+    if (self->taken && (name != NULL) && (NULL == findChange(self, name))
+        && (NULL == (change = findFree(self, name))))
+    {
+        // Invalid calls and existing keys fail as they would without the
+        // snapshot, only a new key needs an entry of the change log
+        if ((NULL == keyData) || (0 == keySize))
+        {
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+        err = probeKey(self->hLive, name);
+        if (OS_SUCCESS == err)
+        {
+            return OS_ERROR_INVALID_PARAMETER;
+        }
+        return (OS_ERROR_NOT_FOUND == err) ? OS_ERROR_INSUFFICIENT_SPACE : err;
+    }
+
+    err = OS_Keystore_storeKey(self->hLive, name, keyData, keySize);
+    if ((OS_SUCCESS == err) && (change != NULL))
+    {
+        recordChange(change, name, false);
+    }
+
+    return err;
+}
+
+OS_Error_t
+KeyStoreSnapshot_loadKey(
+    KeyStoreSnapshot_t*     self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize)
+{
+    Debug_ASSERT_SELF(self);
+
+    return OS_Keystore_loadKey(self->hLive, name, keyData, keySize);
+}
+
+OS_Error_t
+KeyStoreSnapshot_deleteKey(
+    KeyStoreSnapshot_t*     self,
+    const char*             name)
+{
+    KeyStoreSnapshot_Change_t* change;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if (self->taken && (name != NULL) && (NULL == findChange(self, name)))
+    {
+        if (NULL == (change = findFree(self, name)))
+        {
+            // Missing keys and invalid names fail as they would without the
+            // snapshot, only an existing key needs an entry of the change log
+            err = probeKey(self->hLive, name);
+            return (OS_SUCCESS == err) ? OS_ERROR_INSUFFICIENT_SPACE : err;
+        }
+
+        // Save the data the snapshot needs before it is gone
+        err = OS_Keystore_copyKey(self->hLive, name, self->hShadow);
+        if (OS_SUCCESS == err)
+        {
+            recordChange(change, name, true);
+            self->numPreserved++;
+        }
+        else if (err != OS_ERROR_NOT_FOUND)
+        {
+            Debug_LOG_ERROR("Saving '%s' for the snapshot failed with %d",
+                            name, err);
+            return err;
+        }
+    }
+
+    return OS_Keystore_deleteKey(self->hLive, name);
+}
+
+OS_Error_t
+KeyStoreSnapshot_wipeKeystore(
+    KeyStoreSnapshot_t*     self)
+{
+    Debug_ASSERT_SELF(self);
+
+    if (self->taken)
+    {
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    return OS_Keystore_wipeKeystore(self->hLive);
+}
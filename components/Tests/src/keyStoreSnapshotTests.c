@@ -0,0 +1,415 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreSnapshotTests.h"
+#include "keyStoreSnapshot.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Keystore.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define KEY_NAME_A          "SnapA"
+#define KEY_NAME_B          "SnapB"
+#define KEY_NAME_C          "SnapC"
+#define KEY_NAME_D          "SnapD"
+#define KEY_NAME_E          "SnapE"
+#define KEY_NAME_TOO_LARGE  "SnapNameTooLarge"  // strlen is 16
+#define KEY_DATA_A          "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
+#define KEY_DATA_B          "BBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBB"
+#define KEY_DATA_C          "CCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCC"
+#define KEY_DATA_D          "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
+#define KEY_DATA_X          "XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX"
+#define KEY_DATA_Y          "YYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYY"
+#define KEY_SIZE            (sizeof(KEY_DATA_A) - 1)
+
+// Keys in the keystore for the benchmark, both keystores must fit them all
+#define NUM_KEYS            8
+// Keys rotated while the snapshot exists
+#define NUM_CHANGED         2
+
+/* Private variables ---------------------------------------------------------*/
+static KeyStoreSnapshot_t snapshot;
+static char keyData[KEY_SIZE];
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testSnapshotIsolation(
+    OS_Keystore_Handle_t hShadow);
+static void
+testSnapshotRollback(
+    OS_Keystore_Handle_t hShadow);
+static void
+testSnapshotLogFull(
+    void);
+static void
+checkKey(
+    OS_Error_t  err,
+    size_t      len,
+    const char* expected);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreSnapshotTests(
+    OS_Keystore_Handle_t hLive,
+    OS_Keystore_Handle_t hShadow)
+{
+    TEST_START();
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+
+    err = KeyStoreSnapshot_init(&snapshot, hLive, hShadow);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreSnapshot_wipeKeystore(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    testSnapshotIsolation(hShadow);
+    testSnapshotRollback(hShadow);
+    testSnapshotLogFull();
+
+    err = KeyStoreSnapshot_wipeKeystore(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+void keyStoreSnapshotBenchmark(
+    OS_Keystore_Handle_t hLive,
+    OS_Keystore_Handle_t hShadow,
+    const char*          backend)
+{
+    TEST_START("backend", backend);
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+    char name[16];
+
+    err = KeyStoreSnapshot_init(&snapshot, hLive, hShadow);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreSnapshot_wipeKeystore(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        snprintf(name, sizeof(name), "Snap%d", i);
+        err = KeyStoreSnapshot_storeKey(&snapshot, name, KEY_DATA_A, KEY_SIZE);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    // Backup as it is done without snapshots
+    start = KeyStoreBenchmark_getCycles();
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        snprintf(name, sizeof(name), "Snap%d", i);
+        err = OS_Keystore_copyKey(hLive, name, hShadow);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("backupFullCopy", backend, KEY_SIZE, NUM_KEYS,
+                             cycles);
+
+    err = OS_Keystore_wipeKeystore(hShadow);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    start = KeyStoreBenchmark_getCycles();
+    err = KeyStoreSnapshot_take(&snapshot);
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    KeyStoreBenchmark_report("snapshotTake", backend, KEY_SIZE, 1, cycles);
+
+    // The first rotation of a key copies its old data, later ones do not
+    for (int round = 0; round < 2; round++)
+    {
+        start = KeyStoreBenchmark_getCycles();
+        for (int i = 0; i < NUM_CHANGED; i++)
+        {
+            snprintf(name, sizeof(name), "Snap%d", i);
+            err = KeyStoreSnapshot_deleteKey(&snapshot, name);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+            err = KeyStoreSnapshot_storeKey(&snapshot, name,
+                                            round ? KEY_DATA_Y : KEY_DATA_X,
+                                            KEY_SIZE);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        }
+        cycles = KeyStoreBenchmark_getCycles() - start;
+        KeyStoreBenchmark_report(round ? "rotateKeySnapshotted" :
+                                 "rotateKeyCopyOnWrite",
+                                 backend, KEY_SIZE, NUM_CHANGED, cycles);
+    }
+
+    // Storage overhead, compared to the full copy above
+    ASSERT_EQ_SZ(NUM_CHANGED, snapshot.numPreserved);
+    Debug_LOG_INFO("Snapshot of %d keys holds %zu keys (%zu bytes) in the "
+                   "shadow keystore, state takes %zu bytes",
+                   NUM_KEYS, snapshot.numPreserved,
+                   snapshot.numPreserved * KEY_SIZE, sizeof(snapshot));
+
+    start = KeyStoreBenchmark_getCycles();
+    err = KeyStoreSnapshot_rollback(&snapshot);
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    KeyStoreBenchmark_report("snapshotRollback", backend, KEY_SIZE,
+                             NUM_CHANGED, cycles);
+
+    err = KeyStoreSnapshot_wipeKeystore(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void
+checkKey(
+    OS_Error_t  err,
+    size_t      len,
+    const char* expected)
+{
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(KEY_SIZE, len);
+    ASSERT_EQ_INT(0, memcmp(expected, keyData, KEY_SIZE));
+}
+
+static void
+testSnapshotIsolation(
+    OS_Keystore_Handle_t hShadow)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_38 ************************************/
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_A, KEY_DATA_A,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_B, KEY_DATA_B,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_C, KEY_DATA_C,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // No snapshot to read from yet
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadSnapshotKey(&snapshot, KEY_NAME_A, keyData,
+                                           &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_STATE, err);
+
+    err = KeyStoreSnapshot_take(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(0, snapshot.numPreserved);
+
+    // Only one snapshot at a time
+    err = KeyStoreSnapshot_take(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_STATE, err);
+
+    // Replace A, delete B, add D; C stays untouched
+    err = KeyStoreSnapshot_deleteKey(&snapshot, KEY_NAME_A);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_A, KEY_DATA_X,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_deleteKey(&snapshot, KEY_NAME_B);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_D, KEY_DATA_D,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // The snapshot shows the keys as they were
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadSnapshotKey(&snapshot, KEY_NAME_A, keyData,
+                                           &len);
+    checkKey(err, len, KEY_DATA_A);
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadSnapshotKey(&snapshot, KEY_NAME_B, keyData,
+                                           &len);
+    checkKey(err, len, KEY_DATA_B);
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadSnapshotKey(&snapshot, KEY_NAME_C, keyData,
+                                           &len);
+    checkKey(err, len, KEY_DATA_C);
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadSnapshotKey(&snapshot, KEY_NAME_D, keyData,
+                                           &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    // The live keystore shows the changes
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadKey(&snapshot, KEY_NAME_A, keyData, &len);
+    checkKey(err, len, KEY_DATA_X);
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadKey(&snapshot, KEY_NAME_B, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadKey(&snapshot, KEY_NAME_D, keyData, &len);
+    checkKey(err, len, KEY_DATA_D);
+
+    // Only the old data of A and B was copied, C is shared with the live
+    // keystore
+    ASSERT_EQ_SZ(2, snapshot.numPreserved);
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hShadow, KEY_NAME_C, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    // Changing A again does not copy it again
+    err = KeyStoreSnapshot_deleteKey(&snapshot, KEY_NAME_A);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_A, KEY_DATA_X,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(2, snapshot.numPreserved);
+
+    // Deleting a key that does not exist changes nothing
+    err = KeyStoreSnapshot_deleteKey(&snapshot, KEY_NAME_E);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    ASSERT_EQ_SZ(2, snapshot.numPreserved);
+
+    // The keys to save on a wipe are not known
+    err = KeyStoreSnapshot_wipeKeystore(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_STATE, err);
+
+    err = KeyStoreSnapshot_release(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testSnapshotRollback(
+    OS_Keystore_Handle_t hShadow)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_39 ************************************/
+    // The live keystore holds A (X), C and D
+    err = KeyStoreSnapshot_take(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreSnapshot_deleteKey(&snapshot, KEY_NAME_C);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_E, KEY_DATA_A,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_deleteKey(&snapshot, KEY_NAME_D);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_D, KEY_DATA_Y,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreSnapshot_rollback(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // The live keystore is back to the state of the snapshot
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadKey(&snapshot, KEY_NAME_A, keyData, &len);
+    checkKey(err, len, KEY_DATA_X);
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadKey(&snapshot, KEY_NAME_C, keyData, &len);
+    checkKey(err, len, KEY_DATA_C);
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadKey(&snapshot, KEY_NAME_D, keyData, &len);
+    checkKey(err, len, KEY_DATA_D);
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadKey(&snapshot, KEY_NAME_E, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    // The rollback released the snapshot
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadSnapshotKey(&snapshot, KEY_NAME_A, keyData,
+                                           &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_STATE, err);
+    err = KeyStoreSnapshot_rollback(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_STATE, err);
+
+    // Releasing a snapshot keeps the changes and frees the shadow keystore
+    err = KeyStoreSnapshot_take(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_deleteKey(&snapshot, KEY_NAME_A);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_release(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadKey(&snapshot, KEY_NAME_A, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hShadow, KEY_NAME_A, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+}
+
+static void
+testSnapshotLogFull(
+    void)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    char name[sizeof("Log") + 3];
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_53 ************************************/
+    // The live keystore holds C and D
+    err = KeyStoreSnapshot_take(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Replacing D takes the first entry of the change log
+    err = KeyStoreSnapshot_deleteKey(&snapshot, KEY_NAME_D);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_D, KEY_DATA_X,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(1, snapshot.numPreserved);
+
+    // Keys created and deleted again fill the change log, not the keystore
+    for (unsigned int i = 1; i < KeyStoreSnapshot_MAX_CHANGED_KEYS; i++)
+    {
+        snprintf(name, sizeof(name), "Log%03u", i % 1000);
+        err = KeyStoreSnapshot_storeKey(&snapshot, name, KEY_DATA_A,
+                                        KEY_SIZE);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        err = KeyStoreSnapshot_deleteKey(&snapshot, name);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+
+    // Calls that fail anyway report the error of the keystore
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_C, KEY_DATA_X,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_TOO_LARGE, KEY_DATA_X,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_B, NULL, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreSnapshot_deleteKey(&snapshot, KEY_NAME_B);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    err = KeyStoreSnapshot_deleteKey(&snapshot, KEY_NAME_TOO_LARGE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    // Only storing a new key and deleting an existing one are out of space,
+    // the existing key is left alone
+    err = KeyStoreSnapshot_storeKey(&snapshot, KEY_NAME_B, KEY_DATA_B,
+                                    KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INSUFFICIENT_SPACE, err);
+    err = KeyStoreSnapshot_deleteKey(&snapshot, KEY_NAME_C);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INSUFFICIENT_SPACE, err);
+    len = sizeof(keyData);
+    err = KeyStoreSnapshot_loadKey(&snapshot, KEY_NAME_C, keyData, &len);
+    checkKey(err, len, KEY_DATA_C);
+
+    // Keys in the change log can still be changed
+    err = KeyStoreSnapshot_storeKey(&snapshot, name, KEY_DATA_B, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = KeyStoreSnapshot_deleteKey(&snapshot, name);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Releasing the snapshot empties the shadow keystore
+    err = KeyStoreSnapshot_release(&snapshot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(0, snapshot.numPreserved);
+}
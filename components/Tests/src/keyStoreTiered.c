@@ -0,0 +1,269 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreTiered.h"
+#include "lib_debug/Debug.h"
+#include <string.h>
+
+/* Private functions ---------------------------------------------------------*/
+static KeyStoreTiered_HotEntry_t*
+findHot(
+    KeyStoreTiered_t*   self,
+    const char*         name)
+{
+    for (size_t i = 0; i < self->hotCapacity; i++)
+    {
+        if (self->hot[i].valid && !strcmp(self->hot[i].name, name))
+        {
+            return &self->hot[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void
+touchHot(
+    KeyStoreTiered_t*           self,
+    KeyStoreTiered_HotEntry_t*  entry)
+{
+    entry->lastUse = ++self->clock;
+    entry->uses++;
+}
+
+// Returns a free entry (if allowed), or the entry to be evicted according to
+// the policy
+static KeyStoreTiered_HotEntry_t*
+getVictim(
+    KeyStoreTiered_t*   self,
+    bool                allowFree)
+{
+    KeyStoreTiered_HotEntry_t* victim = NULL;
+    KeyStoreTiered_HotEntry_t* e;
+
+    for (size_t i = 0; i < self->hotCapacity; i++)
+    {
+        e = &self->hot[i];
+        if (!e->valid)
+        {
+            if (allowFree)
+            {
+                return e;
+            }
+            continue;
+        }
+        if ((NULL == victim)
+            || ((KeyStoreTiered_EVICT_LFU == self->policy)
+                && (e->uses < victim->uses))
+            || (((KeyStoreTiered_EVICT_LRU == self->policy)
+                 || (e->uses == victim->uses))
+                && (e->lastUse < victim->lastUse)))
+        {
+            victim = e;
+        }
+    }
+
+    return victim;
+}
+
+static OS_Error_t
+evictHot(
+    KeyStoreTiered_t*           self,
+    KeyStoreTiered_HotEntry_t*  entry)
+{
+    OS_Error_t err;
+
+    err = OS_Keystore_deleteKey(self->hHot, entry->name);
+    if ((err != OS_SUCCESS) && (err != OS_ERROR_NOT_FOUND))
+    {
+        Debug_LOG_ERROR("Evicting '%s' from the hot tier failed with %d",
+                        entry->name, err);
+        return err;
+    }
+
+    entry->valid = false;
+    self->numEvictions++;
+
+    return OS_SUCCESS;
+}
+
+// Copies a key into the hot tier, evicting other keys if needed; failing to
+// do so is not an error, as the key is in the cold tier anyway
+static void
+promote(
+    KeyStoreTiered_t*   self,
+    const char*         name,
+    void const*         keyData,
+    size_t              keySize)
+{
+    KeyStoreTiered_HotEntry_t* entry;
+    OS_Error_t err;
+
+    if (strlen(name) >= sizeof(entry->name))
+    {
+        return;
+    }
+
+    entry = getVictim(self, true);
+    if ((NULL == entry)
+        || (entry->valid && (evictHot(self, entry) != OS_SUCCESS)))
+    {
+        return;
+    }
+
+    err = OS_Keystore_storeKey(self->hHot, name, keyData, keySize);
+    if (OS_ERROR_INSUFFICIENT_SPACE == err)
+    {
+        // The hot tier holds less than hotCapacity keys; make room once more
+        // and use the entry that was freed up by it
+        KeyStoreTiered_HotEntry_t* victim = getVictim(self, false);
+        if ((NULL == victim) || (evictHot(self, victim) != OS_SUCCESS))
+        {
+            return;
+        }
+        entry = victim;
+        err = OS_Keystore_storeKey(self->hHot, name, keyData, keySize);
+    }
+    if (err != OS_SUCCESS)
+    {
+        Debug_LOG_WARNING("Promoting '%s' into the hot tier failed with %d",
+                          name, err);
+        return;
+    }
+
+    strcpy(entry->name, name);
+    entry->valid = true;
+    entry->uses = 0;
+    touchHot(self, entry);
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreTiered_init(
+    KeyStoreTiered_t*       self,
+    OS_Keystore_Handle_t    hHot,
+    size_t                  hotCapacity,
+    OS_Keystore_Handle_t    hCold,
+    KeyStoreTiered_Policy_t policy)
+{
+    if ((NULL == self) || (NULL == hHot) || (NULL == hCold)
+        || (0 == hotCapacity) || (hotCapacity > KeyStoreTiered_MAX_HOT_KEYS)
+        || ((policy != KeyStoreTiered_EVICT_LRU)
+            && (policy != KeyStoreTiered_EVICT_LFU)))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(self, 0, sizeof(*self));
+    self->hHot        = hHot;
+    self->hCold       = hCold;
+    self->hotCapacity = hotCapacity;
+    self->policy      = policy;
+
+    return OS_Keystore_wipeKeystore(hHot);
+}
+
+OS_Error_t
+KeyStoreTiered_storeKey(
+    KeyStoreTiered_t*       self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize)
+{
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((err = OS_Keystore_storeKey(self->hCold, name, keyData, keySize))
+        != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    promote(self, name, keyData, keySize);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreTiered_loadKey(
+    KeyStoreTiered_t*       self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize)
+{
+    KeyStoreTiered_HotEntry_t* entry;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((name != NULL) && ((entry = findHot(self, name)) != NULL))
+    {
+        err = OS_Keystore_loadKey(self->hHot, name, keyData, keySize);
+        if (err != OS_ERROR_NOT_FOUND)
+        {
+            if (OS_SUCCESS == err)
+            {
+                self->numHits++;
+                touchHot(self, entry);
+            }
+            return err;
+        }
+        // Lost from the hot tier somehow, so forget about it
+        entry->valid = false;
+    }
+
+    self->numMisses++;
+
+    if ((err = OS_Keystore_loadKey(self->hCold, name, keyData, keySize))
+        == OS_SUCCESS)
+    {
+        promote(self, name, keyData, *keySize);
+    }
+
+    return err;
+}
+
+OS_Error_t
+KeyStoreTiered_deleteKey(
+    KeyStoreTiered_t*       self,
+    const char*             name)
+{
+    KeyStoreTiered_HotEntry_t* entry;
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    // Drop the copy first, so the hot tier never holds a deleted key
+    if ((name != NULL) && ((entry = findHot(self, name)) != NULL)
+        && ((err = evictHot(self, entry)) != OS_SUCCESS))
+    {
+        return err;
+    }
+
+    return OS_Keystore_deleteKey(self->hCold, name);
+}
+
+OS_Error_t
+KeyStoreTiered_wipeKeystore(
+    KeyStoreTiered_t*       self)
+{
+    OS_Error_t err;
+
+    Debug_ASSERT_SELF(self);
+
+    if ((err = OS_Keystore_wipeKeystore(self->hHot)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    memset(self->hot, 0, sizeof(self->hot));
+
+    return OS_Keystore_wipeKeystore(self->hCold);
+}
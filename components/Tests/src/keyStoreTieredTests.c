@@ -0,0 +1,397 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreTieredTests.h"
+#include "keyStoreTiered.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Keystore.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define KEY_DATA            "TieredKey-00000"
+#define KEY_SIZE            (sizeof(KEY_DATA) - 1)
+
+// Number of keys in the cold tier, more than the hot tier can hold
+#define NUM_KEYS            24
+// Number of loads per access pattern
+#define NUM_ACCESSES        200
+// Weights of the Zipfian distribution (s = 1) are ZIPF_SCALE / rank
+#define ZIPF_SCALE          100000
+#define PRNG_SEED           0x2545f491
+
+/* Private variables ---------------------------------------------------------*/
+static KeyStoreTiered_t tiered;
+static uint32_t zipfCdf[NUM_KEYS];
+static uint32_t prngState;
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testSaturation(
+    OS_Keystore_Handle_t hHot,
+    int                  hotCapacity,
+    OS_Keystore_Handle_t hCold);
+static void
+testZipfHitRate(
+    OS_Keystore_Handle_t hHot,
+    int                  hotCapacity,
+    OS_Keystore_Handle_t hCold);
+static void
+storeKeys(
+    OS_Keystore_Handle_t hCold);
+static void
+checkKey(
+    int         i,
+    const char* keyData,
+    size_t      len);
+static void
+getKeyName(
+    int   i,
+    char* name);
+static void
+getKeyData(
+    int   i,
+    char* data);
+static int
+nextZipf(
+    void);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreTieredTests(
+    OS_Keystore_Handle_t hHot,
+    int                  hotCapacity,
+    OS_Keystore_Handle_t hCold)
+{
+    TEST_START();
+
+    testSaturation(hHot, hotCapacity, hCold);
+    testZipfHitRate(hHot, hotCapacity, hCold);
+
+    TEST_FINISH();
+}
+
+void keyStoreTieredBenchmark(
+    OS_Keystore_Handle_t hHot,
+    int                  hotCapacity,
+    OS_Keystore_Handle_t hCold)
+{
+    TEST_START();
+
+    static const struct
+    {
+        KeyStoreTiered_Policy_t policy;
+        const char*             backend;
+    } runs[] =
+    {
+        { KeyStoreTiered_EVICT_LRU, "TieredLRU" },
+        { KeyStoreTiered_EVICT_LFU, "TieredLFU" },
+    };
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+    KeyStoreBenchmark_Cycles_t cyclesHit;
+    KeyStoreBenchmark_Cycles_t cyclesMiss;
+    char name[16];
+    char keyData[KEY_SIZE];
+    size_t len;
+    size_t hits;
+
+    storeKeys(hCold);
+
+    // Reference: every load goes to the cold tier
+    prngState = PRNG_SEED;
+    start = KeyStoreBenchmark_getCycles();
+    for (int i = 0; i < NUM_ACCESSES; i++)
+    {
+        getKeyName(nextZipf(), name);
+        len = sizeof(keyData);
+        err = OS_Keystore_loadKey(hCold, name, keyData, &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("loadKeyZipf", "File", KEY_SIZE, NUM_ACCESSES,
+                             cycles);
+
+    for (size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); r++)
+    {
+        err = KeyStoreTiered_init(&tiered, hHot, hotCapacity, hCold,
+                                  runs[r].policy);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+        cyclesHit  = 0;
+        cyclesMiss = 0;
+        prngState  = PRNG_SEED;
+        for (int i = 0; i < NUM_ACCESSES; i++)
+        {
+            getKeyName(nextZipf(), name);
+            len   = sizeof(keyData);
+            hits  = tiered.numHits;
+            start = KeyStoreBenchmark_getCycles();
+            err   = KeyStoreTiered_loadKey(&tiered, name, keyData, &len);
+            cycles = KeyStoreBenchmark_getCycles() - start;
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+            if (tiered.numHits != hits)
+            {
+                cyclesHit += cycles;
+            }
+            else
+            {
+                cyclesMiss += cycles;
+            }
+        }
+
+        KeyStoreBenchmark_report("loadKeyZipf", runs[r].backend, KEY_SIZE,
+                                 NUM_ACCESSES, cyclesHit + cyclesMiss);
+        KeyStoreBenchmark_report("loadKeyZipfHit", runs[r].backend, KEY_SIZE,
+                                 tiered.numHits, cyclesHit);
+        KeyStoreBenchmark_report("loadKeyZipfMiss", runs[r].backend, KEY_SIZE,
+                                 tiered.numMisses, cyclesMiss);
+        Debug_LOG_INFO("%s: hit rate %zu%% with %d of %d keys in the hot tier, "
+                       "%zu evictions", runs[r].backend,
+                       (tiered.numHits * 100) / NUM_ACCESSES, hotCapacity,
+                       NUM_KEYS, tiered.numEvictions);
+    }
+
+    err = KeyStoreTiered_wipeKeystore(&tiered);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void
+testSaturation(
+    OS_Keystore_Handle_t hHot,
+    int                  hotCapacity,
+    OS_Keystore_Handle_t hCold)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    char name[16];
+    char keyData[KEY_SIZE];
+    size_t len;
+
+    /********************************** TestKeyStore_testCase_28 ************************************/
+    err = OS_Keystore_wipeKeystore(hCold);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Configure more room than the hot tier has, so it runs into
+    // OS_ERROR_INSUFFICIENT_SPACE before the tracked capacity is reached
+    err = KeyStoreTiered_init(&tiered, hHot, hotCapacity + 2, hCold,
+                              KeyStoreTiered_EVICT_LRU);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        getKeyName(i, name);
+        getKeyData(i, keyData);
+        err = KeyStoreTiered_storeKey(&tiered, name, keyData, KEY_SIZE);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    ASSERT_TRUE(tiered.numEvictions >= (size_t)(NUM_KEYS - hotCapacity));
+
+    // Written through to the cold tier
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        getKeyName(i, name);
+        len = sizeof(keyData);
+        err = OS_Keystore_loadKey(hCold, name, keyData, &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        checkKey(i, keyData, len);
+    }
+
+    // The most recent keys are hot, the older ones come from the cold tier
+    for (int i = NUM_KEYS - 1; i >= 0; i--)
+    {
+        getKeyName(i, name);
+        len = sizeof(keyData);
+        err = KeyStoreTiered_loadKey(&tiered, name, keyData, &len);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        checkKey(i, keyData, len);
+    }
+    ASSERT_TRUE(tiered.numHits > 0);
+    ASSERT_TRUE(tiered.numMisses > 0);
+
+    // Same behavior as OS_Keystore_loadKey() for small buffers
+    getKeyName(0, name);
+    len = KEY_SIZE - 1;
+    err = KeyStoreTiered_loadKey(&tiered, name, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_BUFFER_TOO_SMALL, err);
+    ASSERT_EQ_SZ(KEY_SIZE, len);
+
+    // Deleted keys are gone from both tiers
+    err = KeyStoreTiered_deleteKey(&tiered, name);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreTiered_loadKey(&tiered, name, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    len = sizeof(keyData);
+    err = OS_Keystore_loadKey(hHot, name, keyData, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    err = KeyStoreTiered_deleteKey(&tiered, name);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    // Parameter checks
+    err = KeyStoreTiered_init(&tiered, hHot, 0, hCold,
+                              KeyStoreTiered_EVICT_LRU);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreTiered_init(&tiered, hHot, KeyStoreTiered_MAX_HOT_KEYS + 1,
+                              hCold, KeyStoreTiered_EVICT_LRU);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreTiered_init(&tiered, hHot, hotCapacity, NULL,
+                              KeyStoreTiered_EVICT_LRU);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = OS_Keystore_wipeKeystore(hHot);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    err = OS_Keystore_wipeKeystore(hCold);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testZipfHitRate(
+    OS_Keystore_Handle_t hHot,
+    int                  hotCapacity,
+    OS_Keystore_Handle_t hCold)
+{
+    static const KeyStoreTiered_Policy_t policies[] =
+    {
+        KeyStoreTiered_EVICT_LRU,
+        KeyStoreTiered_EVICT_LFU
+    };
+    OS_Error_t err = OS_ERROR_GENERIC;
+    char name[16];
+    char keyData[KEY_SIZE];
+    size_t len;
+    int i;
+
+    /********************************** TestKeyStore_testCase_29 ************************************/
+    storeKeys(hCold);
+
+    for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++)
+    {
+        err = KeyStoreTiered_init(&tiered, hHot, hotCapacity, hCold,
+                                  policies[p]);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+        prngState = PRNG_SEED;
+        for (int n = 0; n < NUM_ACCESSES; n++)
+        {
+            i = nextZipf();
+            getKeyName(i, name);
+            len = sizeof(keyData);
+            err = KeyStoreTiered_loadKey(&tiered, name, keyData, &len);
+            ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+            checkKey(i, keyData, len);
+        }
+
+        ASSERT_EQ_SZ(NUM_ACCESSES, tiered.numHits + tiered.numMisses);
+
+        // Uniform accesses would hit with a rate of hotCapacity / NUM_KEYS
+        Debug_LOG_INFO("Hit rate with policy %d: %zu%% (uniform: %d%%)",
+                       policies[p], (tiered.numHits * 100) / NUM_ACCESSES,
+                       (hotCapacity * 100) / NUM_KEYS);
+        ASSERT_TRUE(tiered.numHits * NUM_KEYS
+                    > (size_t)(NUM_ACCESSES * hotCapacity));
+    }
+
+    err = KeyStoreTiered_wipeKeystore(&tiered);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+storeKeys(
+    OS_Keystore_Handle_t hCold)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    char name[16];
+    char keyData[KEY_SIZE];
+
+    err = OS_Keystore_wipeKeystore(hCold);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        getKeyName(i, name);
+        getKeyData(i, keyData);
+        err = OS_Keystore_storeKey(hCold, name, keyData, KEY_SIZE);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+}
+
+static void
+checkKey(
+    int         i,
+    const char* keyData,
+    size_t      len)
+{
+    char expected[KEY_SIZE];
+
+    getKeyData(i, expected);
+    ASSERT_EQ_SZ(KEY_SIZE, len);
+    ASSERT_EQ_INT(0, memcmp(expected, keyData, KEY_SIZE));
+}
+
+static void
+getKeyName(
+    int   i,
+    char* name)
+{
+    snprintf(name, 16, "Tier%02d", i);
+}
+
+static void
+getKeyData(
+    int   i,
+    char* data)
+{
+    char buf[sizeof(KEY_DATA)];
+
+    snprintf(buf, sizeof(buf), "TieredKey-%05d", i);
+    memcpy(data, buf, KEY_SIZE);
+}
+
+// Draws the index of a key, where key i is accessed with a probability
+// proportional to 1 / (i + 1); uses a fixed xorshift32 sequence so every run
+// sees the same accesses
+static int
+nextZipf(
+    void)
+{
+    uint32_t r;
+
+    if (0 == zipfCdf[0])
+    {
+        for (int i = 0; i < NUM_KEYS; i++)
+        {
+            zipfCdf[i] = (i ? zipfCdf[i - 1] : 0) + ZIPF_SCALE / (i + 1);
+        }
+    }
+
+    prngState ^= prngState << 13;
+    prngState ^= prngState >> 17;
+    prngState ^= prngState << 5;
+
+    r = prngState % zipfCdf[NUM_KEYS - 1];
+    for (int i = 0; i < NUM_KEYS; i++)
+    {
+        if (r < zipfCdf[i])
+        {
+            return i;
+        }
+    }
+
+    return NUM_KEYS - 1;
+}
@@ -0,0 +1,240 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreTrace.h"
+#include "keyStoreBenchmark.h"
+#include "lib_debug/Debug.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(KeyStoreTrace_Config_ENABLED)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+    KeyStoreTrace_Phase_t       phase;
+    const char*                 name;
+    KeyStoreBenchmark_Cycles_t  start;
+    KeyStoreBenchmark_Cycles_t  children;   ///< cycles of nested phases
+} Frame_t;
+
+typedef struct
+{
+    const char*                 name;
+    size_t                      count;
+    KeyStoreBenchmark_Cycles_t  cycles[KeyStoreTrace_NUM_PHASES];
+} Op_t;
+
+typedef struct
+{
+    KeyStoreTrace_Phase_t       phase;
+    const char*                 name;
+    KeyStoreBenchmark_Cycles_t  start;
+    KeyStoreBenchmark_Cycles_t  duration;
+} Event_t;
+
+/* Private variables ---------------------------------------------------------*/
+static Frame_t stack[KeyStoreTrace_MAX_DEPTH];
+static size_t depth;
+// Phases entered while the stack was full, they are not traced
+static size_t numSkipped;
+
+static Op_t ops[KeyStoreTrace_MAX_OPS];
+static size_t numOps;
+// Operation of the outermost phase, NULL if there is no room for it
+static Op_t* op;
+
+#if defined(KeyStoreTrace_Config_CHROME_FORMAT)
+static const char* const phaseNames[KeyStoreTrace_NUM_PHASES] =
+{
+    "keystore", "filesystem", "storage", "crypto"
+};
+
+static Event_t events[KeyStoreTrace_Config_MAX_EVENTS];
+static size_t numEvents;
+static size_t numDropped;
+#endif
+
+/* Private functions ---------------------------------------------------------*/
+static Op_t*
+findOp(
+    const char* name)
+{
+    for (size_t i = 0; i < numOps; i++)
+    {
+        // The names are literals, so comparing the pointers is enough
+        if (ops[i].name == name)
+        {
+            return &ops[i];
+        }
+    }
+
+    if (numOps >= KeyStoreTrace_MAX_OPS)
+    {
+        return NULL;
+    }
+
+    memset(&ops[numOps], 0, sizeof(ops[numOps]));
+    ops[numOps].name = name;
+
+    return &ops[numOps++];
+}
+
+#if !defined(KeyStoreTrace_Config_CHROME_FORMAT)
+static void
+dumpBreakdown(
+    const char* scenario)
+{
+    for (size_t i = 0; i < numOps; i++)
+    {
+        unsigned long long perCall[KeyStoreTrace_NUM_PHASES];
+        unsigned long long total = 0;
+
+        for (size_t p = 0; p < KeyStoreTrace_NUM_PHASES; p++)
+        {
+            perCall[p] = ops[i].count ? ops[i].cycles[p] / ops[i].count : 0;
+            total     += perCall[p];
+        }
+
+        Debug_LOG_INFO("TRACE %s: %s calls=%zu cycles/call=%llu "
+                       "keystore=%llu filesystem=%llu storage=%llu "
+                       "crypto=%llu",
+                       scenario, ops[i].name, ops[i].count, total,
+                       perCall[KeyStoreTrace_PHASE_KEYSTORE],
+                       perCall[KeyStoreTrace_PHASE_FILESYSTEM],
+                       perCall[KeyStoreTrace_PHASE_STORAGE],
+                       perCall[KeyStoreTrace_PHASE_CRYPTO]);
+    }
+}
+#else
+static void
+dumpEvents(
+    const char* scenario)
+{
+    // Printed without the log prefix, so every event is exactly one line
+    for (size_t i = 0; i < numEvents; i++)
+    {
+        printf(KeyStoreTrace_JSON_TAG
+               " {\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+               "\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":1,"
+               "\"args\":{\"scenario\":\"%s\"}}\n",
+               events[i].name, phaseNames[events[i].phase],
+               (unsigned long long) events[i].start,
+               (unsigned long long) events[i].duration, scenario);
+    }
+
+    if (numDropped > 0)
+    {
+        Debug_LOG_WARNING("TRACE %s: %zu events dropped, raise "
+                          "KeyStoreTrace_Config_MAX_EVENTS",
+                          scenario, numDropped);
+    }
+
+    numEvents  = 0;
+    numDropped = 0;
+}
+#endif
+
+/* Public functions -----------------------------------------------------------*/
+void
+KeyStoreTrace_begin(
+    KeyStoreTrace_Phase_t   phase,
+    const char*             name)
+{
+    if (depth >= KeyStoreTrace_MAX_DEPTH)
+    {
+        numSkipped++;
+        return;
+    }
+
+    if (0 == depth)
+    {
+        op = findOp(name);
+    }
+
+    stack[depth].phase    = phase;
+    stack[depth].name     = name;
+    stack[depth].children = 0;
+    // Taken last, so the bookkeeping above is not part of the phase
+    stack[depth].start    = KeyStoreBenchmark_getCycles();
+    depth++;
+}
+
+void
+KeyStoreTrace_end(
+    void)
+{
+    KeyStoreBenchmark_Cycles_t now = KeyStoreBenchmark_getCycles();
+    KeyStoreBenchmark_Cycles_t duration;
+    Frame_t* frame;
+
+    if (numSkipped > 0)
+    {
+        numSkipped--;
+        return;
+    }
+
+    Debug_ASSERT(depth > 0);
+    frame    = &stack[--depth];
+    duration = now - frame->start;
+
+    if (op != NULL)
+    {
+        op->cycles[frame->phase] += duration - frame->children;
+        if (0 == depth)
+        {
+            op->count++;
+        }
+    }
+    if (depth > 0)
+    {
+        stack[depth - 1].children += duration;
+    }
+
+#if defined(KeyStoreTrace_Config_CHROME_FORMAT)
+    if (numEvents < KeyStoreTrace_Config_MAX_EVENTS)
+    {
+        events[numEvents].phase    = frame->phase;
+        events[numEvents].name     = frame->name;
+        events[numEvents].start    = frame->start;
+        events[numEvents].duration = duration;
+        numEvents++;
+    }
+    else
+    {
+        numDropped++;
+    }
+#endif
+}
+
+void
+KeyStoreTrace_dump(
+    const char*             scenario)
+{
+#if defined(KeyStoreTrace_Config_CHROME_FORMAT)
+    dumpEvents(scenario);
+#else
+    dumpBreakdown(scenario);
+#endif
+
+    numOps = 0;
+    op     = NULL;
+}
+
+#else /* KeyStoreTrace_Config_ENABLED */
+
+void
+KeyStoreTrace_dump(
+    const char*             scenario)
+{
+    (void) scenario;
+}
+
+#endif /* KeyStoreTrace_Config_ENABLED */
@@ -0,0 +1,403 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/*
+ * Wrappers setting the trace points of keyStoreTrace.h. The linker binds
+ * every call of a wrapped function to __wrap_<function> and the original to
+ * __real_<function>, see keyStoreTrace.cmake for the list of functions.
+ * Only linked with the build option KEYSTORE_TRACE.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreTrace.h"
+#include "OS_Crypto.h"
+#include "OS_FileSystem.h"
+#include "OS_Keystore.h"
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Original functions, bound by the linker -----------------------------------*/
+OS_Error_t
+__real_OS_Keystore_storeKey(
+    OS_Keystore_Handle_t    hKeystore,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize);
+OS_Error_t
+__real_OS_Keystore_loadKey(
+    OS_Keystore_Handle_t    hKeystore,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize);
+OS_Error_t
+__real_OS_Keystore_deleteKey(
+    OS_Keystore_Handle_t    hKeystore,
+    const char*             name);
+OS_Error_t
+__real_OS_Keystore_copyKey(
+    OS_Keystore_Handle_t    hSrcKeystore,
+    const char*             name,
+    OS_Keystore_Handle_t    hDstKeystore);
+OS_Error_t
+__real_OS_Keystore_moveKey(
+    OS_Keystore_Handle_t    hSrcKeystore,
+    const char*             name,
+    OS_Keystore_Handle_t    hDstKeystore);
+OS_Error_t
+__real_OS_Keystore_wipeKeystore(
+    OS_Keystore_Handle_t    hKeystore);
+OS_Error_t
+__real_OS_FileSystemFile_open(
+    OS_FileSystem_Handle_t      hFs,
+    OS_FileSystemFile_Handle_t* hFile,
+    const char*                 name,
+    OS_FileSystem_OpenMode_t    mode,
+    OS_FileSystem_OpenFlags_t   flags);
+OS_Error_t
+__real_OS_FileSystemFile_close(
+    OS_FileSystem_Handle_t     hFs,
+    OS_FileSystemFile_Handle_t hFile);
+OS_Error_t
+__real_OS_FileSystemFile_read(
+    OS_FileSystem_Handle_t     hFs,
+    OS_FileSystemFile_Handle_t hFile,
+    off_t                      offset,
+    size_t                     len,
+    void*                      buffer);
+OS_Error_t
+__real_OS_FileSystemFile_write(
+    OS_FileSystem_Handle_t     hFs,
+    OS_FileSystemFile_Handle_t hFile,
+    off_t                      offset,
+    size_t                     len,
+    const void*                buffer);
+OS_Error_t
+__real_OS_FileSystemFile_delete(
+    OS_FileSystem_Handle_t  hFs,
+    const char*             name);
+OS_Error_t
+__real_OS_FileSystemFile_getSize(
+    OS_FileSystem_Handle_t  hFs,
+    const char*             name,
+    off_t*                  sz);
+OS_Error_t
+__real_OS_CryptoDigest_init(
+    OS_CryptoDigest_Handle_t*   self,
+    const OS_Crypto_Handle_t    hCrypto,
+    const OS_CryptoDigest_Alg_t algorithm);
+OS_Error_t
+__real_OS_CryptoDigest_process(
+    OS_CryptoDigest_Handle_t self,
+    const void*              data,
+    const size_t             dataSize);
+OS_Error_t
+__real_OS_CryptoDigest_finalize(
+    OS_CryptoDigest_Handle_t self,
+    void*                    digest,
+    size_t*                  digestSize);
+OS_Error_t
+__real_storage_rpc_write(
+    off_t                   offset,
+    size_t                  size,
+    size_t*                 written);
+OS_Error_t
+__real_storage_rpc_read(
+    off_t                   offset,
+    size_t                  size,
+    size_t*                 read);
+OS_Error_t
+__real_storage_rpc_erase(
+    off_t                   offset,
+    off_t                   size,
+    off_t*                  erased);
+
+/* Public functions -----------------------------------------------------------*/
+// Keystore
+OS_Error_t
+__wrap_OS_Keystore_storeKey(
+    OS_Keystore_Handle_t    hKeystore,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_KEYSTORE, "OS_Keystore_storeKey");
+    err = __real_OS_Keystore_storeKey(hKeystore, name, keyData, keySize);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_Keystore_loadKey(
+    OS_Keystore_Handle_t    hKeystore,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_KEYSTORE, "OS_Keystore_loadKey");
+    err = __real_OS_Keystore_loadKey(hKeystore, name, keyData, keySize);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_Keystore_deleteKey(
+    OS_Keystore_Handle_t    hKeystore,
+    const char*             name)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_KEYSTORE, "OS_Keystore_deleteKey");
+    err = __real_OS_Keystore_deleteKey(hKeystore, name);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_Keystore_copyKey(
+    OS_Keystore_Handle_t    hSrcKeystore,
+    const char*             name,
+    OS_Keystore_Handle_t    hDstKeystore)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_KEYSTORE, "OS_Keystore_copyKey");
+    err = __real_OS_Keystore_copyKey(hSrcKeystore, name, hDstKeystore);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_Keystore_moveKey(
+    OS_Keystore_Handle_t    hSrcKeystore,
+    const char*             name,
+    OS_Keystore_Handle_t    hDstKeystore)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_KEYSTORE, "OS_Keystore_moveKey");
+    err = __real_OS_Keystore_moveKey(hSrcKeystore, name, hDstKeystore);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_Keystore_wipeKeystore(
+    OS_Keystore_Handle_t    hKeystore)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_KEYSTORE,
+                        "OS_Keystore_wipeKeystore");
+    err = __real_OS_Keystore_wipeKeystore(hKeystore);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+// File system
+OS_Error_t
+__wrap_OS_FileSystemFile_open(
+    OS_FileSystem_Handle_t      hFs,
+    OS_FileSystemFile_Handle_t* hFile,
+    const char*                 name,
+    OS_FileSystem_OpenMode_t    mode,
+    OS_FileSystem_OpenFlags_t   flags)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_FILESYSTEM,
+                        "OS_FileSystemFile_open");
+    err = __real_OS_FileSystemFile_open(hFs, hFile, name, mode, flags);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_FileSystemFile_close(
+    OS_FileSystem_Handle_t     hFs,
+    OS_FileSystemFile_Handle_t hFile)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_FILESYSTEM,
+                        "OS_FileSystemFile_close");
+    err = __real_OS_FileSystemFile_close(hFs, hFile);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_FileSystemFile_read(
+    OS_FileSystem_Handle_t     hFs,
+    OS_FileSystemFile_Handle_t hFile,
+    off_t                      offset,
+    size_t                     len,
+    void*                      buffer)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_FILESYSTEM,
+                        "OS_FileSystemFile_read");
+    err = __real_OS_FileSystemFile_read(hFs, hFile, offset, len, buffer);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_FileSystemFile_write(
+    OS_FileSystem_Handle_t     hFs,
+    OS_FileSystemFile_Handle_t hFile,
+    off_t                      offset,
+    size_t                     len,
+    const void*                buffer)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_FILESYSTEM,
+                        "OS_FileSystemFile_write");
+    err = __real_OS_FileSystemFile_write(hFs, hFile, offset, len, buffer);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_FileSystemFile_delete(
+    OS_FileSystem_Handle_t  hFs,
+    const char*             name)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_FILESYSTEM,
+                        "OS_FileSystemFile_delete");
+    err = __real_OS_FileSystemFile_delete(hFs, name);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_FileSystemFile_getSize(
+    OS_FileSystem_Handle_t  hFs,
+    const char*             name,
+    off_t*                  sz)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_FILESYSTEM,
+                        "OS_FileSystemFile_getSize");
+    err = __real_OS_FileSystemFile_getSize(hFs, name, sz);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+// Crypto digests
+OS_Error_t
+__wrap_OS_CryptoDigest_init(
+    OS_CryptoDigest_Handle_t*   self,
+    const OS_Crypto_Handle_t    hCrypto,
+    const OS_CryptoDigest_Alg_t algorithm)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_CRYPTO, "OS_CryptoDigest_init");
+    err = __real_OS_CryptoDigest_init(self, hCrypto, algorithm);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_CryptoDigest_process(
+    OS_CryptoDigest_Handle_t self,
+    const void*              data,
+    const size_t             dataSize)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_CRYPTO, "OS_CryptoDigest_process");
+    err = __real_OS_CryptoDigest_process(self, data, dataSize);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_OS_CryptoDigest_finalize(
+    OS_CryptoDigest_Handle_t self,
+    void*                    digest,
+    size_t*                  digestSize)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_CRYPTO, "OS_CryptoDigest_finalize");
+    err = __real_OS_CryptoDigest_finalize(self, digest, digestSize);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+// Storage RPC, e.g. to the RamDisk
+OS_Error_t
+__wrap_storage_rpc_write(
+    off_t                   offset,
+    size_t                  size,
+    size_t*                 written)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_STORAGE, "storage_rpc_write");
+    err = __real_storage_rpc_write(offset, size, written);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_storage_rpc_read(
+    off_t                   offset,
+    size_t                  size,
+    size_t*                 read)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_STORAGE, "storage_rpc_read");
+    err = __real_storage_rpc_read(offset, size, read);
+    KeyStoreTrace_END();
+
+    return err;
+}
+
+OS_Error_t
+__wrap_storage_rpc_erase(
+    off_t                   offset,
+    off_t                   size,
+    off_t*                  erased)
+{
+    OS_Error_t err;
+
+    KeyStoreTrace_BEGIN(KeyStoreTrace_PHASE_STORAGE, "storage_rpc_erase");
+    err = __real_storage_rpc_erase(offset, size, erased);
+    KeyStoreTrace_END();
+
+    return err;
+}
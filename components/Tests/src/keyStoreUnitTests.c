@@ -7,6 +7,8 @@
  */
 
 /* Includes ------------------------------------------------------------------*/
+#include "system_config.h"
+
 #include "keyStoreUnitTests.h"
 #include "OS_Keystore.h"
 #include "OS_KeystoreRamFV.h"
@@ -17,7 +19,7 @@
 
 /* Defines -------------------------------------------------------------------*/
 // Various values for the keyStoreUnitTests
-#define KEY_SIZE_MAX        2080
+#define KEY_SIZE_MAX        KeyStore_Config_MAX_KEY_SIZE
 
 #define KEY_NAME            "Key"
 #define KEY_NAME_MAX_LEN    "PrivateKey12345"   // strlen is 15
@@ -138,9 +140,9 @@ testKeyStoreRamFVSaturation(
     OS_Keystore_Handle_t hKeystore,
     int keyStoreCapacity)
 {
-    char name[sizeof(KEY_NAME) + 11]; // 11 more chars to append '-' and the
+    char name[sizeof(KEY_NAME) + 12]; // 12 more chars to append '-' and the
                                       // iteration counter(e.g. 'key_name-187').
-                                      // INT_MAX is 2147483647 (10 chars).
+                                      // INT_MIN is -2147483648 (11 chars).
     int i = 0;
     OS_Error_t err = OS_Keystore_wipeKeystore(hKeystore);
 
@@ -0,0 +1,666 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreVersioned.h"
+#include "lib_debug/Debug.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define NUM_SLOTS           2
+// Key name plus "#" and the slot number
+#define SLOT_NAME_LEN       (KeyStoreVersioned_MAX_NAME_LEN + 2)
+#define NO_SLOT             (-1)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+    bool                        exists;
+    size_t                      size;   ///< size of the whole record
+    KeyStoreVersioned_Header_t  hdr;
+} SlotInfo_t;
+
+/* Private functions ---------------------------------------------------------*/
+static bool
+isValidName(
+    const char* name)
+{
+    size_t len;
+
+    if (NULL == name)
+    {
+        return false;
+    }
+
+    len = strnlen(name, KeyStoreVersioned_MAX_NAME_LEN + 1);
+
+    return (len > 0) && (len <= KeyStoreVersioned_MAX_NAME_LEN);
+}
+
+static void
+getSlotName(
+    const char* name,
+    int         slot,
+    char        slotName[SLOT_NAME_LEN + 1])
+{
+    snprintf(slotName, SLOT_NAME_LEN + 1, "%s#%d", name, slot);
+}
+
+// Generations may wrap around, so compare them in serial number arithmetic
+static bool
+isNewer(
+    uint32_t a,
+    uint32_t b)
+{
+    return (int32_t)(a - b) > 0;
+}
+
+static KeyStoreVersioned_CacheEntry_t*
+lookupCache(
+    KeyStoreVersioned_t*    self,
+    const char*             name)
+{
+    for (size_t i = 0; i < KeyStoreVersioned_CACHE_SIZE; i++)
+    {
+        if (self->cache[i].valid && !strcmp(self->cache[i].name, name))
+        {
+            return &self->cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void
+dropCache(
+    KeyStoreVersioned_t*    self,
+    const char*             name)
+{
+    KeyStoreVersioned_CacheEntry_t* entry = lookupCache(self, name);
+
+    if (entry != NULL)
+    {
+        entry->valid = false;
+    }
+}
+
+static void
+updateCache(
+    KeyStoreVersioned_t*                self,
+    const char*                         name,
+    int                                 slot,
+    bool                                hasStale,
+    const KeyStoreVersioned_Header_t*   hdr,
+    size_t                              keySize)
+{
+    KeyStoreVersioned_CacheEntry_t* entry = lookupCache(self, name);
+
+    if (NULL == entry)
+    {
+        entry = &self->cache[self->nextVictim];
+        self->nextVictim = (self->nextVictim + 1) % KeyStoreVersioned_CACHE_SIZE;
+        strncpy(entry->name, name, sizeof(entry->name) - 1);
+        entry->name[sizeof(entry->name) - 1] = '\0';
+        entry->valid = true;
+    }
+
+    entry->slot            = slot;
+    entry->hasStale        = hasStale;
+    entry->info.exists     = true;
+    entry->info.size       = keySize;
+    entry->info.createdAt  = hdr->createdAt;
+    entry->info.type       = hdr->type;
+    entry->info.generation = hdr->generation;
+}
+
+static OS_Error_t
+readSlot(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    int                     slot,
+    uint8_t*                buf,
+    SlotInfo_t*             info)
+{
+    OS_Error_t err;
+    char slotName[SLOT_NAME_LEN + 1];
+
+    memset(info, 0, sizeof(*info));
+
+    getSlotName(name, slot, slotName);
+    info->size = KeyStoreVersioned_MAX_RECORD_SIZE;
+    self->numLoads++;
+    err = OS_Keystore_loadKey(self->hKeystore, slotName, buf, &info->size);
+    if (OS_ERROR_NOT_FOUND == err)
+    {
+        return OS_SUCCESS;
+    }
+    else if (err != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_Keystore_loadKey() failed for '%s' with %d",
+                        slotName, err);
+        return err;
+    }
+
+    if (info->size >= sizeof(info->hdr))
+    {
+        memcpy(&info->hdr, buf, sizeof(info->hdr));
+    }
+    if ((info->size < sizeof(info->hdr))
+        || (info->hdr.magic != KeyStoreVersioned_RECORD_MAGIC))
+    {
+        Debug_LOG_ERROR("Slot '%s' does not hold a versioned key", slotName);
+        return OS_ERROR_INVALID_STATE;
+    }
+
+    info->exists = true;
+
+    return OS_SUCCESS;
+}
+
+// Reads both slots of a key and returns the one holding the newest generation
+// of the key, or NO_SLOT; the cache is updated accordingly
+static OS_Error_t
+findKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    uint8_t*                bufs[NUM_SLOTS],
+    SlotInfo_t              info[NUM_SLOTS],
+    int*                    current)
+{
+    OS_Error_t err;
+
+    *current = NO_SLOT;
+
+    for (int slot = 0; slot < NUM_SLOTS; slot++)
+    {
+        if ((err = readSlot(self, name, slot, bufs[slot], &info[slot]))
+            != OS_SUCCESS)
+        {
+            return err;
+        }
+        if (info[slot].exists
+            && ((NO_SLOT == *current)
+                || isNewer(info[slot].hdr.generation,
+                           info[*current].hdr.generation)))
+        {
+            *current = slot;
+        }
+    }
+
+    if (NO_SLOT == *current)
+    {
+        dropCache(self, name);
+    }
+    else
+    {
+        updateCache(self, name, *current, info[1 - *current].exists,
+                    &info[*current].hdr,
+                    info[*current].size - sizeof(KeyStoreVersioned_Header_t));
+    }
+
+    return OS_SUCCESS;
+}
+
+// Reads the slots of a key from the keystore and returns its refreshed cache
+// entry; entry is NULL if the key does not exist
+static OS_Error_t
+readKey(
+    KeyStoreVersioned_t*                self,
+    const char*                         name,
+    KeyStoreVersioned_CacheEntry_t**    entry)
+{
+    OS_Error_t err;
+    uint8_t* bufs[NUM_SLOTS] = { self->record, self->other };
+    SlotInfo_t info[NUM_SLOTS];
+    int current;
+
+    *entry = NULL;
+
+    if ((err = findKey(self, name, bufs, info, &current)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    *entry = lookupCache(self, name);
+
+    return OS_SUCCESS;
+}
+
+// Returns the cache entry of a key, reading the key from the keystore if it is
+// not cached; entry is NULL if the key does not exist. Only good for metadata,
+// as someone else may have changed the key since it was cached
+static OS_Error_t
+resolveKey(
+    KeyStoreVersioned_t*                self,
+    const char*                         name,
+    KeyStoreVersioned_CacheEntry_t**    entry)
+{
+    if ((*entry = lookupCache(self, name)) != NULL)
+    {
+        return OS_SUCCESS;
+    }
+
+    return readKey(self, name, entry);
+}
+
+static OS_Error_t
+deleteSlot(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    int                     slot)
+{
+    char slotName[SLOT_NAME_LEN + 1];
+
+    getSlotName(name, slot, slotName);
+    self->numDeletes++;
+
+    return OS_Keystore_deleteKey(self->hKeystore, slotName);
+}
+
+// Deletes the slot a replacement has just written, unless someone else has
+// replaced it since
+static void
+undoSlot(
+    KeyStoreVersioned_t*                self,
+    const char*                         name,
+    int                                 slot,
+    const KeyStoreVersioned_Header_t*   hdr)
+{
+    SlotInfo_t info;
+
+    if ((readSlot(self, name, slot, self->other, &info) == OS_SUCCESS)
+        && info.exists && (info.hdr.generation == hdr->generation)
+        && (info.hdr.createdAt == hdr->createdAt))
+    {
+        (void) deleteSlot(self, name, slot);
+    }
+}
+
+// Writes the next generation of a key into the slot next to the one the cache
+// entry points to, entry is NULL for a new key; returns OS_ERROR_ABORTED if
+// the key does not match the entry and OS_ERROR_INVALID_PARAMETER if the
+// slot is taken
+static OS_Error_t
+writeKey(
+    KeyStoreVersioned_t*                    self,
+    const char*                             name,
+    const KeyStoreVersioned_CacheEntry_t*   entry,
+    KeyStoreVersioned_Header_t*             hdr,
+    void const*                             keyData,
+    size_t                                  keySize)
+{
+    OS_Error_t err;
+    SlotInfo_t info;
+    char slotName[SLOT_NAME_LEN + 1];
+    bool hasStale;
+    int current;
+    int target;
+
+    if (NULL == entry)
+    {
+        current         = NO_SLOT;
+        target          = 0;
+        hdr->generation = KeyStoreVersioned_GENERATION_NONE + 1;
+        hdr->createdAt  = (self->getTime != NULL) ? self->getTime() : 0;
+    }
+    else
+    {
+        // Metadata is kept over all generations of a key
+        current         = entry->slot;
+        target          = 1 - current;
+        hdr->generation = entry->info.generation + 1;
+        hdr->type       = entry->info.type;
+        hdr->createdAt  = entry->info.createdAt;
+
+        // A leftover of an interrupted replacement has to go first; entries
+        // with a stale slot are always read from the keystore just before,
+        // so the slot holds an older generation than the current one
+        if (entry->hasStale
+            && ((err = deleteSlot(self, name, target)) != OS_SUCCESS))
+        {
+            return err;
+        }
+    }
+    if (KeyStoreVersioned_GENERATION_NONE == hdr->generation)
+    {
+        hdr->generation++;
+    }
+
+    memcpy(self->record, hdr, sizeof(*hdr));
+    memcpy(self->record + sizeof(*hdr), keyData, keySize);
+
+    // Taking the slot only fails if someone else has written it since the
+    // entry was read, which the caller has to sort out
+    getSlotName(name, target, slotName);
+    self->numStores++;
+    if ((err = OS_Keystore_storeKey(self->hKeystore, slotName, self->record,
+                                    sizeof(*hdr) + keySize)) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    // An even number of replacements by someone else leaves the slot free,
+    // so the other slot has to be checked to still hold the generation the
+    // new one is based on; only then it may be deleted
+    if ((err = readSlot(self, name, 1 - target, self->other, &info))
+        != OS_SUCCESS)
+    {
+        // Both generations are left, readers pick the new one
+        return err;
+    }
+    if ((NULL == entry) ?
+        info.exists :
+        (!info.exists || (info.hdr.generation != entry->info.generation)
+         || (info.hdr.createdAt != entry->info.createdAt)))
+    {
+        undoSlot(self, name, target, hdr);
+        return OS_ERROR_ABORTED;
+    }
+
+    // The new generation is visible now; if the old one can't be removed it
+    // is shadowed and cleaned up by the next replacement
+    hasStale = false;
+    if ((current != NO_SLOT)
+        && ((err = deleteSlot(self, name, current)) != OS_SUCCESS))
+    {
+        Debug_LOG_WARNING("Removing old generation of '%s' failed with %d",
+                          name, err);
+        hasStale = true;
+    }
+
+    updateCache(self, name, target, hasStale, hdr, keySize);
+
+    return OS_SUCCESS;
+}
+
+static OS_Error_t
+putKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    uint32_t                type,
+    void const*             keyData,
+    size_t                  keySize,
+    uint32_t                expectedGeneration)
+{
+    OS_Error_t err;
+    KeyStoreVersioned_CacheEntry_t* entry;
+    KeyStoreVersioned_Header_t hdr =
+    {
+        .magic = KeyStoreVersioned_RECORD_MAGIC,
+        .type  = type,
+    };
+    bool isFresh = false;
+
+    Debug_ASSERT_SELF(self);
+
+    if (!isValidName(name) || (NULL == keyData) || (0 == keySize)
+        || (keySize > KeyStoreVersioned_MAX_KEY_SIZE))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    // A cached key is trusted, writing its next slot fails if another
+    // instance has replaced it since. Everything else is read from the
+    // keystore first: unknown keys, keys with a stale slot to remove and
+    // keys cached with another generation than expected
+    entry = lookupCache(self, name);
+    if ((NULL == entry) || entry->hasStale
+        || (entry->info.generation != expectedGeneration))
+    {
+        if ((err = readKey(self, name, &entry)) != OS_SUCCESS)
+        {
+            return err;
+        }
+        isFresh = true;
+    }
+
+    for (;;)
+    {
+        if ((NULL == entry) ?
+            (expectedGeneration != KeyStoreVersioned_GENERATION_NONE) :
+            (expectedGeneration != entry->info.generation))
+        {
+            return OS_ERROR_ABORTED;
+        }
+
+        err = writeKey(self, name, entry, &hdr, keyData, keySize);
+        if ((err != OS_ERROR_INVALID_PARAMETER) || isFresh)
+        {
+            break;
+        }
+
+        // The cache was outdated, try once more with the slots as they are
+        if ((err = readKey(self, name, &entry)) != OS_SUCCESS)
+        {
+            return err;
+        }
+        isFresh = true;
+    }
+
+    if (err != OS_SUCCESS)
+    {
+        // The cache may not match the keystore anymore
+        dropCache(self, name);
+        // The parameters were checked, so someone else took the slot since
+        // it was read
+        return (OS_ERROR_INVALID_PARAMETER == err) ? OS_ERROR_ABORTED : err;
+    }
+
+    return OS_SUCCESS;
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+KeyStoreVersioned_init(
+    KeyStoreVersioned_t*    self,
+    OS_Keystore_Handle_t    hKeystore)
+{
+    if ((NULL == self) || (NULL == hKeystore))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(self, 0, sizeof(*self));
+    self->hKeystore = hKeystore;
+
+    return OS_SUCCESS;
+}
+
+void
+KeyStoreVersioned_setTimeSource(
+    KeyStoreVersioned_t*    self,
+    uint64_t                (*getTime)(void))
+{
+    Debug_ASSERT_SELF(self);
+
+    self->getTime = getTime;
+}
+
+OS_Error_t
+KeyStoreVersioned_storeKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize)
+{
+    return KeyStoreVersioned_storeTypedKey(self, name,
+                                           KeyStoreVersioned_TYPE_NONE,
+                                           keyData, keySize);
+}
+
+OS_Error_t
+KeyStoreVersioned_storeTypedKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    uint32_t                type,
+    void const*             keyData,
+    size_t                  keySize)
+{
+    OS_Error_t err;
+
+    err = putKey(self, name, type, keyData, keySize,
+                 KeyStoreVersioned_GENERATION_NONE);
+
+    return (OS_ERROR_ABORTED == err) ? OS_ERROR_INVALID_PARAMETER : err;
+}
+
+OS_Error_t
+KeyStoreVersioned_replaceKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    void const*             keyData,
+    size_t                  keySize,
+    uint32_t                expectedGeneration)
+{
+    return putKey(self, name, KeyStoreVersioned_TYPE_NONE, keyData, keySize,
+                  expectedGeneration);
+}
+
+OS_Error_t
+KeyStoreVersioned_loadKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name,
+    void*                   keyData,
+    size_t*                 keySize,
+    uint32_t*               generation)
+{
+    OS_Error_t err;
+    KeyStoreVersioned_CacheEntry_t* entry;
+    uint8_t* bufs[NUM_SLOTS] = { self->record, self->other };
+    SlotInfo_t info[NUM_SLOTS];
+    const uint8_t* record = NULL;
+    size_t dataSize;
+    int current;
+
+    Debug_ASSERT_SELF(self);
+
+    if (!isValidName(name) || (NULL == keyData) || (NULL == keySize))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    // With the current slot known, only that one needs to be read
+    if ((entry = lookupCache(self, name)) != NULL)
+    {
+        if ((err = readSlot(self, name, entry->slot, self->record, &info[0]))
+            != OS_SUCCESS)
+        {
+            return err;
+        }
+        if (info[0].exists
+            && (info[0].hdr.generation == entry->info.generation))
+        {
+            record = self->record;
+        }
+    }
+
+    if (NULL == record)
+    {
+        if ((err = findKey(self, name, bufs, info, &current)) != OS_SUCCESS)
+        {
+            return err;
+        }
+        if (NO_SLOT == current)
+        {
+            return OS_ERROR_NOT_FOUND;
+        }
+        record  = bufs[current];
+        info[0] = info[current];
+    }
+
+    dataSize = info[0].size - sizeof(KeyStoreVersioned_Header_t);
+    if (*keySize < dataSize)
+    {
+        *keySize = dataSize;
+        return OS_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    memcpy(keyData, record + sizeof(KeyStoreVersioned_Header_t), dataSize);
+    *keySize = dataSize;
+
+    if (generation != NULL)
+    {
+        *generation = info[0].hdr.generation;
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreVersioned_statKey(
+    KeyStoreVersioned_t*        self,
+    const char*                 name,
+    KeyStoreVersioned_Info_t*   info)
+{
+    OS_Error_t err;
+    KeyStoreVersioned_CacheEntry_t* entry;
+
+    Debug_ASSERT_SELF(self);
+
+    if (!isValidName(name) || (NULL == info))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    memset(info, 0, sizeof(*info));
+
+    if ((err = resolveKey(self, name, &entry)) != OS_SUCCESS)
+    {
+        return err;
+    }
+    if (NULL == entry)
+    {
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    *info = entry->info;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+KeyStoreVersioned_deleteKey(
+    KeyStoreVersioned_t*    self,
+    const char*             name)
+{
+    OS_Error_t err;
+    KeyStoreVersioned_CacheEntry_t* entry;
+    bool hasStale;
+    int current;
+
+    Debug_ASSERT_SELF(self);
+
+    if (!isValidName(name))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    if ((err = readKey(self, name, &entry)) != OS_SUCCESS)
+    {
+        return err;
+    }
+    if (NULL == entry)
+    {
+        return OS_ERROR_NOT_FOUND;
+    }
+
+    current  = entry->slot;
+    hasStale = entry->hasStale;
+    dropCache(self, name);
+
+    // Remove a stale slot first, so an interruption never brings back an old
+    // generation of the key
+    if (hasStale
+        && ((err = deleteSlot(self, name, 1 - current)) != OS_SUCCESS))
+    {
+        return err;
+    }
+
+    return deleteSlot(self, name, current);
+}
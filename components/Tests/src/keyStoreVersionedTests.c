@@ -0,0 +1,634 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "keyStoreVersionedTests.h"
+#include "keyStoreVersioned.h"
+#include "keyStoreBenchmark.h"
+#include "OS_Keystore.h"
+#include "lib_debug/Debug.h"
+#include "lib_macros/Test.h"
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define KEY_NAME            "Rot"
+#define KEY_NAME_SLOT_0     "Rot#0"
+#define KEY_NAME_SLOT_1     "Rot#1"
+#define KEY_NAME_MAX_LEN    "PrivateKey123"     // strlen is 13
+#define KEY_NAME_TOO_LARGE  "PrivateKey1234"    // strlen is 14
+#define KEY_DATA_A          "AAAAAAAAAAAAAAAA"
+#define KEY_DATA_B          "BBBBBBBBBBBBBBBB"
+#define KEY_DATA_C          "CCCCCCCCCCCCCCCC"
+#define KEY_SIZE            (sizeof(KEY_DATA_A) - 1)
+#define KEY_TYPE            42
+
+// Number of rotations per benchmark run
+#define NUM_ROTATIONS       20
+
+/* Private variables ---------------------------------------------------------*/
+static KeyStoreVersioned_t versioned;
+// Second client on the same keystore, with a cache of its own
+static KeyStoreVersioned_t versionedOther;
+static char keyData[KEY_SIZE];
+static uint8_t record[sizeof(KeyStoreVersioned_Header_t) + KEY_SIZE];
+
+/* Private functions prototypes ----------------------------------------------*/
+static void
+testReplaceKey(
+    OS_Keystore_Handle_t hKeystore);
+static void
+testConflictingRotations(
+    OS_Keystore_Handle_t hKeystore);
+static void
+testOutdatedRotation(
+    OS_Keystore_Handle_t hKeystore);
+static void
+testInterruptedRotation(
+    OS_Keystore_Handle_t hKeystore);
+static void
+testStatKey(
+    OS_Keystore_Handle_t hKeystore);
+static void
+testStatKeyIo(
+    OS_Keystore_Handle_t hKeystore);
+
+/* Public functions -----------------------------------------------------------*/
+void keyStoreVersionedTests(
+    OS_Keystore_Handle_t hKeystore)
+{
+    TEST_START();
+
+    testReplaceKey(hKeystore);
+    testConflictingRotations(hKeystore);
+    testOutdatedRotation(hKeystore);
+    testInterruptedRotation(hKeystore);
+    testStatKey(hKeystore);
+    testStatKeyIo(hKeystore);
+
+    TEST_FINISH();
+}
+
+void keyStoreVersionedBenchmark(
+    OS_Keystore_Handle_t hKeystore,
+    const char*          backend)
+{
+    TEST_START("backend", backend);
+
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreBenchmark_Cycles_t start;
+    KeyStoreBenchmark_Cycles_t cycles;
+    uint32_t gen;
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Rotation as it is done without generations
+    err = OS_Keystore_storeKey(hKeystore, KEY_NAME, KEY_DATA_A, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    start = KeyStoreBenchmark_getCycles();
+    for (int i = 0; i < NUM_ROTATIONS; i++)
+    {
+        err = OS_Keystore_deleteKey(hKeystore, KEY_NAME);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+        err = OS_Keystore_storeKey(hKeystore, KEY_NAME,
+                                   (i & 1) ? KEY_DATA_A : KEY_DATA_B, KEY_SIZE);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("rotateKeyDeleteStore", backend, KEY_SIZE,
+                             NUM_ROTATIONS, cycles);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Rotation with compare-and-swap
+    err = KeyStoreVersioned_init(&versioned, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_storeKey(&versioned, KEY_NAME, KEY_DATA_A,
+                                     KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    gen = 1;
+    start = KeyStoreBenchmark_getCycles();
+    for (int i = 0; i < NUM_ROTATIONS; i++)
+    {
+        err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME,
+                                           (i & 1) ? KEY_DATA_A : KEY_DATA_B,
+                                           KEY_SIZE, gen++);
+        ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    }
+    cycles = KeyStoreBenchmark_getCycles() - start;
+    KeyStoreBenchmark_report("rotateKeyReplace", backend, KEY_SIZE,
+                             NUM_ROTATIONS, cycles);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    TEST_FINISH();
+}
+
+/* Private functions ---------------------------------------------------------*/
+static void
+testReplaceKey(
+    OS_Keystore_Handle_t hKeystore)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    size_t len;
+    uint32_t gen;
+
+    /********************************** TestKeyStore_testCase_23 ************************************/
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_init(&versioned, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Replacing a key which does not exist yet requires generation NONE
+    err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME, KEY_DATA_A,
+                                       KEY_SIZE, 1);
+    ASSERT_EQ_OS_ERR(OS_ERROR_ABORTED, err);
+
+    err = KeyStoreVersioned_storeKey(&versioned, KEY_NAME, KEY_DATA_A,
+                                     KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Same behavior as OS_Keystore_storeKey() for existing keys
+    err = KeyStoreVersioned_storeKey(&versioned, KEY_NAME, KEY_DATA_A,
+                                     KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len, &gen);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(KEY_SIZE, len);
+    ASSERT_EQ_INT(1, gen);
+
+    err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME, KEY_DATA_B,
+                                       KEY_SIZE, gen);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len, &gen);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(2, gen);
+    ASSERT_EQ_INT(0, memcmp(KEY_DATA_B, keyData, KEY_SIZE));
+
+    // Only the slot with the new generation is left
+    len = sizeof(record);
+    err = OS_Keystore_loadKey(hKeystore, KEY_NAME_SLOT_0, record, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    len = sizeof(record);
+    err = OS_Keystore_loadKey(hKeystore, KEY_NAME_SLOT_1, record, &len);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Parameter checks
+    len = 0;
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len, NULL);
+    ASSERT_EQ_OS_ERR(OS_ERROR_BUFFER_TOO_SMALL, err);
+    ASSERT_EQ_SZ(KEY_SIZE, len);
+
+    err = KeyStoreVersioned_storeKey(&versioned, KEY_NAME_MAX_LEN, KEY_DATA_A,
+                                     KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_storeKey(&versioned, KEY_NAME_TOO_LARGE,
+                                     KEY_DATA_A, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME, NULL, KEY_SIZE,
+                                       gen);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME, KEY_DATA_A,
+                                       KeyStoreVersioned_MAX_KEY_SIZE + 1, gen);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreVersioned_deleteKey(&versioned, KEY_NAME);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_deleteKey(&versioned, KEY_NAME);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testConflictingRotations(
+    OS_Keystore_Handle_t hKeystore)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    size_t len;
+    uint32_t genClientA;
+    uint32_t genClientB;
+
+    /********************************** TestKeyStore_testCase_24 ************************************/
+    // Client A works with versioned, client B with versionedOther
+    err = KeyStoreVersioned_init(&versioned, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_init(&versionedOther, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_storeKey(&versioned, KEY_NAME, KEY_DATA_A,
+                                     KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Both clients see the same generation
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len,
+                                    &genClientA);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versionedOther, KEY_NAME, keyData, &len,
+                                    &genClientB);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(genClientA, genClientB);
+
+    // First rotation wins, the second one is rejected although its cache
+    // still holds the generation it is based on
+    err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME, KEY_DATA_B,
+                                       KEY_SIZE, genClientA);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_replaceKey(&versionedOther, KEY_NAME, KEY_DATA_C,
+                                       KEY_SIZE, genClientB);
+    ASSERT_EQ_OS_ERR(OS_ERROR_ABORTED, err);
+
+    // The key of the winner survived, for both clients
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len,
+                                    &genClientA);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(genClientB + 1, genClientA);
+    ASSERT_EQ_INT(0, memcmp(KEY_DATA_B, keyData, KEY_SIZE));
+
+    // The loser sees the key of the winner and can retry
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versionedOther, KEY_NAME, keyData, &len,
+                                    &genClientB);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(genClientA, genClientB);
+    ASSERT_EQ_INT(0, memcmp(KEY_DATA_B, keyData, KEY_SIZE));
+
+    err = KeyStoreVersioned_replaceKey(&versionedOther, KEY_NAME, KEY_DATA_C,
+                                       KEY_SIZE, genClientB);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len,
+                                    &genClientA);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(genClientB + 1, genClientA);
+    ASSERT_EQ_INT(0, memcmp(KEY_DATA_C, keyData, KEY_SIZE));
+
+    // A rotation based on a key which was deleted and created again by the
+    // other client is rejected and leaves the new key alone
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versionedOther, KEY_NAME, keyData, &len,
+                                    &genClientB);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_deleteKey(&versioned, KEY_NAME);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_storeKey(&versioned, KEY_NAME, KEY_DATA_A,
+                                     KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_replaceKey(&versionedOther, KEY_NAME, KEY_DATA_B,
+                                       KEY_SIZE, genClientB);
+    ASSERT_EQ_OS_ERR(OS_ERROR_ABORTED, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versionedOther, KEY_NAME, keyData, &len,
+                                    &genClientB);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(1, genClientB);
+    ASSERT_EQ_INT(0, memcmp(KEY_DATA_A, keyData, KEY_SIZE));
+
+    // A rotation based on a deleted key is rejected as well
+    err = KeyStoreVersioned_deleteKey(&versioned, KEY_NAME);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_replaceKey(&versionedOther, KEY_NAME, KEY_DATA_C,
+                                       KEY_SIZE, genClientB);
+    ASSERT_EQ_OS_ERR(OS_ERROR_ABORTED, err);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testOutdatedRotation(
+    OS_Keystore_Handle_t hKeystore)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    size_t len;
+    size_t loads;
+    size_t stores;
+    size_t deletes;
+    uint32_t genClientA;
+    uint32_t genClientB;
+
+    /********************************** TestKeyStore_testCase_54 ************************************/
+    // Client A works with versioned, client B with versionedOther
+    err = KeyStoreVersioned_init(&versioned, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_init(&versionedOther, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_storeKey(&versioned, KEY_NAME, KEY_DATA_A,
+                                     KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    genClientA = 1;
+
+    // A rotation of a cached key writes the free slot, checks the old one
+    // and deletes it
+    loads   = versioned.numLoads;
+    stores  = versioned.numStores;
+    deletes = versioned.numDeletes;
+    err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME, KEY_DATA_B,
+                                       KEY_SIZE, genClientA++);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(loads + 1, versioned.numLoads);
+    ASSERT_EQ_SZ(stores + 1, versioned.numStores);
+    ASSERT_EQ_SZ(deletes + 1, versioned.numDeletes);
+
+    // Client B rotates the key twice behind the back of client A, which
+    // leaves the slot A is going to write free again
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versionedOther, KEY_NAME, keyData, &len,
+                                    &genClientB);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(genClientA, genClientB);
+
+    err = KeyStoreVersioned_replaceKey(&versionedOther, KEY_NAME, KEY_DATA_A,
+                                       KEY_SIZE, genClientB++);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_replaceKey(&versionedOther, KEY_NAME, KEY_DATA_C,
+                                       KEY_SIZE, genClientB++);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // The rotation of A, based on its cache, is rejected and rolled back,
+    // the key of B survives
+    err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME, KEY_DATA_B,
+                                       KEY_SIZE, genClientA);
+    ASSERT_EQ_OS_ERR(OS_ERROR_ABORTED, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versionedOther, KEY_NAME, keyData, &len,
+                                    &genClientB);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(genClientA + 2, genClientB);
+    ASSERT_EQ_INT(0, memcmp(KEY_DATA_C, keyData, KEY_SIZE));
+
+    len = sizeof(record);
+    err = OS_Keystore_loadKey(hKeystore, KEY_NAME_SLOT_0, record, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    // Client A sees the key of B and can retry
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len,
+                                    &genClientA);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(genClientB, genClientA);
+    ASSERT_EQ_INT(0, memcmp(KEY_DATA_C, keyData, KEY_SIZE));
+
+    err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME, KEY_DATA_B,
+                                       KEY_SIZE, genClientA);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versionedOther, KEY_NAME, keyData, &len,
+                                    &genClientB);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(genClientA + 1, genClientB);
+    ASSERT_EQ_INT(0, memcmp(KEY_DATA_B, keyData, KEY_SIZE));
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testInterruptedRotation(
+    OS_Keystore_Handle_t hKeystore)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreVersioned_Header_t hdr =
+    {
+        .magic      = KeyStoreVersioned_RECORD_MAGIC,
+        .generation = 1
+    };
+    size_t len;
+    uint32_t gen;
+
+    /********************************** TestKeyStore_testCase_25 ************************************/
+    err = KeyStoreVersioned_init(&versioned, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Generation 2 lives in slot 1 after one rotation
+    err = KeyStoreVersioned_storeKey(&versioned, KEY_NAME, KEY_DATA_A,
+                                     KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME, KEY_DATA_B,
+                                       KEY_SIZE, 1);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Put generation 1 back into slot 0, as if its removal was interrupted
+    memcpy(record, &hdr, sizeof(hdr));
+    memcpy(record + sizeof(hdr), KEY_DATA_A, KEY_SIZE);
+    err = OS_Keystore_storeKey(hKeystore, KEY_NAME_SLOT_0, record,
+                               sizeof(record));
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // The keystore was modified behind the back of the layer, so it has to
+    // be initialized again, as it would be after a restart
+    err = KeyStoreVersioned_init(&versioned, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len, &gen);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(2, gen);
+    ASSERT_EQ_INT(0, memcmp(KEY_DATA_B, keyData, KEY_SIZE));
+
+    // The next rotation replaces the leftover
+    err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME, KEY_DATA_C,
+                                       KEY_SIZE, gen);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = sizeof(keyData);
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len, &gen);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_INT(3, gen);
+    ASSERT_EQ_INT(0, memcmp(KEY_DATA_C, keyData, KEY_SIZE));
+
+    len = sizeof(record);
+    err = OS_Keystore_loadKey(hKeystore, KEY_NAME_SLOT_1, record, &len);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testStatKey(
+    OS_Keystore_Handle_t hKeystore)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreVersioned_Info_t info;
+    uint64_t createdAt;
+
+    /********************************** TestKeyStore_testCase_26 ************************************/
+    err = KeyStoreVersioned_init(&versioned, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    KeyStoreVersioned_setTimeSource(&versioned, KeyStoreBenchmark_getCycles);
+
+    err = KeyStoreVersioned_storeTypedKey(&versioned, KEY_NAME, KEY_TYPE,
+                                          KEY_DATA_A, KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_statKey(&versioned, KEY_NAME, &info);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_TRUE(info.exists);
+    ASSERT_EQ_SZ(KEY_SIZE, info.size);
+    ASSERT_EQ_INT(KEY_TYPE, info.type);
+    ASSERT_EQ_INT(1, info.generation);
+    createdAt = info.createdAt;
+
+    // Metadata survives a rotation and a restart
+    err = KeyStoreVersioned_replaceKey(&versioned, KEY_NAME, KEY_DATA_B,
+                                       KEY_SIZE - 1, info.generation);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_init(&versioned, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_statKey(&versioned, KEY_NAME, &info);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_TRUE(info.exists);
+    ASSERT_EQ_SZ(KEY_SIZE - 1, info.size);
+    ASSERT_EQ_INT(KEY_TYPE, info.type);
+    ASSERT_EQ_INT(2, info.generation);
+    ASSERT_TRUE(createdAt == info.createdAt);
+
+    // Missing keys and bad parameters
+    err = KeyStoreVersioned_deleteKey(&versioned, KEY_NAME);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_statKey(&versioned, KEY_NAME, &info);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+    ASSERT_TRUE(!info.exists);
+
+    err = KeyStoreVersioned_statKey(&versioned, KEY_NAME_TOO_LARGE, &info);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = KeyStoreVersioned_statKey(&versioned, KEY_NAME, NULL);
+    ASSERT_EQ_OS_ERR(OS_ERROR_INVALID_PARAMETER, err);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
+
+static void
+testStatKeyIo(
+    OS_Keystore_Handle_t hKeystore)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+    KeyStoreVersioned_Info_t info;
+    size_t len;
+    size_t loads;
+    size_t loadsProbe;
+    size_t loadsStat;
+
+    /********************************** TestKeyStore_testCase_27 ************************************/
+    err = KeyStoreVersioned_init(&versioned, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_storeKey(&versioned, KEY_NAME, KEY_DATA_A,
+                                     KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    // Size a buffer by probing with a zero-sized buffer, then load
+    loads = versioned.numLoads;
+    len = 0;
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len, NULL);
+    ASSERT_EQ_OS_ERR(OS_ERROR_BUFFER_TOO_SMALL, err);
+    ASSERT_EQ_SZ(KEY_SIZE, len);
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len, NULL);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    loadsProbe = versioned.numLoads - loads;
+
+    // Size a buffer with statKey(), then load
+    loads = versioned.numLoads;
+    err = KeyStoreVersioned_statKey(&versioned, KEY_NAME, &info);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(KEY_SIZE, info.size);
+    ASSERT_EQ_SZ(loads, versioned.numLoads);
+    len = info.size;
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len, NULL);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    loadsStat = versioned.numLoads - loads;
+
+    Debug_LOG_INFO("Keystore loads to size and load a key: %zu when probing, "
+                   "%zu with statKey()", loadsProbe, loadsStat);
+    ASSERT_TRUE(loadsStat < loadsProbe);
+
+    // A cold cache costs a full load of both slots, key data included, so
+    // sizing a buffer with statKey() is no cheaper than probing then
+    err = KeyStoreVersioned_init(&versioned, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_statKey(&versioned, KEY_NAME, &info);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(2, versioned.numLoads);
+    len = info.size;
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len, NULL);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    loadsStat = versioned.numLoads;
+
+    err = KeyStoreVersioned_init(&versioned, hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    len = 0;
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len, NULL);
+    ASSERT_EQ_OS_ERR(OS_ERROR_BUFFER_TOO_SMALL, err);
+    ASSERT_EQ_SZ(2, versioned.numLoads);
+    err = KeyStoreVersioned_loadKey(&versioned, KEY_NAME, keyData, &len, NULL);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    loadsProbe = versioned.numLoads;
+
+    Debug_LOG_INFO("Keystore loads to size and load a key with a cold cache: "
+                   "%zu when probing, %zu with statKey()", loadsProbe,
+                   loadsStat);
+    ASSERT_EQ_SZ(loadsProbe, loadsStat);
+
+    // After that the cache is warm
+    loads = versioned.numLoads;
+    err = KeyStoreVersioned_statKey(&versioned, KEY_NAME, &info);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    ASSERT_EQ_SZ(loads, versioned.numLoads);
+
+    // Keys not written by the layer are not known to it
+    err = OS_Keystore_storeKey(hKeystore, KEY_NAME_MAX_LEN, KEY_DATA_A,
+                               KEY_SIZE);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    err = KeyStoreVersioned_statKey(&versioned, KEY_NAME_MAX_LEN, &info);
+    ASSERT_EQ_OS_ERR(OS_ERROR_NOT_FOUND, err);
+
+    err = OS_Keystore_wipeKeystore(hKeystore);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+}
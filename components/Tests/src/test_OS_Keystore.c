@@ -18,6 +18,23 @@
 #include "keyStoreIntegrationTests.h"
 #include "keyStoreMultiInstanceTests.h"
 #include "keyStoreUnitTests.h"
+#include "keyStoreBloomTests.h"
+#include "keyStoreBenchmark.h"
+#include "keyStoreEntropyPool.h"
+#include "keyStoreEntropyPoolTests.h"
+#include "keyStoreVersionedTests.h"
+#include "keyStoreTieredTests.h"
+#include "keyStoreDerivedTests.h"
+#include "keyStoreCipherPoolTests.h"
+#include "keyStoreProvisioningTests.h"
+#include "keyStoreStatic.h"
+#include "keyStoreSnapshotTests.h"
+#include "keyStoreChecksumTests.h"
+#include "keyStoreRamFVImageTests.h"
+#include "keyStoreManagerTests.h"
+#include "keyStoreRamFVScaleTests.h"
+#include "keyStoreRealtimeTests.h"
+#include "keyStoreTrace.h"
 
 #include <string.h>
 
@@ -27,12 +44,15 @@
 #define KEYSTORE_NAME_TOO_LARGE "keystore1_123456"
 
 
+static const if_OS_Entropy_t entropy =
+    IF_OS_ENTROPY_ASSIGN(
+        entropy_rpc,
+        entropy_port);
+// The entropy interface is set in run(), the crypto library draws from the
+// entropy pool instead of calling the EntropySource directly
 static OS_Crypto_Config_t cfgCrypto =
 {
     .mode = OS_Crypto_MODE_LIBRARY,
-    .entropy = IF_OS_ENTROPY_ASSIGN(
-        entropy_rpc,
-        entropy_port),
 };
 static OS_FileSystem_Config_t cfgFs =
 {
@@ -43,6 +63,102 @@ static OS_FileSystem_Config_t cfgFs =
         storage_port),
 };
 
+#if KeyStoreStatic_HAS_RAMFV
+static char keystoreRam1Buf[
+    OS_KeystoreRamFV_SIZE_OF_BUFFER(KeyStore_Config_RAM_NUM_ELEMENTS)];
+static char keystoreRam2Buf[
+    OS_KeystoreRamFV_SIZE_OF_BUFFER(KeyStore_Config_RAM_NUM_ELEMENTS)];
+#endif
+
+#if KeyStoreStatic_HAS_FILE
+// Injects faults into the RamDisk behind the KeystoreFile instances
+static size_t
+corruptRamDisk(
+    const void* pattern,
+    size_t      len)
+{
+    return keyStoreCorruptStorage(&cfgFs.storage, pattern, len);
+}
+#endif
+
+#if KeyStoreStatic_HAS_RAMFV
+// Injects faults into the buffer of the 1st KeystoreRamFV
+static size_t
+corruptRamFV1(
+    const void* pattern,
+    size_t      len)
+{
+    return keyStoreCorruptBuffer(keystoreRam1Buf, sizeof(keystoreRam1Buf),
+                                 pattern, len);
+}
+#endif
+
+// Tests run on each backend, which needs two instances of it
+static void
+testBackend(
+    OS_Keystore_Handle_t    hKeystore1,
+    OS_Keystore_Handle_t    hKeystore2,
+    OS_Crypto_Handle_t      hCrypto)
+{
+    keyStoreUnitTests(hKeystore1);
+    testKeyStoreAES(hKeystore1, hCrypto);
+    testKeyStoreKeyPair(hKeystore1, hCrypto);
+    // Test copy and move on same implementations of keystore
+    keyStoreCopyKeyTest(hKeystore1, hKeystore2, hCrypto);
+    keyStoreMoveKeyTest(hKeystore1, hKeystore2, hCrypto);
+}
+
+// Tests of the features built on top of a backend, some of them need a second
+// instance of it
+static void
+testBackendFeatures(
+    OS_Keystore_Handle_t    hKeystore,
+    OS_Keystore_Handle_t    hKeystore2,
+    OS_Crypto_Handle_t      hCrypto)
+{
+    // Test negative-lookup filter
+    keyStoreBloomTests(hKeystore);
+    // Test entropy pool of the crypto library
+    keyStoreEntropyPoolTests(hKeystore, hCrypto);
+    // Test key rotation based on generations
+    keyStoreVersionedTests(hKeystore);
+    // Test derivation of session keys from cached master keys
+    keyStoreDerivedTests(hKeystore, hCrypto);
+    // Test pooled cipher contexts for keys loaded from the keystore
+    keyStoreCipherPoolTests(hKeystore, hCrypto);
+    // Test AES lanes on pooled contexts with known answers
+    testKeyStoreAESLanes(hKeystore, hCrypto);
+    // Test bulk provisioning of key pairs
+    keyStoreProvisioningTests(hKeystore);
+    // Test copy-on-write snapshots
+    keyStoreSnapshotTests(hKeystore, hKeystore2);
+}
+
+#if defined(KeyStoreBenchmark_Config_ENABLED)
+// Benchmarks of the features built on top of a backend
+static void
+benchmarkBackendFeatures(
+    OS_Keystore_Handle_t    hKeystore,
+    OS_Keystore_Handle_t    hKeystore2,
+    OS_Crypto_Handle_t      hCrypto,
+    const char*             backend)
+{
+    OS_Error_t err = OS_ERROR_GENERIC;
+
+    // Key generation bursts are not held up by refilling the entropy pool
+    err = KeyStoreEntropyPool_refill();
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+
+    keyStoreBloomBenchmark(hKeystore, backend);
+    keyStoreEntropyPoolBenchmark(hKeystore, hCrypto, backend);
+    keyStoreVersionedBenchmark(hKeystore, backend);
+    keyStoreDerivedBenchmark(hKeystore, hCrypto, backend);
+    keyStoreProvisioningBenchmark(hKeystore, backend);
+    keyStoreSnapshotBenchmark(hKeystore, hKeystore2, backend);
+    keyStoreChecksumBenchmark(hKeystore, backend);
+}
+#endif
+
 int run(
     void)
 {
@@ -50,18 +166,19 @@ int run(
 
     OS_FileSystem_Handle_t hFs;
     OS_Crypto_Handle_t hCrypto;
+#if KeyStoreStatic_HAS_FILE
     OS_Keystore_Handle_t hKeystoreFile1;
     OS_Keystore_Handle_t hKeystoreFile2;
-#define NUM_ELEMENTS_KEYSTORE_RAM 10
-    static char keystoreRam1Buf[
-        OS_KeystoreRamFV_SIZE_OF_BUFFER(NUM_ELEMENTS_KEYSTORE_RAM)];
-    static char keystoreRam2Buf[
-        OS_KeystoreRamFV_SIZE_OF_BUFFER(NUM_ELEMENTS_KEYSTORE_RAM)];
+#endif
+#if KeyStoreStatic_HAS_RAMFV
     OS_Keystore_Handle_t hKeystoreRamFV1;
     OS_Keystore_Handle_t hKeystoreRamFV2;
+#endif
 
     OS_Error_t err = OS_ERROR_GENERIC;
 
+    KeyStoreBenchmark_init();
+
     // Init FS and Crypto
     err = OS_FileSystem_init(&hFs, &cfgFs);
     ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
@@ -72,9 +189,14 @@ int run(
     err = OS_FileSystem_mount(hFs);
     ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
 
+    err = KeyStoreEntropyPool_init(&entropy, true);
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    cfgCrypto.entropy = *KeyStoreEntropyPool_getInterface();
+
     err = OS_Crypto_init(&hCrypto, &cfgCrypto);
     ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
 
+#if KeyStoreStatic_HAS_FILE
     // Test KeystoreFile name too large
     err = OS_KeystoreFile_init(
               &hKeystoreFile1,
@@ -98,7 +220,9 @@ int run(
               hCrypto,
               "keystore2");
     ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+#endif
 
+#if KeyStoreStatic_HAS_RAMFV
     // Create 1st KeystoreRamFV
     err = OS_KeystoreRamFV_init(
         &hKeystoreRamFV1,
@@ -112,32 +236,117 @@ int run(
         keystoreRam2Buf,
         sizeof(keystoreRam2Buf));
     ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+#endif
+    // With tracing compiled in, a breakdown is printed after every scenario
+    KeyStoreTrace_dump("setup");
 
-    keyStoreUnitTests(hKeystoreFile1);
-    keyStoreUnitTests(hKeystoreRamFV1);
-    keyStoreRamFVUnitTests(hKeystoreRamFV1,NUM_ELEMENTS_KEYSTORE_RAM);
-    testKeyStoreAES(hKeystoreFile1, hCrypto);
-    testKeyStoreAES(hKeystoreRamFV1, hCrypto);
-    testKeyStoreKeyPair(hKeystoreFile1, hCrypto);
-    testKeyStoreKeyPair(hKeystoreRamFV1, hCrypto);
-    // Test copy on same implementations of keystore
-    keyStoreCopyKeyTest(hKeystoreFile1, hKeystoreFile2, hCrypto);
-    keyStoreCopyKeyTest(hKeystoreRamFV1, hKeystoreRamFV2, hCrypto);
+#if KeyStoreStatic_HAS_FILE
+    testBackend(hKeystoreFile1, hKeystoreFile2, hCrypto);
+    KeyStoreTrace_dump("File");
+#endif
+#if KeyStoreStatic_HAS_RAMFV
+    testBackend(hKeystoreRamFV1, hKeystoreRamFV2, hCrypto);
+    keyStoreRamFVUnitTests(hKeystoreRamFV1, KeyStore_Config_RAM_NUM_ELEMENTS);
+    KeyStoreTrace_dump("RamFV");
+#endif
+#if KeyStoreStatic_HAS_FILE && KeyStoreStatic_HAS_RAMFV
     // Test copy on diverse implementations of keystore (all directions)
     keyStoreCopyKeyTest(hKeystoreRamFV1, hKeystoreFile1, hCrypto);
     keyStoreCopyKeyTest(hKeystoreFile1, hKeystoreRamFV1, hCrypto);
-    // Test move on same implementations of keystore
-    keyStoreMoveKeyTest(hKeystoreFile1, hKeystoreFile2, hCrypto);
-    keyStoreMoveKeyTest(hKeystoreRamFV1, hKeystoreRamFV2, hCrypto);
     // Test move on diverse implementations of keystore (all directions)
     keyStoreMoveKeyTest(hKeystoreFile1, hKeystoreRamFV1, hCrypto);
     keyStoreMoveKeyTest(hKeystoreRamFV1, hKeystoreFile1, hCrypto);
+    KeyStoreTrace_dump("FileRamFV");
+#endif
+
+    // The scenarios below provision keys in bursts; the entropy pool is
+    // topped up in between, as an idle loop would do, so the bursts are not
+    // held up by refilling it
+#if KeyStoreStatic_HAS_FILE
+    err = KeyStoreEntropyPool_refill();
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    testBackendFeatures(hKeystoreFile1, hKeystoreFile2, hCrypto);
+    // Test detection of corrupted key data on the RamDisk
+    keyStoreChecksumTests(hKeystoreFile1, corruptRamDisk);
+    KeyStoreTrace_dump("FileFeatures");
+    // Test many KeystoreFile instances over the same file system
+    keyStoreManagerTests(hFs, hCrypto);
+    KeyStoreTrace_dump("FileManager");
+#endif
+#if KeyStoreStatic_HAS_RAMFV
+    err = KeyStoreEntropyPool_refill();
+    ASSERT_EQ_OS_ERR(OS_SUCCESS, err);
+    testBackendFeatures(hKeystoreRamFV1, hKeystoreRamFV2, hCrypto);
+    // Test detection of corrupted key data in the RamFV buffer
+    keyStoreChecksumTests(hKeystoreRamFV1, corruptRamFV1);
+    // Test images of the RamFV buffer
+    keyStoreRamFVImageTests(hKeystoreRamFV1, keystoreRam1Buf,
+                            sizeof(keystoreRam1Buf), hFs);
+    KeyStoreTrace_dump("RamFVFeatures");
+    // Test RamFV keystores of many more keys on their own buffer
+    keyStoreRamFVScaleTests();
+    KeyStoreTrace_dump("RamFVScale");
+#endif
+#if KeyStoreStatic_HAS_FILE && KeyStoreStatic_HAS_RAMFV
+    // Test RamFV hot tier in front of File cold tier
+    keyStoreTieredTests(hKeystoreRamFV2, KeyStore_Config_RAM_NUM_ELEMENTS,
+                        hKeystoreFile2);
+    KeyStoreTrace_dump("FileRamFVFeatures");
+#endif
+    // Test the real-time keystore, in front of a KeystoreFile if there is one
+#if KeyStoreStatic_HAS_FILE
+    keyStoreRealtimeTests(hKeystoreFile2);
+#else
+    keyStoreRealtimeTests(NULL);
+#endif
+    KeyStoreTrace_dump("Realtime");
+
+#if defined(KeyStoreBenchmark_Config_ENABLED)
+    // Benchmarks, only run on request as they take long and their results
+    // depend on the machine
+#if KeyStoreStatic_HAS_FILE
+    benchmarkBackendFeatures(hKeystoreFile1, hKeystoreFile2, hCrypto, "File");
+    keyStoreManagerBenchmark(hFs, hCrypto);
+#endif
+#if KeyStoreStatic_HAS_RAMFV
+    benchmarkBackendFeatures(hKeystoreRamFV1, hKeystoreRamFV2, hCrypto,
+                             "RamFV");
+    keyStoreRamFVScaleBenchmark();
+#endif
+#if KeyStoreStatic_HAS_FILE && KeyStoreStatic_HAS_RAMFV
+    keyStoreTieredBenchmark(hKeystoreRamFV2, KeyStore_Config_RAM_NUM_ELEMENTS,
+                            hKeystoreFile2);
+    // Compare booting the RamFV from an image against importing its keys
+    keyStoreRamFVImageBenchmark(hKeystoreRamFV1, keystoreRam1Buf,
+                                sizeof(keystoreRam1Buf), hFs, hKeystoreFile1);
+#endif
+    // Compare the worst case latency of the real-time keystore to the
+    // backends
+#if KeyStoreStatic_HAS_FILE && KeyStoreStatic_HAS_RAMFV
+    keyStoreRealtimeBenchmark(hKeystoreRamFV2, KeyStore_Config_RAM_NUM_ELEMENTS,
+                              hKeystoreFile2);
+#elif KeyStoreStatic_HAS_FILE
+    keyStoreRealtimeBenchmark(NULL, 0, hKeystoreFile2);
+#else
+    keyStoreRealtimeBenchmark(hKeystoreRamFV2, KeyStore_Config_RAM_NUM_ELEMENTS,
+                              NULL);
+#endif
+    // Benchmarks independent of the backend
+    keyStoreCipherPoolBenchmark(hCrypto);
+    keyStoreAESLanesBenchmark(hCrypto);
+    keyStoreCrc32cBenchmark();
+    KeyStoreTrace_dump("Benchmarks");
+#endif
 
     // Cleanup
+#if KeyStoreStatic_HAS_FILE
     OS_Keystore_free(hKeystoreFile1);
     OS_Keystore_free(hKeystoreFile2);
+#endif
+#if KeyStoreStatic_HAS_RAMFV
     OS_Keystore_free(hKeystoreRamFV1);
     OS_Keystore_free(hKeystoreRamFV2);
+#endif
     OS_Crypto_free(hCrypto);
     OS_FileSystem_unmount(hFs);
     OS_FileSystem_free(hFs);
@@ -0,0 +1,71 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file camkes.h
+ *
+ * @brief interfaces the CAmkES glue provides to the test component, served
+ *        by the shims of the host build
+ *
+ * storage_rpc and storage_port stand in for the RamDisk, entropy_rpc and
+ * entropy_port for the EntropySource.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+extern void* storage_port;
+extern void* entropy_port;
+
+OS_Error_t
+storage_rpc_write(
+    off_t   offset,
+    size_t  size,
+    size_t* written);
+
+OS_Error_t
+storage_rpc_read(
+    off_t   offset,
+    size_t  size,
+    size_t* read);
+
+OS_Error_t
+storage_rpc_erase(
+    off_t   offset,
+    off_t   size,
+    off_t*  erased);
+
+OS_Error_t
+storage_rpc_getSize(
+    off_t*  size);
+
+OS_Error_t
+storage_rpc_getBlockSize(
+    size_t* blockSize);
+
+OS_Error_t
+storage_rpc_getState(
+    uint32_t* flags);
+
+size_t
+entropy_rpc_read(
+    const size_t len);
+
+/**
+ * Entry point of the test component, called by main() of the host build.
+ */
+int run(
+    void);
+
+///@}
@@ -0,0 +1,52 @@
+/**
+ * @addtogroup KeyStore_Tests
+ * @{
+ *
+ * @file sel4bench.h
+ *
+ * @brief cycle counter of the host, in place of the one of libsel4bench
+ *
+ * On x86 the time stamp counter is read, elsewhere the monotonic clock in
+ * nanoseconds is used, so results are comparable between runs on the same
+ * host only.
+ *
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+typedef uint64_t ccnt_t;
+
+static inline void
+sel4bench_init(
+    void)
+{
+}
+
+static inline ccnt_t
+sel4bench_get_cycle_count(
+    void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (ccnt_t) now.tv_sec * 1000000000u + (ccnt_t) now.tv_nsec;
+#endif
+}
+
+///@}
@@ -0,0 +1,38 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "OS_Dataport.h"
+#include "lib_debug/Debug.h"
+
+#include <camkes.h>
+
+#include <stdio.h>
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t portBuf[OS_DATAPORT_DEFAULT_SIZE];
+
+/* Public variables ----------------------------------------------------------*/
+void* entropy_port = portBuf;
+
+/* Public functions -----------------------------------------------------------*/
+size_t
+entropy_rpc_read(
+    const size_t len)
+{
+    static FILE* urandom;
+    size_t n = (len < sizeof(portBuf)) ? len : sizeof(portBuf);
+
+    if ((NULL == urandom) && (NULL == (urandom = fopen("/dev/urandom", "rb"))))
+    {
+        Debug_LOG_ERROR("Opening /dev/urandom failed");
+        return 0;
+    }
+
+    return fread(portBuf, 1, n, urandom);
+}
@@ -0,0 +1,18 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include <camkes.h>
+
+/* Public functions -----------------------------------------------------------*/
+int main(
+    void)
+{
+    // A failing test aborts, so getting back here means success
+    return run();
+}
@@ -0,0 +1,192 @@
+/**
+ * Copyright (C) 2024, HENSOLDT Cyber GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "OS_Dataport.h"
+#include "lib_debug/Debug.h"
+
+#include <camkes.h>
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Defines -------------------------------------------------------------------*/
+// If set in the environment, the storage is kept in this file instead of
+// memory, so it can be inspected after a run
+#define STORAGE_FILE_ENV    "KEYSTORE_HOST_STORAGE_FILE"
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t portBuf[OS_DATAPORT_DEFAULT_SIZE];
+static uint8_t* storage;
+
+/* Public variables ----------------------------------------------------------*/
+void* storage_port = portBuf;
+
+/* Private functions ---------------------------------------------------------*/
+// Maps the storage on first use, it reads as zero like a fresh RamDisk
+static OS_Error_t
+getStorage(
+    void)
+{
+    const char* fileName;
+    int fd;
+
+    if (storage != NULL)
+    {
+        return OS_SUCCESS;
+    }
+
+    if (NULL == (fileName = getenv(STORAGE_FILE_ENV)))
+    {
+        if (NULL == (storage = calloc(1, KeyStoreHost_STORAGE_SIZE)))
+        {
+            return OS_ERROR_INSUFFICIENT_SPACE;
+        }
+        return OS_SUCCESS;
+    }
+
+    if ((fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0600)) < 0)
+    {
+        Debug_LOG_ERROR("Opening '%s' failed", fileName);
+        return OS_ERROR_GENERIC;
+    }
+    if (ftruncate(fd, KeyStoreHost_STORAGE_SIZE) != 0)
+    {
+        Debug_LOG_ERROR("Resizing '%s' failed", fileName);
+        close(fd);
+        return OS_ERROR_GENERIC;
+    }
+    storage = mmap(NULL, KeyStoreHost_STORAGE_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == storage)
+    {
+        Debug_LOG_ERROR("Mapping '%s' failed", fileName);
+        storage = NULL;
+        return OS_ERROR_GENERIC;
+    }
+
+    return OS_SUCCESS;
+}
+
+static bool
+isInRange(
+    off_t   offset,
+    off_t   size)
+{
+    return (offset >= 0) && (size >= 0)
+           && (size <= (off_t) KeyStoreHost_STORAGE_SIZE)
+           && (offset <= (off_t) KeyStoreHost_STORAGE_SIZE - size);
+}
+
+/* Public functions -----------------------------------------------------------*/
+OS_Error_t
+storage_rpc_write(
+    off_t   offset,
+    size_t  size,
+    size_t* written)
+{
+    OS_Error_t err;
+
+    *written = 0;
+
+    if ((size > sizeof(portBuf)) || !isInRange(offset, (off_t) size))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+    if ((err = getStorage()) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    memcpy(storage + offset, portBuf, size);
+    *written = size;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+storage_rpc_read(
+    off_t   offset,
+    size_t  size,
+    size_t* read)
+{
+    OS_Error_t err;
+
+    *read = 0;
+
+    if ((size > sizeof(portBuf)) || !isInRange(offset, (off_t) size))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+    if ((err = getStorage()) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    memcpy(portBuf, storage + offset, size);
+    *read = size;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+storage_rpc_erase(
+    off_t   offset,
+    off_t   size,
+    off_t*  erased)
+{
+    OS_Error_t err;
+
+    *erased = 0;
+
+    if (!isInRange(offset, size))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+    if ((err = getStorage()) != OS_SUCCESS)
+    {
+        return err;
+    }
+
+    memset(storage + offset, 0xFF, (size_t) size);
+    *erased = size;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+storage_rpc_getSize(
+    off_t*  size)
+{
+    *size = KeyStoreHost_STORAGE_SIZE;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+storage_rpc_getBlockSize(
+    size_t* blockSize)
+{
+    *blockSize = 1;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+storage_rpc_getState(
+    uint32_t* flags)
+{
+    *flags = 0;
+
+    return OS_SUCCESS;
+}
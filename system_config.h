@@ -32,3 +32,69 @@
 // Memory
 //-----------------------------------------------------------------------------
 #define Memory_Config_USE_STDLIB_ALLOC
+
+
+//-----------------------------------------------------------------------------
+// Keystore test
+//-----------------------------------------------------------------------------
+// Run the benchmarks after the tests; they take long and their results depend
+// on the machine, so they are off for functional runs
+// #define KeyStoreBenchmark_Config_ENABLED
+// Report benchmark results as JSON lines, which tools/benchmark_compare.py
+// can check against a baseline
+// #define KeyStoreBenchmark_Config_JSON_OUTPUT
+
+// Number of keys each OS_KeystoreRamFV instance of the test can hold
+#define KeyStore_Config_RAM_NUM_ELEMENTS    10
+
+// Capacity of the largest OS_KeystoreRamFV of the scaling test, its buffer
+// is static; raise it where memory allows, e.g. in the host build
+#if !defined(KeyStore_Config_SCALE_NUM_ELEMENTS)
+#define KeyStore_Config_SCALE_NUM_ELEMENTS  512
+#endif
+// Agreed bounds of the scaling benchmark: how much of the growth of a search
+// linear in the number of keys storing may show while the keystore fills up,
+// in percent, and how many times slower the last round of a churn at
+// constant fill level may get than the first
+#define KeyStore_Config_SCALE_MAX_GROWTH_PERCENT    50
+#define KeyStore_Config_SCALE_MAX_CHURN_GROWTH      4
+
+// Real-time keystore of keyStoreRealtime.h: number of slots (a power of
+// two), maximum key size and number of slots every operation inspects; the
+// last two bound the cost of every operation
+#define KeyStore_Config_RT_NUM_KEYS         64
+#define KeyStore_Config_RT_MAX_KEY_SIZE     64
+#define KeyStore_Config_RT_MAX_PROBES       8
+// Number of operations of the latency test of the real-time keystore
+#if !defined(KeyStore_Config_RT_NUM_OPS)
+#define KeyStore_Config_RT_NUM_OPS          1000000
+#endif
+// If set, the latency test fails if a single operation of the real-time
+// keystore takes more cycles than this
+// #define KeyStore_Config_RT_MAX_CYCLES    20000
+
+// Limits of the keystore backends
+#define KeyStore_Config_MAX_KEY_SIZE        2080
+#define KeyStore_Config_MAX_NAME_LEN        15
+
+// Backends for KeyStore_Config_STATIC_BACKEND
+#define KeyStore_BACKEND_FILE               1
+#define KeyStore_BACKEND_RAMFV              2
+
+// If set to one of the backends above, the test is built for that backend
+// only, see keyStoreStatic.h; usually set by the build with
+// KEYSTORE_STATIC_BACKEND
+// #define KeyStore_Config_STATIC_BACKEND   KeyStore_BACKEND_RAMFV
+
+// Trace the phases of keystore operations, see keyStoreTrace.h; the test
+// prints a breakdown per operation for every scenario. Set by the build with
+// KEYSTORE_TRACE, which also links the wrappers setting the trace points
+// #define KeyStoreTrace_Config_ENABLED
+// Count the calls of the allocator, see keyStoreAlloc.h; set by the build with
+// KEYSTORE_COUNT_ALLOCS, the real-time tests check for allocations then
+// #define KeyStoreAlloc_Config_ENABLED
+// Print the traced events in the Chrome trace event format instead, for
+// tools/trace_to_chrome.py
+// #define KeyStoreTrace_Config_CHROME_FORMAT
+// Number of events kept per scenario in the Chrome trace event format
+// #define KeyStoreTrace_Config_MAX_EVENTS  1024
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+#
+# Compare keystore benchmark results of a test run against a baseline
+#
+# Copyright (C) 2024, HENSOLDT Cyber GmbH
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+
+"""
+Parses the logs of test runs for the JSON lines printed by the test component
+when KeyStoreBenchmark_Config_ENABLED and KeyStoreBenchmark_Config_JSON_OUTPUT
+are set and compares the cycles per operation of every measurement against a
+baseline. Single runs in QEMU are noisy, so the median over all logs given is
+compared. Exits with a non-zero code if a measurement is slower than the
+baseline by more than its threshold, if a measurement of the baseline is
+missing in the logs, or if the baseline has no measurements at all, as
+nothing could ever fail then.
+
+The baseline holds a default threshold and may override it per measurement
+with a "threshold" next to its "cyclesPerOp".
+
+With --update, the baseline is (re-)written from the logs instead, keeping
+the thresholds of measurements already in it.
+"""
+
+import argparse
+import json
+import os
+import re
+import statistics
+import sys
+
+JSON_TAG = "KEYSTORE_BENCHMARK"
+JSON_LINE = re.compile(JSON_TAG + r" (\{.*\})")
+DEFAULT_THRESHOLD = 0.25
+
+
+def metric_key(entry):
+    return "{}/{}/{}".format(entry["op"], entry["backend"], entry["keySize"])
+
+
+def parse_log(path):
+    results = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            m = JSON_LINE.search(line)
+            if not m:
+                continue
+            try:
+                entry = json.loads(m.group(1))
+            except ValueError:
+                print("WARNING: ignoring malformed line: {}".format(
+                    line.rstrip()))
+                continue
+            # Operations measured more than once (e.g. once per keystore
+            # instance) are compared on their slowest run
+            key = metric_key(entry)
+            if key not in results \
+                    or entry["cyclesPerOp"] > results[key]["cyclesPerOp"]:
+                results[key] = entry
+    return results
+
+
+def merge_runs(runs):
+    """Returns the median cycles per operation of every measurement."""
+    samples = {}
+    for results in runs:
+        for key, entry in results.items():
+            samples.setdefault(key, []).append(entry["cyclesPerOp"])
+    return {k: statistics.median(v) for k, v in samples.items()}
+
+
+def compare(results, baseline, threshold):
+    failed = False
+    for key, base in sorted(baseline["metrics"].items()):
+        if key not in results:
+            print("MISSING     {}".format(key))
+            failed = True
+            continue
+        current = results[key]
+        limit = base["cyclesPerOp"] * (1.0 + base.get("threshold", threshold))
+        change = (current / base["cyclesPerOp"] - 1.0) * 100 \
+            if base["cyclesPerOp"] else 0.0
+        verdict = "REGRESSION" if current > limit else "ok"
+        failed |= current > limit
+        print("{:<11} {}: {:g} cycles/op (baseline {}, {:+.1f}%)".format(
+            verdict, key, current, base["cyclesPerOp"], change))
+    for key in sorted(set(results) - set(baseline["metrics"])):
+        print("NEW         {}: {:g} cycles/op".format(key, results[key]))
+    return not failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--log", required=True, action="append",
+                        help="log of a test run, give it once per run")
+    parser.add_argument("--baseline", required=True,
+                        help="JSON file with the baseline")
+    parser.add_argument("--threshold", type=float,
+                        help="allowed slowdown, e.g. 0.25 for 25%%; "
+                             "overrides the default threshold of the "
+                             "baseline")
+    parser.add_argument("--update", action="store_true",
+                        help="write the results of the logs as new baseline")
+    args = parser.parse_args()
+
+    runs = []
+    for path in args.log:
+        results = parse_log(path)
+        if not results:
+            print("ERROR: no benchmark results found in {}".format(path))
+            return 1
+        runs.append(results)
+    results = merge_runs(runs)
+
+    baseline = {"threshold": DEFAULT_THRESHOLD, "metrics": {}}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    if args.update:
+        metrics = {}
+        for key, cycles in results.items():
+            metrics[key] = {"cyclesPerOp": cycles}
+            old = baseline["metrics"].get(key, {})
+            if "threshold" in old:
+                metrics[key]["threshold"] = old["threshold"]
+        baseline["metrics"] = metrics
+        if args.threshold is not None:
+            baseline["threshold"] = args.threshold
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=4, sort_keys=True)
+            f.write("\n")
+        print("Baseline with {} metrics from {} runs written to {}".format(
+            len(results), len(runs), args.baseline))
+        return 0
+
+    if not baseline["metrics"]:
+        print("ERROR: {} holds no measurements, record it with "
+              "--update".format(args.baseline))
+        return 1
+    threshold = args.threshold if args.threshold is not None \
+        else baseline["threshold"]
+
+    return 0 if compare(results, baseline, threshold) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
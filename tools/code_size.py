@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+#
+# Report the code size of the keystore within a test component binary
+#
+# Copyright (C) 2024, HENSOLDT Cyber GmbH
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+
+"""
+Lists the functions of an ELF file with nm and sums up the sizes of those
+belonging to the keystore backends, to the keystore test and to the whole
+binary, so builds with and without KEYSTORE_STATIC_BACKEND can be compared.
+"""
+
+import argparse
+import collections
+import json
+import subprocess
+import sys
+
+GROUPS = [
+    ("OS_KeystoreFile", ("OS_KeystoreFile_", "KeystoreFile_")),
+    ("OS_KeystoreRamFV", ("OS_KeystoreRamFV_", "KeystoreRamFV_")),
+    ("OS_Keystore", ("OS_Keystore_",)),
+    ("Test", ("KeyStore", "keyStore", "testKeyStore", "test")),
+]
+
+
+def group_of(symbol):
+    for name, prefixes in GROUPS:
+        if symbol.startswith(prefixes):
+            return name
+    return None
+
+
+def read_functions(nm, elf):
+    out = subprocess.check_output(
+        [nm, "--print-size", "--radix=d", "--defined-only", elf],
+        universal_newlines=True)
+    for line in out.splitlines():
+        fields = line.split()
+        # Only symbols with a size, in the text section
+        if len(fields) == 4 and fields[2] in "tTwW":
+            yield fields[3], int(fields[1])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--elf", required=True,
+                        help="binary of the test component")
+    parser.add_argument("--nm", default="nm",
+                        help="nm of the toolchain the binary was built with")
+    parser.add_argument("--json", action="store_true",
+                        help="print the result as a JSON object")
+    args = parser.parse_args()
+
+    sizes = collections.OrderedDict((name, 0) for name, _ in GROUPS)
+    total = 0
+    for symbol, size in read_functions(args.nm, args.elf):
+        total += size
+        group = group_of(symbol)
+        if group:
+            sizes[group] += size
+    sizes["Total"] = total
+
+    if args.json:
+        print(json.dumps(sizes))
+    else:
+        for name, size in sizes.items():
+            print("{:<20} {:>10} bytes".format(name, size))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+#
+# Collect keystore trace events of a test run into a Chrome trace file
+#
+# Copyright (C) 2024, HENSOLDT Cyber GmbH
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+
+"""
+Parses the log of a test run for the trace events printed by the test
+component when KeyStoreTrace_Config_ENABLED and
+KeyStoreTrace_Config_CHROME_FORMAT are set, and writes them to a JSON file
+that chrome://tracing and Perfetto can open. Every test scenario is shown as
+a thread of its own.
+
+The timestamps of the events are in cycles; pass the clock rate of the
+target with --cycles-per-us to get the time axis in microseconds.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+JSON_TAG = "KEYSTORE_TRACE"
+JSON_LINE = re.compile(JSON_TAG + r" (\{.*\})")
+
+
+def parse_log(path, cycles_per_us):
+    events = []
+    threads = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            m = JSON_LINE.search(line)
+            if not m:
+                continue
+            try:
+                event = json.loads(m.group(1))
+            except ValueError:
+                print("WARNING: ignoring malformed line: {}".format(
+                    line.rstrip()))
+                continue
+            scenario = event.get("args", {}).get("scenario", "")
+            event["tid"] = threads.setdefault(scenario, len(threads) + 1)
+            event["ts"] = event["ts"] / cycles_per_us
+            event["dur"] = event["dur"] / cycles_per_us
+            events.append(event)
+
+    # Name the threads after the scenarios
+    for scenario, tid in threads.items():
+        events.append({"name": "thread_name", "ph": "M", "pid": 1,
+                       "tid": tid, "args": {"name": scenario}})
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--log", required=True,
+                        help="log of the test run")
+    parser.add_argument("--output", required=True,
+                        help="Chrome trace file to write")
+    parser.add_argument("--cycles-per-us", type=float, default=1.0,
+                        help="cycles per microsecond of the target")
+    args = parser.parse_args()
+
+    events = parse_log(args.log, args.cycles_per_us)
+    if not events:
+        print("ERROR: no trace events found in {}".format(args.log))
+        return 1
+
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": events}, f)
+        f.write("\n")
+    print("{} events written to {}".format(len(events), args.output))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())